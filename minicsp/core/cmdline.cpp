@@ -28,6 +28,8 @@ namespace cmdline {
   using namespace std;
   map<string, BranchHeuristic> varbranch;
   map<string, ValBranchHeuristic> valbranch;
+  map<string, LearntPolicy> learntpolicy;
+  map<string, RestartPolicy> restartpolicy;
 
   void fillbranch() {
     varbranch["VSIDS"] = VAR_VSIDS;
@@ -37,7 +39,18 @@ namespace cmdline {
 
     valbranch["VSIDS"] = VAL_VSIDS;
     valbranch["lex"] = VAL_LEX;
+    valbranch["min"] = VAL_LEX;
+    valbranch["max"] = VAL_MAX;
+    valbranch["median"] = VAL_MEDIAN;
     valbranch["bisect"] = VAL_BISECT;
+    valbranch["reverse-bisect"] = VAL_REVERSE_BISECT;
+
+    learntpolicy["activity"] = LEARNTS_ACTIVITY;
+    learntpolicy["lbd"] = LEARNTS_LBD;
+
+    restartpolicy["luby"] = RESTART_LUBY;
+    restartpolicy["geometric"] = RESTART_GEOMETRIC;
+    restartpolicy["glucose"] = RESTART_GLUCOSE;
   }
 
   void parse_solver_options(Solver &s, arglist& args) {
@@ -47,17 +60,38 @@ namespace cmdline {
     s.debugclauses = has_option(args, "--debugclauses");
 #endif
     s.restarting = !has_option(args, "--norestart");
+    s.trail_backtrackable = !has_option(args, "--bt-snapshot");
 
     pair<bool, int> has_base_restart =
       has_argoption<int>(args, "--base-restart");
     if( has_base_restart.first )
       s.restart_first = has_base_restart.second;
 
+    pair<bool, double> has_restart_inc =
+      has_argoption<double>(args, "--restart-inc");
+    if( has_restart_inc.first )
+      s.restart_inc = has_restart_inc.second;
+
+    pair<bool, double> has_restart_K =
+      has_argoption<double>(args, "--restart-K");
+    if( has_restart_K.first )
+      s.restart_K = has_restart_K.second;
+
+    pair<bool, double> has_restart_R =
+      has_argoption<double>(args, "--restart-R");
+    if( has_restart_R.first )
+      s.restart_R = has_restart_R.second;
+
     pair<bool, int> has_verbosity =
       has_argoption<int>(args, "--verbosity");
     if( has_verbosity.first )
       s.verbosity = has_verbosity.second;
 
+    pair<bool, int> has_lazy_threshold =
+      has_argoption<int>(args, "--lazy-threshold");
+    if( has_lazy_threshold.first )
+      s.lazy_threshold = has_lazy_threshold.second;
+
     fillbranch();
     pair<bool, string> has_varbranch =
       has_argoption<string>(args, "--varbranch");
@@ -80,6 +114,38 @@ namespace cmdline {
       }
       s.valbranch = valbranch[has_valbranch.second];
     }
+
+    pair<bool, string> has_learntpolicy =
+      has_argoption<string>(args, "--learnt-policy");
+    if( has_learntpolicy.first ) {
+      if( learntpolicy.find(has_learntpolicy.second) == learntpolicy.end() ) {
+        string msg = "Unknown learnt clause policy "
+          + has_learntpolicy.second;
+        throw cmd_line_error(msg);
+      }
+      s.learnt_policy = learntpolicy[has_learntpolicy.second];
+    }
+
+    pair<bool, string> has_restartpolicy =
+      has_argoption<string>(args, "--restart");
+    if( has_restartpolicy.first ) {
+      if( restartpolicy.find(has_restartpolicy.second) == restartpolicy.end() ) {
+        string msg = "Unknown restart policy "
+          + has_restartpolicy.second;
+        throw cmd_line_error(msg);
+      }
+      s.restart_policy = restartpolicy[has_restartpolicy.second];
+    }
+
+    pair<bool, int> has_core_lbd =
+      has_argoption<int>(args, "--core-lbd");
+    if( has_core_lbd.first )
+      s.core_lbd = has_core_lbd.second;
+
+    pair<bool, int> has_tier2_lbd =
+      has_argoption<int>(args, "--tier2-lbd");
+    if( has_tier2_lbd.first )
+      s.tier2_lbd = has_tier2_lbd.second;
   }
 } // namespace cmdline
 
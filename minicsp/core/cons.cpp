@@ -568,9 +568,7 @@ namespace leq {
     if( _y.max(s) + _c < _x.min(s) ) { // failure
       pushifdef(_reason, _x.r_min(s));
       pushifdef(_reason, _y.r_leq( s, _x.min(s) - _c - 1));
-      Clause *r = Clause_new(_reason);
-      s.addInactiveClause(r);
-      return r;
+      return s.addInactiveClause(_reason);
     }
 
     if( _y.min(s) + _c < _x.min(s) ) {
@@ -894,6 +892,13 @@ class cons_abs : public cons {
   cspvar _x, _y;
   int _c;
   vec<Lit> _reason; // cache to avoid the cost of allocation
+  vec<Lit> _sweep; // same, for support_x/y()
+
+  // the bounds or assignment of a lazy var changed, which may have
+  // pruned any of its values: look for the support of every value
+  // of the other var
+  Clause *support_x(Solver &s);
+  Clause *support_y(Solver &s);
 public:
   cons_abs(Solver &s,
            cspvar x, cspvar y, int c) :
@@ -902,7 +907,8 @@ public:
     using std::max;
     using std::min;
 
-    // we only wake on dom here, otherwise it is too complicated
+    // we only wake on dom here, otherwise it is too complicated. A
+    // lazy var also wakes us on its bounds, see support_x/y()
     s.wake_on_dom(x, this);
     s.wake_on_dom(y, this);
     _reason.capacity(3); _reason.growTo(2, lit_Undef);
@@ -939,6 +945,8 @@ public:
 Clause* cons_abs::wake(Solver &s, Lit event)
 {
   domevent e = s.event(event);
+  if( e.type != domevent::NEQ )
+    return e.x == _x ? support_y(s) : support_x(s);
   _reason[0] = ~event;
 
   if( e.x == _x ) {
@@ -968,6 +976,31 @@ Clause* cons_abs::wake(Solver &s, Lit event)
   return 0L;
 }
 
+Clause *cons_abs::support_x(Solver &s)
+{
+  for(int i = _x.min(s), iend = _x.max(s)+1; i != iend; ++i) {
+    if( !_x.indomain(s, i) || _y.indomain(s, abs(i)-_c) ) continue;
+    _sweep.clear();
+    pushifdef(_sweep, _y.r_neq(s, abs(i)-_c));
+    DO_OR_RETURN(_x.removef(s, i, _sweep));
+  }
+  return 0L;
+}
+
+Clause *cons_abs::support_y(Solver &s)
+{
+  for(int i = _y.min(s), iend = _y.max(s)+1; i != iend; ++i) {
+    if( !_y.indomain(s, i) || _x.indomain(s, i+_c) ||
+        _x.indomain(s, -i-_c) ) continue;
+    _sweep.clear();
+    pushifdef(_sweep, _x.r_neq(s, i+_c));
+    if( i+_c != 0 )
+      pushifdef(_sweep, _x.r_neq(s, -i-_c));
+    DO_OR_RETURN(_y.removef(s, i, _sweep));
+  }
+  return 0L;
+}
+
 void cons_abs::clone(Solver &other)
 {
   cons *con = new cons_abs(other, _x, _y, _c);
@@ -1008,6 +1041,65 @@ void post_abs(Solver& s, cspvar v1, cspvar v2, int c)
   s.addConstraint(con);
 }
 
+/* Helpers for deferred explanations. A deferred explanation is built
+   long after the pruning, so it must only use literals that were
+   already true when the pruned literal was enqueued, i.e., that are
+   earlier in the trail. t is the trail position of that literal.
+ */
+namespace deferred {
+  // the min of x when the trail had t literals. x must be eager, so
+  // that every bound has its x <= d literal
+  int min_at(Solver &s, cspvar x, int t)
+  {
+    int b = x.min(s), omin = x.omin(s);
+    while( b > omin && s.varTrailPos(x.leqiUnsafe(s, b-1)) >= t )
+      --b;
+    return b;
+  }
+
+  // the max of x when the trail had t literals, x eager
+  int max_at(Solver &s, cspvar x, int t)
+  {
+    int b = x.max(s), omax = x.omax(s);
+    while( b < omax && s.varTrailPos(x.leqiUnsafe(s, b)) >= t )
+      ++b;
+    return b;
+  }
+
+  // the value of v when the trail had t literals
+  lbool value_at(Solver &s, Var v, int t)
+  {
+    if( s.value(v) == l_Undef || s.varTrailPos(v) >= t ) return l_Undef;
+    return s.value(v);
+  }
+
+  // a literal that was false when the trail had t literals and
+  // excludes d from x, or lit_Undef. x eager. A bound may pass d
+  // before x = d is set false
+  Lit removed_at(Solver &s, cspvar x, int d, int t)
+  {
+    if( value_at(s, x.eqiUnsafe(s, d), t) == l_False )
+      return Lit(x.eqiUnsafe(s, d));
+    if( d < x.omax(s) && value_at(s, x.leqiUnsafe(s, d), t) == l_False )
+      return Lit(x.leqiUnsafe(s, d));
+    if( d > x.omin(s) && value_at(s, x.leqiUnsafe(s, d-1), t) == l_True )
+      return ~Lit(x.leqiUnsafe(s, d-1));
+    return lit_Undef;
+  }
+}
+
+// sort c from position from on and remove duplicates, e.g., the bound
+// literals that lazy vars give for several values
+void unique_lits(vec<Lit>& c, int from)
+{
+  Lit *lits = c;
+  std::sort(lits + from, lits + c.size());
+  int d = from;
+  for(int q = from; q != c.size(); ++q)
+    if( q == from || c[q] != c[q-1] ) c[d++] = c[q];
+  c.shrink(c.size() - d);
+}
+
 /* cons_lin_le
 
    N-ary linear inequality
@@ -1017,32 +1109,67 @@ void post_abs(Solver& s, cspvar v1, cspvar v2, int c)
    The template parameter N is used to tell the compiler to create
    optimized versions for small N. When N = 0, it uses the generic
    loop, otherwise constant propagation will make it a fixed loop.
+
+   The minimum of the lhs is kept in backtrackable memory, along with
+   the bound of each var that it was computed from. A bound change
+   wakes the constraint with the index of the var as advice and
+   updates the minimum in O(1). Pruning happens in propagate(), once
+   per propagation round, and only if the slack is smaller than the
+   largest w[i]*(omax-omin), since otherwise nothing can be pruned.
+
+   If all vars are eager, the constraint is also the deferred
+   explanation of its prunings, since the event of the pruned literal
+   says which term it bounds. The reason is built from the bounds
+   that held when the literal was enqueued, and each of them is then
+   weakened as far as the slack allows.
 */
 template<size_t N>
-class cons_lin_le : public cons {
+class cons_lin_le : public cons, public explainer {
   int _c;
+  bool _deferred;   // no lazy vars, prune with deferred explanations
 
   vec<Lit> _ps;
   size_t n;
   vector<int> pspos;
+  vector<int> _at;  // the bounds used by explain_at
+  int64_t maxspan;  // max |w[i]|*(omax-omin) over all i
+  btptr lb_ptr;     // int64_t: c + sum vmin(i)
+  btptr bound_ptr;  // int[n]: the bound of var i counted in lb
   pair<int, cspvar> _vars[0];
 
+  // the bound of x that gives its minimum contribution with coeff w:
+  // x.min() if w>0, x.max() if w<0
+  int vbound(Solver &s, int w, cspvar x);
   // computes the minimum contribution of var x with coeff w:
   // w*x.min() if w>0, w*x.max() if w<0
-  int vmin(Solver &s, int w, cspvar x);
+  int64_t vmin(Solver &s, int w, cspvar x);
   // describe the domain of x to use in the reason for whatever we do:
   // 'x>=x.min()' if w>0, 'x<=x.max()' if w<0
-  Lit litreason(Solver &s, int lb, int w, cspvar x);
+  Lit litreason(Solver &s, int w, cspvar x);
+  // put the reason for the current lb in _ps, skipping lit_Undef
+  void fillreason(Solver &s);
+  // append to c a reason for base + sum w[j]*bound(j) > 0 over all
+  // j != skip, using the bounds at trail position t, weakened as far
+  // as possible
+  void explain_at(Solver &s, size_t skip, int64_t base, int t,
+                  vec<Lit>& c);
+  // the reason for the current lb > 0, as a clause
+  Clause *fail(Solver &s);
 public:
   cons_lin_le(Solver &s,
               vector< pair<int, cspvar> > const& vars,
               int c);
 
-  Clause *wake(Solver& s, Lit p);
+  Clause *wake_advised(Solver& s, Lit p, void *advice);
+  Clause *propagate(Solver& s);
   void clone(Solver& other);
   ostream& print(Solver &s, ostream& os) const;
   ostream& printstate(Solver& s, ostream& os) const;
 
+  void explain(Solver& s, Lit p, vec<Lit>& c);
+  void use() {}
+  void release() {}
+
   void dispose() { this->~cons_lin_le(); free(this); }
 };
 
@@ -1057,15 +1184,20 @@ cons *new_cons_lin_le(Solver &s,
 }
 
 template<size_t N>
-int cons_lin_le<N>::vmin(Solver &s, int w, cspvar x)
+int cons_lin_le<N>::vbound(Solver &s, int w, cspvar x)
 {
-  if( w > 0 ) return w*x.min(s);
-  else return w*x.max(s);
+  if( w > 0 ) return x.min(s);
+  else return x.max(s);
 }
 
 template<size_t N>
-Lit cons_lin_le<N>::litreason(Solver &s, int lb,
-                              int w, cspvar x)
+int64_t cons_lin_le<N>::vmin(Solver &s, int w, cspvar x)
+{
+  return int64_t(w)*vbound(s, w, x);
+}
+
+template<size_t N>
+Lit cons_lin_le<N>::litreason(Solver &s, int w, cspvar x)
 {
   if( w > 0 )
     return x.r_geq(s, x.min(s));
@@ -1073,92 +1205,194 @@ Lit cons_lin_le<N>::litreason(Solver &s, int lb,
     return x.r_leq(s, x.max(s));
 }
 
+template<size_t N>
+void cons_lin_le<N>::fillreason(Solver &s)
+{
+  _ps.clear();
+  for(size_t i = 0; i != n; ++i) {
+    Lit l = litreason(s, _vars[i].first, _vars[i].second);
+    pspos[i] = _ps.size();
+    if( toInt(l) >= 0 ) _ps.push(l);
+  }
+}
+
+template<size_t N>
+void cons_lin_le<N>::explain_at(Solver &s, size_t skip, int64_t base,
+                                int t, vec<Lit>& c)
+{
+  vector<int>& b = _at;
+  int64_t sum = base;
+  for(size_t j = 0; j != n; ++j) {
+    if( j == skip ) continue;
+    int w = _vars[j].first;
+    cspvar x = _vars[j].second;
+    b[j] = w > 0 ? deferred::min_at(s, x, t) : deferred::max_at(s, x, t);
+    sum += int64_t(w)*b[j];
+  }
+  assert(sum > 0);
+  int64_t excess = sum - 1;
+  for(size_t j = 0; j != n; ++j) {
+    if( j == skip ) continue;
+    int w = _vars[j].first;
+    cspvar x = _vars[j].second;
+    if( w > 0 ) {
+      int64_t steps = std::min(excess/w, int64_t(b[j] - x.omin(s)));
+      b[j] -= steps;
+      excess -= steps*w;
+      if( b[j] > x.omin(s) )
+        c.push( x.r_geq(s, b[j]) );
+    } else {
+      int64_t steps = std::min(excess/(-w), int64_t(x.omax(s) - b[j]));
+      b[j] += steps;
+      excess += steps*w;
+      if( b[j] < x.omax(s) )
+        c.push( x.r_leq(s, b[j]) );
+    }
+  }
+}
+
+template<size_t N>
+void cons_lin_le<N>::explain(Solver &s, Lit p, vec<Lit>& c)
+{
+  domevent pe = s.event(p);
+  size_t i = 0;
+  while( _vars[i].second.id() != pe.x.id() ) ++i;
+  int w = _vars[i].first;
+  // the contribution of term i if p were false
+  int64_t qmin;
+  if( pe.type == domevent::LEQ ) {
+    assert(w > 0);
+    qmin = int64_t(w)*(pe.d+1);
+  } else {
+    assert(pe.type == domevent::GEQ && w < 0);
+    qmin = int64_t(w)*(pe.d-1);
+  }
+  c.push(p);
+  explain_at(s, i, _c + qmin, s.varTrailPos(p), c);
+}
+
+template<size_t N>
+Clause *cons_lin_le<N>::fail(Solver &s)
+{
+  if( _deferred ) {
+    _ps.clear();
+    explain_at(s, n, _c, s.nAssigns(), _ps);
+  } else
+    fillreason(s);
+  return s.addInactiveClause(_ps);
+}
+
 template<size_t N>
 cons_lin_le<N>::cons_lin_le(Solver &s,
                             vector< pair<int, cspvar> > const& vars,
                             int c) :
-  _c(c)
+  _c(c), _deferred(true), maxspan(0)
 {
   assert(N == 0 || N == vars.size());
   n = vars.size();
-  int lb = _c;
+  pspos.resize(n);
+  _at.resize(n);
+  lb_ptr = s.alloc_backtrackable(sizeof(int64_t));
+  bound_ptr = s.alloc_backtrackable(n*sizeof(int));
+  int *bound = s.deref_array<int>(bound_ptr);
+  int64_t lb = _c;
   for(size_t i = 0; i != vars.size(); ++i) {
     _vars[i] = vars[i];
-    lb += vmin(s, _vars[i].first, _vars[i].second);
-    if( _vars[i].first > 0 )
-      s.wake_on_lb(_vars[i].second, this);
-    else
-      s.wake_on_ub(_vars[i].second, this);
+    int w = _vars[i].first;
+    cspvar x = _vars[i].second;
+    bound[i] = vbound(s, w, x);
+    lb += vmin(s, w, x);
+    maxspan = std::max(maxspan,
+                       std::abs(int64_t(w))*(x.omax(s) - x.omin(s)));
+    if( s.cspvarlazy(x) )
+      _deferred = false;
+    void *advice = reinterpret_cast<void*>(i+1);
+    if( w > 0 ) {
+      s.wake_on_lb(x, this, advice);
+      s.schedule_on_lb(x, this);
+    } else {
+      s.wake_on_ub(x, this, advice);
+      s.schedule_on_ub(x, this);
+    }
   }
+  s.deref<int64_t>(lb_ptr) = lb;
   if( lb > 0 ) throw unsat();
-  _ps.growTo(n, lit_Undef);
-  if( wake(s, lit_Undef) )
+  if( propagate(s) )
     throw unsat();
 }
 
 template<size_t N>
-Clause *cons_lin_le<N>::wake(Solver &s, Lit)
-{
-  pspos.clear();
-  pspos.resize(n);
-
-  int lb = _c;
-  size_t nl = 0;
-  for(size_t i = 0; i != n; ++i) {
-    int w = _vars[i].first;
-    cspvar x = _vars[i].second;
-    _ps[nl] = litreason(s, lb, w, x);
-    pspos[i] = nl;
-    if( toInt(_ps[nl]) >= 0 ) ++nl;
-    lb += vmin(s, w, x);
-  }
+Clause *cons_lin_le<N>::wake_advised(Solver &s, Lit, void *advice)
+{
+  size_t i = reinterpret_cast<size_t>(advice)-1;
+  int w = _vars[i].first;
+  int b = vbound(s, w, _vars[i].second);
+  int *bound = s.deref_array<int>(bound_ptr);
+  if( b == bound[i] ) return 0L;
+  int64_t& lb = s.deref_mut<int64_t>(lb_ptr);
+  lb += int64_t(w)*(b - bound[i]);
+  s.bt_write_array<int>(bound_ptr, i, b);
+  if( lb > 0 )
+    return fail(s);
+  return 0L;
+}
 
-  if( lb > 0 ) {
-    // shrink _ps to contruct the clause, then bring it back to its
-    // previous size
-    _ps.shrink(n - nl );
-    Clause *r = Clause_new(_ps);
-    _ps.growTo(n, lit_Undef);
-    s.addInactiveClause(r);
-    return r;
-  }
+template<size_t N>
+Clause *cons_lin_le<N>::propagate(Solver &s)
+{
+  int64_t lb = s.deref<int64_t>(lb_ptr);
+  if( lb > 0 )
+    return fail(s);
+  if( -lb >= maxspan )
+    return 0L;
 
-  _ps.shrink(n - nl );
+  bool filled = false;
   for(size_t i = 0; i != n; ++i) {
-    Lit l = _ps[pspos[i]];
     int w = _vars[i].first;
     cspvar x = _vars[i].second;
-    int gap = lb-vmin(s, w, x);
+    int64_t gap = lb-vmin(s, w, x);
     if( w > 0 ) {
-      int ibound = -gap/w;
-      if( litreason(s, lb, w, x) == lit_Undef ) {
+      // w*x <= -gap
+      int64_t ibound = -gap/w;
+      if( -gap < 0 && -gap % w ) --ibound;
+      if( ibound >= x.max(s) ) continue;
+      if( _deferred ) {
+        s.uncheckedEnqueueDeferred(Lit(x.leqiUnsafe(s, ibound)), this);
+        continue;
+      }
+      if( !filled ) { fillreason(s); filled = true; }
+      Lit l = litreason(s, w, x);
+      if( l == lit_Undef ) {
         _ps.push(x.e_leq(s, ibound));
-        x.setmax(s, ibound, _ps);
+        DO_OR_RETURN(x.setmax(s, ibound, _ps));
         _ps.pop();
       } else {
         _ps[pspos[i]] = x.e_leq(s, ibound);
-        x.setmax(s, ibound, _ps);
+        DO_OR_RETURN(x.setmax(s, ibound, _ps));
         _ps[pspos[i]] = l;
       }
     } else {
-      int ibound;
-      // rounding towards zero is weird
-      if( gap < 0 )
-        ibound = -gap/w;
-      else
-        ibound = -(gap-w-1)/w;
-      if( litreason(s, lb, w, x) == lit_Undef ) {
+      // -w*x >= gap
+      int64_t ibound = gap/(-w);
+      if( gap > 0 && gap % (-w) ) ++ibound;
+      if( ibound <= x.min(s) ) continue;
+      if( _deferred ) {
+        s.uncheckedEnqueueDeferred(~Lit(x.leqiUnsafe(s, ibound-1)), this);
+        continue;
+      }
+      if( !filled ) { fillreason(s); filled = true; }
+      Lit l = litreason(s, w, x);
+      if( l == lit_Undef ) {
         _ps.push(x.e_geq(s, ibound));
-        x.setmin(s, ibound, _ps);
+        DO_OR_RETURN(x.setmin(s, ibound, _ps));
         _ps.pop();
       } else {
         _ps[pspos[i]] = x.e_geq(s, ibound);
-        x.setmin(s, ibound, _ps);
+        DO_OR_RETURN(x.setmin(s, ibound, _ps));
         _ps[pspos[i]] = l;
       }
     }
   }
-  _ps.growTo(n, lit_Undef);
 
   return 0L;
 }
@@ -1607,6 +1841,19 @@ void post_lin_neq_iff_re(Solver &s,
    PseudoBoolean constraint
 
    sum_i weight[i]*var[i] >= lb
+
+   With w*v = w + |w|*(1-v) for w < 0, this is sum |w[i]|*l[i] >= lb'
+   over literals l[i], which are var[i] if w[i] > 0 and -var[i]
+   otherwise. The slack sum_{l[i] not false} |w[i]| - lb' is kept in
+   backtrackable memory and updated in O(1) when some l[i] becomes
+   false. Every unassigned l[i] with |w[i]| > slack is forced and, as
+   _svars is sorted by decreasing |w|, those are a prefix of it.
+   Nothing happens when the slack is at least the largest |w|, or when
+   some l[i] becomes true.
+
+   The constraint is the deferred explanation of the literals it
+   forces. The reason is the false literals with the largest weights
+   that leave too little slack for the forced literal to be false.
 */
 namespace pb {
   struct compare_abs_weights {
@@ -1617,21 +1864,34 @@ namespace pb {
   };
 }
 
-class cons_pb : public cons {
-  std::vector< std::pair<int, Var> > _posvars;
-  std::vector< std::pair<int, Var> > _negvars;
+class cons_pb : public cons, public explainer {
   std::vector< std::pair<int, Var> > _svars; // sorted by absolute value
   int _lb;
-  int _ub; // the perfect upper bound
+  int _total;      // sum |w[i]| - lb': the slack when nothing is false
+  btptr slack_ptr; // int: the current slack
+  vec<Lit> _ps;
+
+  Lit lit(size_t i) const { return Lit(_svars[i].second, _svars[i].first < 0); }
+  int weight(size_t i) const { return abs(_svars[i].first); }
+  // append to c the false literals at trail position t with the
+  // largest weights, until their weights add up to more than limit
+  void explain_false(Solver &s, size_t skip, int limit, int t,
+                     vec<Lit>& c);
+  // force the literals that the slack allows, or fail
+  Clause *prune(Solver &s, int slack);
 public:
   cons_pb(Solver &s,
           std::vector<Var> const& vars,
           std::vector<int> const& weights, int lb);
 
-  virtual Clause *wake(Solver& s, Lit p);
+  Clause *wake_advised(Solver& s, Lit p, void *advice);
   void clone(Solver& other);
   ostream& print(Solver &s, ostream& os) const;
   ostream& printstate(Solver& s, ostream& os) const;
+
+  void explain(Solver& s, Lit p, vec<Lit>& c);
+  void use() {}
+  void release() {}
 };
 
 void post_pb(Solver& s, vector<Var> const& vars,
@@ -1705,75 +1965,78 @@ void post_pb_iff_re(Solver& s, std::vector<cspvar> const& vars,
 
 cons_pb::cons_pb(Solver& s,
                  vector<Var> const& vars, vector<int> const& weights,
-                 int lb) : _lb(lb), _ub(0)
+                 int lb) : _lb(lb), _total(-lb)
 {
   assert(vars.size() == weights.size());
   size_t n = vars.size();
   for(size_t i = 0; i != n; ++i) {
-    if( weights[i] > 0 ) {
-      _posvars.push_back(make_pair(weights[i], vars[i]));
-      _ub += weights[i];
-    }
-    else if( weights[i] < 0 )
-      _negvars.push_back(make_pair(weights[i], vars[i]));
-    else if( weights[i] == 0 ) continue;
+    if( weights[i] == 0 ) continue;
     _svars.push_back(make_pair(weights[i], vars[i]));
+    _total += weights[i] > 0 ? weights[i] : 0;
   }
   sort(_svars.begin(), _svars.end(), pb::compare_abs_weights());
 
-  // wake on every assignment
+  int slack = _total;
   n = _svars.size();
-  for(size_t i = 0; i != n; ++i)
-    s.wake_on_lit(_svars[i].second, this);
+  for(size_t i = 0; i != n; ++i) {
+    if( s.value(lit(i)) == l_False )
+      slack -= weight(i);
+    s.wake_on_lit(_svars[i].second, this, reinterpret_cast<void*>(i+1));
+  }
+  slack_ptr = s.alloc_backtrackable(sizeof(int));
+  s.deref<int>(slack_ptr) = slack;
+  if( prune(s, slack) )
+    throw unsat();
 }
 
-Clause *cons_pb::wake(Solver& s, Lit)
+void cons_pb::explain_false(Solver &s, size_t skip, int limit, int t,
+                            vec<Lit>& c)
 {
-  size_t np = _posvars.size(),
-    nn = _negvars.size();
-  int ub = 0;
-  for(size_t i = 0; i != np; ++i) {
-    pair<int, Var> const& cv = _posvars[i];
-    int q = toInt(s.value(cv.second));
-    /* the expression 1 - ((-q+1) >> 1) is
-       1 <=> true or unset
-       0 <=> false */
-    int p = 1-((1-q)>>1);
-    ub += p*cv.first;
-  }
-  for(size_t i = 0; i != nn; ++i) {
-    pair<int, Var> const& cv = _negvars[i];
-    int q = toInt(s.value(cv.second));
-    /* the expression (q+1)>>1 is
-       0 <=> false or unset
-       1 <=> true */
-    int p = (q+1)>>1;
-    ub += p*cv.first;
+  int sum = 0;
+  for(size_t i = 0; i != _svars.size() && sum <= limit; ++i) {
+    if( i == skip ) continue;
+    Lit l = lit(i);
+    if( deferred::value_at(s, var(l), t) == l_Undef ||
+        s.value(l) != l_False ) continue;
+    sum += weight(i);
+    c.push(l);
   }
-  if( ub >= _lb ) return 0L; // satisfiable
+  assert(sum > limit);
+}
 
-  vec<Lit> ps;
-  size_t n = _svars.size();
-  int aub = _ub;
-  for(size_t i = 0; i != n; ++i) {
-    pair<int, Var> const& cv = _svars[i];
-    lbool sv = s.value(cv.second);
-    if( sv == l_Undef ) continue;
-    if( cv.first > 0 && sv == l_False ) {
-      aub -= cv.first;
-      Lit lx(cv.second);
-      ps.push( lx );
-    } else if( cv.first < 0 && sv == l_True ) {
-      aub += cv.first;
-      Lit lx(cv.second, true);
-      ps.push( lx );
-    }
-    if( aub < _lb ) break;
+void cons_pb::explain(Solver &s, Lit p, vec<Lit>& c)
+{
+  size_t i = 0;
+  while( lit(i) != p ) ++i;
+  // p must be true if the other literals cannot make up lb' alone,
+  // i.e., if the weight of the false ones exceeds _total - |w[i]|
+  c.push(p);
+  explain_false(s, i, _total - weight(i), s.varTrailPos(p), c);
+}
+
+Clause *cons_pb::prune(Solver &s, int slack)
+{
+  if( slack < 0 ) {
+    _ps.clear();
+    explain_false(s, _svars.size(), _total, s.nAssigns(), _ps);
+    return s.addInactiveClause(_ps);
+  }
+  for(size_t i = 0; i != _svars.size() && weight(i) > slack; ++i) {
+    Lit l = lit(i);
+    if( s.value(l) == l_Undef )
+      s.uncheckedEnqueueDeferred(l, this);
   }
+  return 0L;
+}
 
-  Clause *conf = Clause_new(ps, true);
-  s.addInactiveClause(conf);
-  return conf;
+Clause *cons_pb::wake_advised(Solver& s, Lit p, void *advice)
+{
+  size_t i = reinterpret_cast<size_t>(advice)-1;
+  if( p == lit(i) ) return 0L;
+  int& slack = s.deref_mut<int>(slack_ptr);
+  slack -= weight(i);
+  if( slack >= weight(0) ) return 0L;
+  return prune(s, slack);
 }
 
 void cons_pb::clone(Solver& other)
@@ -1831,19 +2094,36 @@ ostream& cons_pb::printstate(Solver& s, ostream& os) const
   return os;
 }
 
-/* pseudoboolean with a var on the rhs: sum w[i]*v[i] = rhs */
-class cons_pbvar : public cons {
+/* pseudoboolean with a var on the rhs: sum w[i]*v[i] = rhs
+
+   If rhs is eager, the constraint is the deferred explanation of its
+   prunings. The reason only includes the assignments with the largest
+   weights that are needed to justify the pruning, and the bound of
+   rhs is weakened to match.
+*/
+class cons_pbvar : public cons, public explainer {
   std::vector< std::pair<int, Var> > _posvars;
   std::vector< std::pair<int, Var> > _negvars;
   std::vector< std::pair<int, Var> > _svars; // sorted by absolute value
   int _c;
   cspvar _rhs;
   vec<Lit> _ubreason, _lbreason;
+  int _minsum, _maxsum; // the bounds of the lhs when nothing is assigned
+  bool _deferred;       // rhs is eager, prune with deferred explanations
+
+  // append to c the assignments at trail position t that move the
+  // bound of the lhs (the min if lbside, else the max) from start
+  // towards limit, biggest weights first, until it reaches it. skip is
+  // left out. Returns the bound reached
+  int explain_sum(Solver &s, bool lbside, Var skip, int start,
+                  int limit, int t, vec<Lit>& c);
+  // force p, with a deferred explanation if possible
+  Clause *force(Solver &s, Lit p);
 public:
   cons_pbvar(Solver &s,
              std::vector< std::pair<int, Var> > const &vars,
              int c, cspvar rhs)
-    : _c(c), _rhs(rhs)
+    : _c(c), _rhs(rhs), _deferred(!s.cspvarlazy(rhs))
   {
     size_t n = vars.size();
     int lb = _c, ub = _c;
@@ -1861,6 +2141,8 @@ public:
       _svars.push_back( vars[i] );
     }
     sort(_svars.begin(), _svars.end(), pb::compare_abs_weights());
+    _minsum = lb;
+    _maxsum = ub;
 
     _rhs.setmin(s, lb, NO_REASON);
     _rhs.setmax(s, ub, NO_REASON);
@@ -1880,8 +2162,84 @@ public:
   void clone(Solver& other);
   ostream& print(Solver &s, ostream& os) const;
   ostream& printstate(Solver& s, ostream& os) const;
+
+  void explain(Solver& s, Lit p, vec<Lit>& c);
+  void use() {}
+  void release() {}
 };
 
+int cons_pbvar::explain_sum(Solver &s, bool lbside, Var skip, int start,
+                            int limit, int t, vec<Lit>& c)
+{
+  int sum = start;
+  for(size_t i = 0; i != _svars.size(); ++i) {
+    if( lbside ? sum >= limit : sum <= limit ) break;
+    pair<int, Var> const& cv = _svars[i];
+    if( cv.second == skip ) continue;
+    lbool v = deferred::value_at(s, cv.second, t);
+    if( v == l_Undef ) continue;
+    // the value that raises the min of w*v is 1 if w > 0, 0 if w < 0
+    bool raises = (v == l_True) == (cv.first > 0);
+    if( raises != lbside ) continue;
+    sum += lbside ? abs(cv.first) : -abs(cv.first);
+    c.push( Lit(cv.second, v == l_True) );
+  }
+  assert(lbside ? sum >= limit : sum <= limit);
+  return sum;
+}
+
+void cons_pbvar::explain(Solver &s, Lit p, vec<Lit>& c)
+{
+  int t = s.varTrailPos(p);
+  c.push(p);
+  domevent pe = s.event(p);
+  if( !noevent(pe) && pe.x.id() == _rhs.id() ) {
+    if( pe.type == domevent::GEQ )
+      explain_sum(s, true, var_Undef, _minsum, pe.d, t, c);
+    else {
+      assert(pe.type == domevent::LEQ);
+      explain_sum(s, false, var_Undef, _maxsum, pe.d, t, c);
+    }
+    return;
+  }
+
+  // p was forced because ~p takes the lhs outside the domain of rhs
+  size_t i = 0;
+  while( _svars[i].second != var(p) ) ++i;
+  int w = _svars[i].first;
+  int qw = sign(p) ? w : 0;  // the contribution of var(p) under ~p
+  int lbstart = _minsum - std::min(w, 0) + qw,
+    ubstart = _maxsum - std::max(w, 0) + qw;
+  int rhsmax = deferred::max_at(s, _rhs, t),
+    rhsmin = deferred::min_at(s, _rhs, t);
+
+  int lb = lbstart;
+  for(size_t j = 0; j != _svars.size(); ++j) {
+    pair<int, Var> const& cv = _svars[j];
+    if( j == i ) continue;
+    lbool v = deferred::value_at(s, cv.second, t);
+    if( v != l_Undef && (v == l_True) == (cv.first > 0) )
+      lb += abs(cv.first);
+  }
+  if( lb > rhsmax ) {
+    lb = explain_sum(s, true, var(p), lbstart, rhsmax+1, t, c);
+    if( lb-1 < _rhs.omax(s) )
+      c.push( _rhs.r_leq(s, lb-1) );
+  } else {
+    int ub = explain_sum(s, false, var(p), ubstart, rhsmin-1, t, c);
+    if( ub+1 > _rhs.omin(s) )
+      c.push( _rhs.r_geq(s, ub+1) );
+  }
+}
+
+Clause *cons_pbvar::force(Solver &s, Lit p)
+{
+  if( !_deferred || s.value(p) != l_Undef )
+    return s.enqueueFill(p, _lbreason);
+  s.uncheckedEnqueueDeferred(p, this);
+  return 0L;
+}
+
 Clause *cons_pbvar::wake(Solver &s, Lit)
 {
   size_t np = _posvars.size(),
@@ -1927,9 +2285,15 @@ Clause *cons_pbvar::wake(Solver &s, Lit)
     nonimpliedub = true;
 
   _lbreason.shrink(_lbreason.size() - lbi);
-  DO_OR_RETURN(_rhs.setminf(s, lb, _lbreason));
+  if( _deferred && lb > _rhs.min(s) && lb <= _rhs.max(s) )
+    s.uncheckedEnqueueDeferred(~Lit(_rhs.leqiUnsafe(s, lb-1)), this);
+  else
+    DO_OR_RETURN(_rhs.setminf(s, lb, _lbreason));
   _ubreason.shrink(_ubreason.size() - ubi);
-  DO_OR_RETURN(_rhs.setmaxf(s, ub, _ubreason));
+  if( _deferred && ub < _rhs.max(s) && ub >= _rhs.min(s) )
+    s.uncheckedEnqueueDeferred(Lit(_rhs.leqiUnsafe(s, ub)), this);
+  else
+    DO_OR_RETURN(_rhs.setmaxf(s, ub, _ubreason));
 
   // check again, because rhs might have had holes!
   if( _rhs.min(s) > lb )
@@ -1944,9 +2308,10 @@ Clause *cons_pbvar::wake(Solver &s, Lit)
   int rhsub = _rhs.max(s);
 
   // note we gather everything in _lbreason now
-  if( nonimpliedlb )
+  // the original bounds of rhs need no reason
+  if( nonimpliedlb && rhslb > _rhs.omin(s) )
     _lbreason.push( _rhs.r_min(s) );
-  if( nonimpliedub )
+  if( nonimpliedub && rhsub < _rhs.omax(s) )
     _lbreason.push( _rhs.r_max(s) );
 
   for(size_t i = 0; i != np; ++i) {
@@ -1954,18 +2319,18 @@ Clause *cons_pbvar::wake(Solver &s, Lit)
     int q = toInt(s.value(cv.second));
     if( q ) continue;
     if( lb + cv.first > rhsub )
-      DO_OR_RETURN(s.enqueueFill( Lit( cv.second, true ), _lbreason ));
+      DO_OR_RETURN(force(s, Lit( cv.second, true )));
     if( ub - cv.first < rhslb )
-      DO_OR_RETURN(s.enqueueFill( Lit( cv.second ), _lbreason ));
+      DO_OR_RETURN(force(s, Lit( cv.second )));
   }
   for(size_t i = 0; i != nn; ++i) {
     pair<int, Var> const& cv = _negvars[i];
     int q = toInt(s.value(cv.second));
     if( q ) continue;
     if( ub + cv.first < rhslb )
-      DO_OR_RETURN(s.enqueueFill( Lit(cv.second, true ), _lbreason ));
+      DO_OR_RETURN(force(s, Lit(cv.second, true )));
     if( lb - cv.first > rhsub )
-      DO_OR_RETURN(s.enqueueFill( Lit(cv.second ), _lbreason ));
+      DO_OR_RETURN(force(s, Lit(cv.second )));
   }
 
   return 0L;
@@ -2431,9 +2796,343 @@ void post_max(Solver &s, cspvar x, cspvar y, cspvar z)
 }
 
 
-/* Element: R = X[I]
+namespace element {
+  // push to ps the reason that v is not in D(x)
+  template<typename V>
+  void push_out(Solver &s, V& ps, cspvar x, int v)
+  {
+    if( v < x.omin(s) || v > x.omax(s) ) return;
+    if( v < x.min(s) ) ps.push( x.r_geq(s, v+1) );
+    else if( v > x.max(s) ) ps.push( x.r_leq(s, v-1) );
+    else ps.push( x.r_neq(s, v) );
+  }
+
+  template<typename V>
+  void push_geq(Solver &s, V& ps, cspvar x, int d)
+  {
+    if( d > x.omin(s) ) ps.push( x.r_geq(s, d) );
+  }
+
+  template<typename V>
+  void push_leq(Solver &s, V& ps, cspvar x, int d)
+  {
+    if( d < x.omax(s) ) ps.push( x.r_leq(s, d) );
+  }
+}
+
+/* Element: R = X[I-offset], domain consistent
+
+   Every index i in D(I) needs a value in both D(X[i]) and D(R), every
+   value v in D(R) an index i in D(I) with v in D(X[i]) and, once I is
+   fixed, X[I] and R have the same domain. The last support found for
+   each index and each value is checked first the next time. Supports
+   are not restored on backtracking, since an old support is as good a
+   guess as any.
+*/
+class cons_element : public cons {
+  cspvar _R, _I;
+  vector<cspvar> _X;
+  int _offset;
+  int _rmin;           // R.min() when posted, the first value of _rsupp
+  vector<int> _isupp;  // a value in D(X[i]) and D(R)
+  vector<int> _rsupp;  // an index i with v in D(X[i])
+  vec<Lit> _ps;
+
+  // the reason that D(x) and D(y) do not intersect
+  void explain_disjoint(Solver &s, cspvar x, cspvar y);
+public:
+  cons_element(Solver &s, cspvar R, cspvar I,
+               vector<cspvar> const& X, int offset);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+cons_element::cons_element(Solver &s, cspvar R, cspvar I,
+                           vector<cspvar> const& X, int offset) :
+  _R(R), _I(I), _X(X), _offset(offset)
+{
+  _I.setmin(s, _offset, NO_REASON);
+  _I.setmax(s, _X.size()+_offset-1, NO_REASON);
+  int rmin = std::numeric_limits<int>::max(),
+    rmax = std::numeric_limits<int>::min();
+  for(int i = _I.min(s); i <= _I.max(s); ++i) {
+    rmin = std::min(rmin, _X[i-_offset].min(s));
+    rmax = std::max(rmax, _X[i-_offset].max(s));
+  }
+  _R.setmin(s, rmin, NO_REASON);
+  _R.setmax(s, rmax, NO_REASON);
+
+  _rmin = _R.min(s);
+  _rsupp.assign(_R.max(s) - _rmin + 1, _I.min(s));
+  _isupp.resize(_X.size());
+  for(size_t i = 0; i != _X.size(); ++i) {
+    _isupp[i] = _X[i].min(s);
+    s.schedule_on_dom(_X[i], this);
+  }
+  s.schedule_on_dom(_R, this);
+  s.schedule_on_dom(_I, this);
+  if( propagate(s) )
+    throw unsat();
+}
+
+void cons_element::explain_disjoint(Solver &s, cspvar x, cspvar y)
+{
+  using namespace element;
+  int lo = std::max(x.min(s), y.min(s)), hi = std::min(x.max(s), y.max(s));
+  if( lo > hi ) {
+    if( x.min(s) > y.max(s) ) {
+      push_geq(s, _ps, x, y.max(s)+1);
+      push_leq(s, _ps, y, y.max(s));
+    } else {
+      push_leq(s, _ps, x, x.max(s));
+      push_geq(s, _ps, y, x.max(s)+1);
+    }
+    return;
+  }
+  if( x.min(s) >= y.min(s) ) push_geq(s, _ps, x, lo);
+  else push_geq(s, _ps, y, lo);
+  if( x.max(s) <= y.max(s) ) push_leq(s, _ps, x, hi);
+  else push_leq(s, _ps, y, hi);
+  for(int v = lo; v <= hi; ++v) {
+    if( !x.indomain(s, v) ) push_out(s, _ps, x, v);
+    else push_out(s, _ps, y, v);
+  }
+}
+
+Clause *cons_element::propagate(Solver &s)
+{
+  using namespace element;
+
+  // indices
+  for(int i = _I.min(s); i <= _I.max(s); ++i) {
+    if( !_I.indomain(s, i) ) continue;
+    cspvar x = _X[i-_offset];
+    int& supp = _isupp[i-_offset];
+    if( x.indomain(s, supp) && _R.indomain(s, supp) ) continue;
+    int hi = std::min(x.max(s), _R.max(s)), v;
+    for(v = std::max(x.min(s), _R.min(s)); v <= hi; ++v)
+      if( x.indomain(s, v) && _R.indomain(s, v) ) break;
+    if( v <= hi ) {
+      supp = v;
+      continue;
+    }
+    _ps.clear();
+    explain_disjoint(s, x, _R);
+    DO_OR_RETURN(_I.removef(s, i, _ps));
+  }
+
+  // values
+  for(int v = _R.min(s); v <= _R.max(s); ++v) {
+    if( !_R.indomain(s, v) ) continue;
+    int& supp = _rsupp[v-_rmin];
+    if( _I.indomain(s, supp) && _X[supp-_offset].indomain(s, v) ) continue;
+    int i;
+    for(i = _I.min(s); i <= _I.max(s); ++i)
+      if( _I.indomain(s, i) && _X[i-_offset].indomain(s, v) ) break;
+    if( i <= _I.max(s) ) {
+      supp = i;
+      continue;
+    }
+    _ps.clear();
+    push_geq(s, _ps, _I, _I.min(s));
+    push_leq(s, _ps, _I, _I.max(s));
+    for(i = _I.min(s); i <= _I.max(s); ++i) {
+      if( !_I.indomain(s, i) ) _ps.push( _I.r_neq(s, i) );
+      else push_out(s, _ps, _X[i-_offset], v);
+    }
+    DO_OR_RETURN(_R.removef(s, v, _ps));
+  }
+
+  // X[I] = R once I is fixed. R has already lost the values that are
+  // not in D(X[I])
+  if( _I.min(s) == _I.max(s) ) {
+    cspvar x = _X[_I.min(s)-_offset];
+    for(int v = x.min(s); v <= x.max(s); ++v) {
+      if( !x.indomain(s, v) || _R.indomain(s, v) ) continue;
+      _ps.clear();
+      _ps.push( _I.r_eq(s) );
+      push_out(s, _ps, _R, v);
+      DO_OR_RETURN(x.removef(s, v, _ps));
+    }
+  }
+  return 0L;
+}
+
+void cons_element::clone(Solver &other)
+{
+  cons *con = new cons_element(other, _R, _I, _X, _offset);
+  other.addConstraint(con);
+}
+
+ostream& cons_element::print(Solver &s, ostream& os) const
+{
+  os << cspvar_printer(s, _R) << " = [";
+  for(size_t i = 0; i != _X.size(); ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _X[i]);
+  }
+  os << "][" << cspvar_printer(s, _I);
+  if( _offset ) os << " - " << _offset;
+  os << "]";
+  return os;
+}
+
+ostream& cons_element::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  os << " (with " << cspvar_printer(s, _R) << " in "
+     << domain_as_set(s, _R) << ", " << cspvar_printer(s, _I) << " in "
+     << domain_as_set(s, _I);
+  for(size_t i = 0; i != _X.size(); ++i)
+    os << ", " << cspvar_printer(s, _X[i]) << " in "
+       << domain_as_set(s, _X[i]);
+  os << ")";
+  return os;
+}
+
+/* Element over an array of constants: R = c[I-offset], domain
+   consistent
+
+   The indices are kept sorted by value, so the indices that support
+   a value are a contiguous range, and the last support found for each
+   value is checked first. An index only needs its own value to be in
+   D(R).
+*/
+class cons_element_const : public cons {
+  cspvar _R, _I;
+  vector<int> _c;
+  int _offset;
+  vector< pair<int, int> > _sorted; // (c[i], i+offset) sorted
+  vector<int> _vals;   // the distinct values of c, sorted
+  vector<int> _first;  // where the indices of _vals[k] start in _sorted
+  vector<int> _resid;  // last support of _vals[k], in _sorted
+  vec<Lit> _ps;
+public:
+  cons_element_const(Solver &s, cspvar R, cspvar I,
+                     vector<int> const& c, int offset);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+cons_element_const::cons_element_const(Solver &s, cspvar R, cspvar I,
+                                       vector<int> const& c, int offset) :
+  _R(R), _I(I), _c(c), _offset(offset)
+{
+  _I.setmin(s, _offset, NO_REASON);
+  _I.setmax(s, _c.size()+_offset-1, NO_REASON);
+  for(size_t i = 0; i != _c.size(); ++i)
+    _sorted.push_back( make_pair(_c[i], int(i)+_offset) );
+  std::sort(_sorted.begin(), _sorted.end());
+  for(size_t p = 0; p != _sorted.size(); ++p) {
+    if( p != 0 && _sorted[p].first == _sorted[p-1].first ) continue;
+    _vals.push_back(_sorted[p].first);
+    _first.push_back(p);
+  }
+  _first.push_back(_sorted.size());
+  _resid.assign(_first.begin(), _first.end()-1);
+
+  // values that appear nowhere in c. Only the values of R are
+  // looked at, the gaps between the values of c may be much larger
+  _R.setmin(s, _vals.front(), NO_REASON);
+  _R.setmax(s, _vals.back(), NO_REASON);
+  for(int v = _R.min(s), vmax = _R.max(s); v <= vmax; ++v)
+    if( _R.indomain(s, v) &&
+        !std::binary_search(_vals.begin(), _vals.end(), v) )
+      _R.remove(s, v, NO_REASON);
+
+  s.schedule_on_dom(_R, this);
+  s.schedule_on_dom(_I, this);
+  if( propagate(s) )
+    throw unsat();
+}
+
+Clause *cons_element_const::propagate(Solver &s)
+{
+  using namespace element;
+
+  for(int i = _I.min(s); i <= _I.max(s); ++i) {
+    if( !_I.indomain(s, i) ) continue;
+    int v = _c[i-_offset];
+    if( _R.indomain(s, v) ) continue;
+    _ps.clear();
+    push_out(s, _ps, _R, v);
+    DO_OR_RETURN(_I.removef(s, i, _ps));
+  }
+
+  size_t k = std::lower_bound(_vals.begin(), _vals.end(), _R.min(s))
+    - _vals.begin();
+  for(; k != _vals.size() && _vals[k] <= _R.max(s); ++k) {
+    int v = _vals[k];
+    if( !_R.indomain(s, v) ) continue;
+    if( _I.indomain(s, _sorted[_resid[k]].second) ) continue;
+    int p;
+    for(p = _first[k]; p != _first[k+1]; ++p)
+      if( _I.indomain(s, _sorted[p].second) ) break;
+    if( p != _first[k+1] ) {
+      _resid[k] = p;
+      continue;
+    }
+    // the indices are sorted, so those below I.min() come first and
+    // those above I.max() last
+    _ps.clear();
+    if( _sorted[_first[k]].second < _I.min(s) )
+      push_geq(s, _ps, _I, _I.min(s));
+    if( _sorted[_first[k+1]-1].second > _I.max(s) )
+      push_leq(s, _ps, _I, _I.max(s));
+    for(p = _first[k]; p != _first[k+1]; ++p) {
+      int i = _sorted[p].second;
+      if( i >= _I.min(s) && i <= _I.max(s) )
+        _ps.push( _I.r_neq(s, i) );
+    }
+    DO_OR_RETURN(_R.removef(s, v, _ps));
+  }
+  return 0L;
+}
+
+void cons_element_const::clone(Solver &other)
+{
+  cons *con = new cons_element_const(other, _R, _I, _c, _offset);
+  other.addConstraint(con);
+}
+
+ostream& cons_element_const::print(Solver &s, ostream& os) const
+{
+  os << cspvar_printer(s, _R) << " = [";
+  for(size_t i = 0; i != _c.size(); ++i) {
+    if( i ) os << ", ";
+    os << _c[i];
+  }
+  os << "][" << cspvar_printer(s, _I);
+  if( _offset ) os << " - " << _offset;
+  os << "]";
+  return os;
+}
+
+ostream& cons_element_const::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  os << " (with " << cspvar_printer(s, _R) << " in "
+     << domain_as_set(s, _R) << ", " << cspvar_printer(s, _I) << " in "
+     << domain_as_set(s, _I) << ")";
+  return os;
+}
+
+void post_element(Solver &s, cspvar R, cspvar I,
+                  vector<int> const& X, int offset)
+{
+  assert(!X.empty());
+  cons *con = new cons_element_const(s, R, I, X, offset);
+  s.addConstraint(con);
+}
 
-   Note that indexing is 1-based here, following flatzinc's element */
+/* Element: R = X[I-offset], decomposed into clauses over 2*n*d
+   auxiliary variables */
 namespace element {
   size_t idx(int i, int imin,
              int j, int rmin,
@@ -2444,13 +3143,27 @@ namespace element {
 
 void post_element(Solver &s, cspvar R, cspvar I,
                   vector<cspvar> const& X,
-                  int offset)
+                  int offset, bool decomp)
 {
   using std::min;
   using std::max;
 
   assert(!X.empty());
 
+  if( !decomp ) {
+    if( std::all_of(X.begin(), X.end(),
+                    [&](cspvar x) { return x.min(s) == x.max(s); }) ) {
+      vector<int> c;
+      for(size_t i = 0; i != X.size(); ++i)
+        c.push_back(X[i].min(s));
+      post_element(s, R, I, c, offset);
+      return;
+    }
+    cons *con = new cons_element(s, R, I, X, offset);
+    s.addConstraint(con);
+    return;
+  }
+
   I.setmin(s, offset, NO_REASON);
   I.setmax(s, X.size()+offset-1, NO_REASON);
 
@@ -2581,10 +3294,186 @@ class cons_table;
 
 /* Global constraints */
 
-/* All different: each variable gets a distinct value */
-class cons_alldiff : public cons
-{
-  static const int idx_undef;
+/* Searches in the residual graph of a matching between n vars and
+   groups of values, shared by alldiff (where each value is a group)
+   and gcc. Node i < n is var i and node n+g is group g. The
+   propagator P describes the graph:
+
+     int first_pos(Solver&, int u) const;
+     int succ(Solver&, int u, int& pos) const;
+       the next successor of u, or -1. pos starts at first_pos(u).
+       A var leads to the groups it can take except its own, a group
+       to the vars matched to it
+     bool room(int u) const;          group u can take one more var
+     int matched_node(int i) const;   the group of var i, or -1
+     void match_node(int i, int u);   match var i to group u
+
+   and is told about the SCCs:
+
+     void scc_edge(Solver&, int u, int v);
+       the edge u->v has been explored. v is done, unless it is
+       still on the stack
+     void scc_found(Solver&, int const* first, int const* last);
+       the nodes of an SCC, in the order they were visited
+*/
+namespace matching {
+  const int undef = -1;
+
+  class residual {
+    int nvars;
+
+    void enter_scc(int u, int pos);
+  public:
+    // stamp[u] == curstamp iff u was reached by the last search, par
+    // is the var that reached each group and queue the nodes in the
+    // order they were reached
+    vector<int> stamp;
+    int curstamp;
+    vector<int> queue;
+    vector<int> par;
+
+    // for the SCCs, kept until clear_scc()
+    vector<int> index, low;
+    vector<unsigned char> onstack;
+    vector<int> stack;
+    vector< pair<int, int> > cstack; // node and position in succ
+    vector<int> touched;
+    int next;
+
+    void init(int n, int nnodes);
+    void restart() { ++curstamp; queue.clear(); }
+    bool reached(int u) const { return stamp[u] == curstamp; }
+
+    // find an augmenting path from the free var i and apply it. If
+    // there is none, the nodes reached by the search are in queue
+    template<typename P>
+    bool augment(Solver &s, P& p, int i);
+    // all the nodes reachable from u go in queue
+    template<typename P>
+    void reach(Solver &s, P& p, int u);
+
+    // Tarjan's algorithm from r, which must not have been visited
+    // since the last clear_scc()
+    template<typename P>
+    void scc(Solver &s, P& p, int r);
+    bool visited(int u) const { return index[u] != undef; }
+    void clear_scc();
+  };
+
+  void residual::init(int n, int nnodes)
+  {
+    nvars = n;
+    stamp.assign(nnodes, 0);
+    curstamp = 0;
+    par.resize(nnodes);
+    index.assign(nnodes, undef);
+    low.resize(nnodes);
+    onstack.assign(nnodes, false);
+    next = 0;
+  }
+
+  template<typename P>
+  bool residual::augment(Solver &s, P& p, int i)
+  {
+    restart();
+    queue.push_back(i);
+    stamp[i] = curstamp;
+    for(size_t q = 0; q != queue.size(); ++q) {
+      int u = queue[q], pos = p.first_pos(s, u), v;
+      while( (v = p.succ(s, u, pos)) >= 0 ) {
+        if( stamp[v] == curstamp ) continue;
+        stamp[v] = curstamp;
+        if( u < nvars ) {
+          par[v] = u;
+          if( p.room(v) ) {
+            for(;;) {
+              int z = par[v], old = p.matched_node(z);
+              p.match_node(z, v);
+              if( old < 0 ) return true;
+              v = old;
+            }
+          }
+        }
+        queue.push_back(v);
+      }
+    }
+    return false;
+  }
+
+  template<typename P>
+  void residual::reach(Solver &s, P& p, int u)
+  {
+    restart();
+    queue.push_back(u);
+    stamp[u] = curstamp;
+    for(size_t q = 0; q != queue.size(); ++q) {
+      int w = queue[q], pos = p.first_pos(s, w), v;
+      while( (v = p.succ(s, w, pos)) >= 0 )
+        if( stamp[v] != curstamp ) {
+          stamp[v] = curstamp;
+          queue.push_back(v);
+        }
+    }
+  }
+
+  void residual::enter_scc(int u, int pos)
+  {
+    index[u] = low[u] = next++;
+    stack.push_back(u);
+    onstack[u] = true;
+    touched.push_back(u);
+    cstack.push_back(make_pair(u, pos));
+  }
+
+  template<typename P>
+  void residual::scc(Solver &s, P& p, int r)
+  {
+    assert( !visited(r) );
+    enter_scc(r, p.first_pos(s, r));
+    while( !cstack.empty() ) {
+      int u = cstack.back().first;
+      int v = p.succ(s, u, cstack.back().second);
+      if( v >= 0 ) {
+        if( index[v] == undef ) {
+          enter_scc(v, p.first_pos(s, v));
+          continue;
+        }
+        if( onstack[v] )
+          low[u] = std::min(low[u], index[v]);
+        p.scc_edge(s, u, v);
+        continue;
+      }
+      cstack.pop_back();
+      if( low[u] == index[u] ) {
+        size_t first = stack.size();
+        do {
+          --first;
+          onstack[stack[first]] = false;
+        } while( stack[first] != u );
+        p.scc_found(s, &stack[0] + first, &stack[0] + stack.size());
+        stack.resize(first);
+      }
+      if( !cstack.empty() ) {
+        int w = cstack.back().first;
+        low[w] = std::min(low[w], low[u]);
+        p.scc_edge(s, w, u);
+      }
+    }
+  }
+
+  void residual::clear_scc()
+  {
+    for(size_t j = 0; j != touched.size(); ++j)
+      index[touched[j]] = undef;
+    touched.clear();
+    next = 0;
+  }
+}
+
+/* All different: each variable gets a distinct value */
+class cons_alldiff : public cons
+{
+  static const int idx_undef;
 
   vector<cspvar> _x;
   bool _gac;
@@ -2592,8 +3481,10 @@ class cons_alldiff : public cons
   // it on backtracking, whatever we had before is still valid
   vector<int> matching;    // from var to val
   vector<int> revmatching; // from val to var
-  vector<int> matching0; // double buffering
-  vector<int> revmatching0;
+  // the old edges of the vars and vals that propagate() changed, so
+  // that the matching can be restored if it cannot be repaired
+  vector< pair<int, int> > matching_undo;    // (var, val)
+  vector< pair<int, int> > revmatching_undo; // (val, var)
   vec<Lit> reason;
 
   int umin, umax; // the minimum and maximum values in the universe
@@ -2602,28 +3493,26 @@ class cons_alldiff : public cons
 
   typedef pair<bool, int> vertex;
 
-  // all the following are here to avoid allocations
-  vector<unsigned char> valvisited, varvisited; // for the BFS in matching,
-                                       // whether it is in the stack in
-                                       // tarjan's scc
-  std::vector<int> varfrontier; // the frontier of the BFS
-  std::vector<int> valfrontier;
-  vector<int> valbackp, varbackp; // back pointers to reconstruct the
-                                  // augmenting path
-  vector<int> valvisited_toclear;
-  vector<int> varvisited_toclear;
-
-  vector<int> varindex, varlowlink;
-  vector<int> valindex, vallowlink;
+  // augmenting paths and tarjan's scc, in the graph described by
+  // first_pos() and succ()
+  matching::residual search;
+  bool scc_prune; // remove the edges that the scc search finds
+                  // unsupported, rather than explain a conflict
 
+  // all the following are here to avoid allocations
   vector<unsigned char> varhasfree; // did we reach a free value in the DFS?
   vector<unsigned char> valhasfree;
 
+  // the start index of those sccs that have been touched, and the
+  // indices that were seen while looking for them
+  vector<unsigned> touch_ccs;
+  vector<unsigned char> touch_ccs_in;
+  vector<unsigned> touch_ccs_in_toclear;
+
   vector<int> varcomp, valcomp;
   vector< vertex > components;
   vector< size_t > comp_limit;
   vector< bool > hallcomp; // is the scc a Hall set?
-  vector< vertex > tarjan_stack;
 
   // SCC based decomposition
   vector<size_t> sccs;
@@ -2642,22 +3531,58 @@ class cons_alldiff : public cons
 
   vec<Lit>* reasons;
 
-  bool varfree(size_t var) {
+  bool varfree(size_t var) const {
     return matching[var] < umin;
   }
-  bool valfree(int val) {
+  bool valfree(int val) const {
     return revmatching[val-umin] < 0;
   }
 
+  // change the matching, logging the old edges
+  void match(int var, int val) {
+    matching_undo.push_back(make_pair(var, matching[var]));
+    revmatching_undo.push_back(make_pair(val, revmatching[val-umin]));
+    matching[var] = val;
+    revmatching[val-umin] = var;
+  }
+  void unmatch(int var) {
+    int val = matching[var];
+    matching_undo.push_back(make_pair(var, val));
+    revmatching_undo.push_back(make_pair(val, var));
+    matching[var] = umin-1;
+    revmatching[val-umin] = -1;
+  }
+  void undo_matching() {
+    for(size_t i = matching_undo.size(); i-- != 0; )
+      matching[matching_undo[i].first] = matching_undo[i].second;
+    for(size_t i = revmatching_undo.size(); i-- != 0; )
+      revmatching[revmatching_undo[i].first-umin] = revmatching_undo[i].second;
+    matching_undo.clear();
+    revmatching_undo.clear();
+  }
+
   bool find_initial_matching(Solver& s) {
     nmatched = 0;
     greedy_matching(s);
     return find_matching(s);
   }
 
+  // the residual graph: node var < n is a var and node n+q-umin is
+  // value q. A var leads to the values of its domain except its own,
+  // a value to the var it is matched to
+  friend class matching::residual;
+  int first_pos(Solver &s, int u) const;
+  int succ(Solver &s, int u, int& pos) const;
+  bool room(int u) const { return revmatching[u-_x.size()] < 0; }
+  int matched_node(int var) const {
+    return varfree(var) ? -1 : _x.size() + matching[var] - umin;
+  }
+  void match_node(int var, int u) { match(var, u - _x.size() + umin); }
+  void scc_edge(Solver &s, int u, int v);
+  void scc_found(Solver &s, int const* first, int const* last);
+
   // matching
   void greedy_matching(Solver& s);
-  void clear_visited();
   bool find_matching(Solver& s);
 
   /* SCCs */
@@ -2670,9 +3595,8 @@ class cons_alldiff : public cons
                      vector<unsigned char>& explained,
                      vector<int>& to_explain);
 
-  void tarjan_unroll_stack(Solver &s, vertex root);
   // start the dfs from variable var
-  void tarjan_dfs(Solver& s, size_t var, size_t& index, bool conflict);
+  void tarjan_dfs(Solver& s, size_t var, bool conflict);
   // reset all structures that were touched by tarjan_*
   void tarjan_clear();
 public:
@@ -2693,17 +3617,11 @@ public:
     matching.resize(_x.size(), umin-1);
     revmatching.resize(umax-umin+1, -1);
 
-    varvisited.resize(_x.size(), false);
-    varbackp.resize(_x.size(), umin-1);
-    varindex.resize(_x.size(), idx_undef);
-    varlowlink.resize(_x.size(), idx_undef);
+    search.init(_x.size(), _x.size() + umax-umin+1);
+
     varcomp.resize(_x.size(), idx_undef );
     varhasfree.resize(_x.size(), false );
 
-    valvisited.resize(umax-umin+1, false);
-    valbackp.resize(umax-umin+1, -1);
-    valindex.resize(umax-umin+1, idx_undef);
-    vallowlink.resize(umax-umin+1, idx_undef);
     valcomp.resize(umax-umin+1, idx_undef);
     valhasfree.resize(umax-umin+1, false );
 
@@ -2728,6 +3646,10 @@ public:
       scc_wake[i] = i;
       scc_wake_idx[i] = i;
     }
+    touch_ccs.reserve(_x.size());
+    touch_ccs_in.resize(_x.size(), false);
+    touch_ccs_in_toclear.reserve(_x.size());
+
     scc_wake_size_ptr = s.alloc_backtrackable(sizeof(size_t));
     s.deref<size_t>(scc_wake_size_ptr) = 0;
 
@@ -2792,76 +3714,39 @@ void cons_alldiff::greedy_matching(Solver &s)
   }
 }
 
-void cons_alldiff::clear_visited()
+int cons_alldiff::first_pos(Solver &s, int u) const
+{
+  if( u < (int)_x.size() ) return _x[u].min(s);
+  return 0;
+}
+
+int cons_alldiff::succ(Solver &s, int u, int& pos) const
 {
-  for(size_t i = 0; i != valvisited_toclear.size(); ++i)
-    valvisited[ valvisited_toclear[i]-umin ] = false;
-  for(size_t i = 0; i != varvisited_toclear.size(); ++i)
-    varvisited[ varvisited_toclear[i] ] = false;
-  valvisited_toclear.clear();
-  varvisited_toclear.clear();
+  const int n = _x.size();
+  if( u < n ) {
+    for(int qend = _x[u].max(s); pos <= qend; ++pos) {
+      if( !_x[u].indomainUnsafe(s, pos) ) // no edge at all
+        continue;
+      if( matching[u] == pos ) // edge is (q, var), not (var, q)
+        continue;
+      return n + pos++ - umin;
+    }
+    return -1;
+  }
+  if( pos++ == 0 )
+    return revmatching[u-n];
+  return -1;
 }
 
 bool cons_alldiff::find_matching(Solver &s)
 {
   const size_t n = _x.size();
-  // find a free variable
+  // find a free variable and an augmenting path from it
   for(size_t fvar = 0; fvar != n && nmatched < n; ++fvar ) {
     if ( !varfree(fvar) ) continue;
-
-    // do a bfs for an augmenting path
-    varfrontier.push_back(fvar);
-    int pathend = umin-1;
-    do {
-      while( !varfrontier.empty() ) {
-        size_t var = varfrontier.back();
-        varfrontier.pop_back();
-        int qend = _x[var].max(s);
-        for(int q = _x[var].min(s); q <= qend ; ++q) {
-          if( !_x[var].indomainUnsafe(s, q) ) continue;
-          if( matching[var] == q )
-            continue;
-          if( valvisited[q-umin] )
-            continue;
-          valbackp[q-umin] = var;
-          if( valfree(q) ) {
-            pathend = q;
-            goto augment_path;
-          }
-          valfrontier.push_back(q);
-          valvisited[q-umin] = true;
-          valvisited_toclear.push_back(q);
-        }
-      }
-      while( !valfrontier.empty() ) {
-        int q = valfrontier.back();
-        valfrontier.pop_back();
-        int var = revmatching[q - umin];
-        if( var < 0 || varvisited[var] ) continue;
-        varfrontier.push_back(var);
-        varbackp[var] = q;
-        varvisited[var] = true;
-        varvisited_toclear.push_back(var);
-      }
-    } while( !varfrontier.empty() );
-    clear_visited();
-    return false;
-  augment_path:
-    int val = pathend;
-    int var = valbackp[pathend-umin];
-    assert( var >= 0 );
-    matching[var] = pathend;
-    revmatching[pathend-umin] = var;
-    while( (unsigned)var != fvar ) {
-      val = varbackp[var];
-      var = valbackp[val-umin];
-      matching[var] = val;
-      revmatching[val-umin] = var;
-    }
+    if( !search.augment(s, *this, fvar) )
+      return false;
     ++nmatched;
-    valfrontier.clear();
-    varfrontier.clear();
-    clear_visited();
   }
   for(size_t i = 0; i != n; ++i)
     assert(!varfree(i));
@@ -2921,8 +3806,7 @@ void cons_alldiff::explain_conflict(Solver &s, vec<Lit>& ps)
   for(fvar = 0; !varfree(fvar); ++fvar)
     ;
   // ... and all SCCs reachable from it ...
-  size_t index = 0;
-  tarjan_dfs(s, fvar, index, true);
+  tarjan_dfs(s, fvar, true);
   cspvar v = _x[fvar];
 
   ps.clear();
@@ -2953,30 +3837,30 @@ void cons_alldiff::explain_conflict(Solver &s, vec<Lit>& ps)
   tarjan_clear();
 }
 
-void cons_alldiff::tarjan_unroll_stack(Solver &s, vertex root)
+void cons_alldiff::scc_found(Solver &s, int const* first, int const* last)
 {
+  const int n = _x.size();
   int scc = comp_limit.size()-1;
   int numvars = 0;
   size_t minvaridx = _x.size();
   hallcomp.push_back(true);
-  vertex vp;
-  do {
-    vp = tarjan_stack.back(); tarjan_stack.pop_back();
-    components.push_back(vp);
-    if( vp.first ) {
+  while( last != first ) {
+    int u = *--last;
+    if( u < n ) {
+      components.push_back( make_pair(true, u) );
       ++numvars;
-      varcomp[vp.second] = scc;
-      varvisited[vp.second] = false;
-      if( varhasfree[vp.second] )
+      varcomp[u] = scc;
+      if( varhasfree[u] )
         hallcomp[scc] = false;
-      minvaridx = std::min(minvaridx, scc_index[vp.second]);
+      minvaridx = std::min(minvaridx, scc_index[u]);
     } else {
-      valcomp[vp.second-umin] = scc;
-      valvisited[vp.second-umin] = false;
-      if( valhasfree[vp.second-umin] )
+      int val = u - n + umin;
+      components.push_back( make_pair(false, val) );
+      valcomp[val-umin] = scc;
+      if( valfree(val) || valhasfree[val-umin] )
         hallcomp[scc] = false;
     }
-  } while( vp != root );
+  }
   comp_limit.push_back(components.size());
   if( hallcomp[scc] ) {
     // split the constraint
@@ -3006,7 +3890,7 @@ void cons_alldiff::tarjan_unroll_stack(Solver &s, vertex root)
         ++i1;
     }
     // ... and mark the split.
-    scc_splitpoint[i2] = true;
+    s.bt_write_array<bool>(scc_splitpoint_ptr, i2, true);
     return;
   }
   // not a hall set, so we can reach a free value
@@ -3021,97 +3905,64 @@ void cons_alldiff::tarjan_unroll_stack(Solver &s, vertex root)
 
 void cons_alldiff::tarjan_clear()
 {
-  for(size_t i = 0; i != varvisited_toclear.size(); ++i) {
-    int var = varvisited_toclear[i];
-    varindex[var] = idx_undef;
-    varlowlink[var] = idx_undef;
-    varcomp[var] = idx_undef;
-    varhasfree[var] = false;
-  }
-  for(size_t i = 0; i != valvisited_toclear.size(); ++i) {
-    int val = valvisited_toclear[i];
-    valindex[val - umin] = idx_undef;
-    vallowlink[val - umin] = idx_undef;
-    valcomp[val - umin] = idx_undef;
-    valhasfree[val - umin] = false;
+  const int n = _x.size();
+  for(size_t i = 0; i != search.touched.size(); ++i) {
+    int u = search.touched[i];
+    if( u < n ) {
+      varcomp[u] = idx_undef;
+      varhasfree[u] = false;
+    } else {
+      valcomp[u - n] = idx_undef;
+      valhasfree[u - n] = false;
+    }
   }
   for(size_t i = 0; i != comp_limit.size()-1; ++i)
     reasons[i].clear();
-  valvisited_toclear.clear();
-  varvisited_toclear.clear();
+  search.clear_scc();
   components.clear();
   comp_limit.resize(1);
   hallcomp.clear();
 }
 
-void cons_alldiff::tarjan_dfs(Solver &s, size_t var, size_t& index,
-                              bool conflict)
+void cons_alldiff::scc_edge(Solver &s, int u, int v)
 {
-  varvisited_toclear.push_back(var);
-  varindex[var] = index;
-  varlowlink[var] = index;
-  varvisited[var] = true;
-  ++index;
-  tarjan_stack.push_back( make_pair(true, var) );
-  for(int q = _x[var].min(s), qend = _x[var].max(s); q <= qend; ++q) {
-    if( !_x[var].indomainUnsafe(s, q) ) // no edge at all
-      continue;
-    if( matching[var] == q ) // edge is (q, var), not (var, q)
-      continue;
-    if( valindex[q-umin] == idx_undef  ) {
-      int val = q;
-      valvisited_toclear.push_back(val);
-      valindex[val-umin] = index;
-      vallowlink[val-umin] = index;
-      valvisited[val-umin] = true;
-      ++index;
-      tarjan_stack.push_back( make_pair(false, val) );
-      int var2 = revmatching[val-umin];
-      if( var2 >= 0 ) {
-        if( varindex[var2] == idx_undef  ) {
-          tarjan_dfs(s, var2, index, conflict);
-          vallowlink[val-umin] = std::min(vallowlink[val-umin], varlowlink[var2]);
-        } else if( varvisited[var2] ) { // var2 is in stack
-          vallowlink[val-umin] = std::min(vallowlink[val-umin], varindex[var2] );
-        }
-        valhasfree[val-umin] = varhasfree[var2];
-      } else
-        valhasfree[val-umin] = true;
-      if( vallowlink[val-umin] == valindex[val-umin] ) {
-        tarjan_unroll_stack( s, make_pair(false, val) );
-      }
-      varlowlink[var] = std::min(varlowlink[var], vallowlink[q-umin]);
-    } else if( valvisited[q-umin] ) // q is in stack
-      varlowlink[var] = std::min(varlowlink[var], valindex[q-umin] );
-    if( valfree( q ) || valhasfree[q-umin] )
-      varhasfree[var] = true;
-    if( !conflict ) {
-      int scc = valcomp[q-umin];
-      if( scc == idx_undef ) continue; // q and var are in the same scc
-      if( hallcomp[scc] ) { // Hall set
-        if( reasons[scc].size() == 0 ) {
-          vector<int> to_explain;
-          vector<unsigned char> explained(umax-umin+1, false);
-          explain_value(s, q, reasons[scc], explained, to_explain);
-          assert(to_explain.empty());
-        }
-        _x[var].removef(s, q, reasons[scc]);
+  const int n = _x.size();
+  if( u >= n ) { // from a value to its var
+    valhasfree[u - n] = varhasfree[v];
+    return;
+  }
+  int var = u, q = v - n + umin;
+  if( valfree( q ) || valhasfree[q-umin] )
+    varhasfree[var] = true;
+  if( scc_prune ) {
+    int scc = valcomp[q-umin];
+    if( scc == idx_undef ) return; // q and var are in the same scc
+    if( hallcomp[scc] ) { // Hall set
+      if( reasons[scc].size() == 0 ) {
+        vector<int> to_explain;
+        vector<unsigned char> explained(umax-umin+1, false);
+        explain_value(s, q, reasons[scc], explained, to_explain);
+        assert(to_explain.empty());
       }
+      _x[var].removef(s, q, reasons[scc]);
     }
   }
-  if( varlowlink[var] == varindex[var] ) {
-    tarjan_unroll_stack( s, make_pair(true, var) );
-  }
+}
+
+void cons_alldiff::tarjan_dfs(Solver &s, size_t var, bool conflict)
+{
+  scc_prune = !conflict;
+  search.scc(s, *this, var);
 }
 
 Clause* cons_alldiff::wake_advised(Solver &s, Lit p, void *advice)
 {
   domevent de = s.event(p);
 
-  assert( de.type == domevent::NEQ );
+  assert( de.type == domevent::NEQ || s.cspvarlazy(de.x) );
 
   size_t idx = reinterpret_cast<size_t>(advice)-1;
-  size_t & scc_wake_size = s.deref<size_t>(scc_wake_size_ptr);
+  size_t & scc_wake_size = s.deref_mut<size_t>(scc_wake_size_ptr);
   if( scc_wake_idx[idx] >= scc_wake_size ) {
     unsigned prev = scc_wake[scc_wake_size];
     std::swap(scc_wake[scc_wake_size], scc_wake[scc_wake_idx[idx]]);
@@ -3144,30 +3995,21 @@ Clause* cons_alldiff::propagate(Solver &s)
   assert(nmatched == n);
   bool valid = true; // is the current matching still valid?
 
-  size_t & scc_wake_size = s.deref<size_t>(scc_wake_size_ptr);
+  size_t & scc_wake_size = s.deref_mut<size_t>(scc_wake_size_ptr);
   bool *scc_splitpoint = s.deref_array<bool>(scc_splitpoint_ptr);
 
-  // the start index of those sccs that have been touched
-  vector<unsigned> touch_ccs(n);
-  vector<bool> touch_ccs_in(n);
-  unsigned touch_ccs_size = 0;
-
-  for(size_t i = 0; i != n; ++i) touch_ccs_in[i] = false;
+  touch_ccs.clear();
+  // if we detect failure, we will undo the changes to the matching so
+  // on backtracking we will still have a valid matching
+  matching_undo.clear();
+  revmatching_undo.clear();
 
   for(size_t w = 0; w != scc_wake_size; ++w) {
     size_t i = scc_wake[w];
     assert( !varfree(i) );
     if( !_x[i].indomainUnsafe( s, matching[i] ) ) {
-      if(valid) {
-        valid = false;
-        revmatching0 = revmatching;
-        matching0 = matching; // if we detect failure, we will copy
-                              // matching0 back to matching so on
-                              // backtracking we will still have a
-                              // valid matching
-      }
-      revmatching[ matching[i]-umin ] = -1;
-      matching[i] = umin-1;
+      valid = false;
+      unmatch(i);
       --nmatched;
     }
     if( !_gac ) continue;
@@ -3176,16 +4018,21 @@ Clause* cons_alldiff::propagate(Solver &s)
     // would be quadratic here.
     unsigned vscc_start = scc_index[i];
     for(; vscc_start > 0 && !scc_splitpoint[vscc_start]
-          && !touch_ccs_in[vscc_start]; --vscc_start)
+          && !touch_ccs_in[vscc_start]; --vscc_start) {
       touch_ccs_in[vscc_start] = true;
+      touch_ccs_in_toclear.push_back(vscc_start);
+    }
     if( !touch_ccs_in[vscc_start] ) {
       touch_ccs_in[vscc_start] = true;
-      touch_ccs[touch_ccs_size] = vscc_start;
-      ++touch_ccs_size;
+      touch_ccs_in_toclear.push_back(vscc_start);
+      touch_ccs.push_back(vscc_start);
     } // else we stopped on touch_ccs_in[..] being true, so we have
       // already added this scc to touch_ccs
   }
   scc_wake_size = 0;
+  for(size_t i = 0; i != touch_ccs_in_toclear.size(); ++i)
+    touch_ccs_in[ touch_ccs_in_toclear[i] ] = false;
+  touch_ccs_in_toclear.clear();
 
   if( valid && !_gac ) {
     return 0L;
@@ -3194,10 +4041,8 @@ Clause* cons_alldiff::propagate(Solver &s)
   if( !valid && !find_matching(s) ) {
     reason.clear();
     explain_conflict(s, reason);
-    Clause *r = Clause_new(reason);
-    s.addInactiveClause(r);
-    matching = matching0;
-    revmatching = revmatching0;
+    Clause *r = s.addInactiveClause(reason);
+    undo_matching();
     nmatched = n;
     return r;
   }
@@ -3207,17 +4052,16 @@ Clause* cons_alldiff::propagate(Solver &s)
   if( !_gac )
     return 0L;
 
-  size_t index = 0;
-  for( unsigned scc = 0; scc != touch_ccs_size; ++scc ) {
+  for( unsigned scc = 0; scc != touch_ccs.size(); ++scc ) {
     size_t idx = touch_ccs[scc];
-    assert( varindex[ sccs[idx] ] == idx_undef );
+    assert( !search.visited(sccs[idx]) );
     size_t eidx = idx;
     for(++eidx; !scc_splitpoint[eidx]; ++eidx)
       ;
-    tarjan_dfs(s, sccs[idx], index, false);
+    tarjan_dfs(s, sccs[idx], false);
     for(++idx; idx != eidx; ++idx) {
-      if( varindex[ sccs[idx] ] == idx_undef )
-        tarjan_dfs(s, sccs[idx], index, false);
+      if( !search.visited(sccs[idx]) )
+        tarjan_dfs(s, sccs[idx], false);
     }
   }
 
@@ -3228,6 +4072,365 @@ Clause* cons_alldiff::propagate(Solver &s)
   return 0L;
 }
 
+/* All different, bounds consistency (Lopez-Ortiz et al, IJCAI
+   2003). The vars are sorted by their bounds and the Hall intervals
+   are found by a sweep over the distinct bounds, with path
+   compression. Each pruning is explained by the Hall interval [a,b]
+   that causes it: the vars inside it are bounded by a and b, and the
+   var that is pruned by a (resp. b).
+
+   The sweep records the Hall interval of each pruning, so a call
+   takes O(n log n). The explanation is deferred, unless some var is
+   lazy, as it takes O(n) to collect the vars inside the interval.
+*/
+class cons_alldiff_bc : public cons, public explainer
+{
+  vector<cspvar> _x;
+  size_t n;
+  bool _deferred; // explain prunings on demand. Only if no var is lazy
+
+  // all these are here to avoid allocations
+  vector<int> _lo, _hi; // the bounds of this call
+  vector<int> _minsorted, _maxsorted;
+  vector<int> _minrank, _maxrank;
+  vector<int> _newbound;
+  vector<int> _hall;   // the other end of the Hall interval of _newbound
+  vector<int> _bounds; // the distinct bounds, _bounds[0] is a sentinel
+  int nb;
+  vector<int> _t, _d, _h; // tree links, capacities and Hall links
+  vec<Lit> _ps;
+  // the other end of the Hall interval of each deferred pruning, by
+  // the var of its literal
+  std::map<Var, int> _deferred_hall;
+
+  static int pathmax(vector<int> const& a, int x) {
+    while( a[x] > x ) x = a[x];
+    return x;
+  }
+  static int pathmin(vector<int> const& a, int x) {
+    while( a[x] < x ) x = a[x];
+    return x;
+  }
+  static void pathset(vector<int>& a, int x, int y, int z) {
+    int k = x;
+    while( k != y ) {
+      int l = a[k];
+      a[k] = z;
+      k = l;
+    }
+  }
+
+  void sort_bounds(Solver &s);
+  // sweep the vars by ub (resp. lb), store the new bounds in
+  // _newbound and the Hall intervals in _hall. Return the var that
+  // fails, or -1
+  int filter_lower();
+  int filter_upper();
+
+  // the vars other than except within [a,b] when the trail had t
+  // literals, to c
+  void explain_interval(Solver &s, int a, int b, size_t except, int t,
+                        vec<Lit>& c);
+  // an interval [a,b] with more than b-a+1 vars inside, that ends at
+  // the ub (resp. starts at the lb) of the var v that failed
+  Clause *explain_failure(Solver &s, int v, bool lower);
+public:
+  cons_alldiff_bc(Solver &s, vector<cspvar> const& x);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+
+  void explain(Solver& s, Lit p, vec<Lit>& c);
+  void use() {}
+  void release() {}
+};
+
+cons_alldiff_bc::cons_alldiff_bc(Solver &s, vector<cspvar> const& x) :
+  _x(x), n(x.size()), _deferred(true)
+{
+  set_priority(2);
+  for(size_t i = 0; i != n; ++i) {
+    s.schedule_on_lb(_x[i], this);
+    s.schedule_on_ub(_x[i], this);
+    if( s.cspvarlazy(_x[i]) )
+      _deferred = false;
+  }
+  _lo.resize(n);
+  _hi.resize(n);
+  _minsorted.resize(n);
+  _maxsorted.resize(n);
+  _minrank.resize(n);
+  _maxrank.resize(n);
+  _newbound.resize(n);
+  _hall.resize(n);
+  _bounds.resize(2*n+2);
+  _t.resize(2*n+2);
+  _d.resize(2*n+2);
+  _h.resize(2*n+2);
+
+  if( propagate(s) )
+    throw unsat();
+}
+
+void cons_alldiff_bc::clone(Solver& other)
+{
+  cons *con = new cons_alldiff_bc(other, _x);
+  other.addConstraint(con);
+}
+
+ostream& cons_alldiff_bc::print(Solver& s, ostream& os) const
+{
+  os << "alldifferent_bc(";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]);
+  }
+  os << ")";
+  return os;
+}
+
+ostream& cons_alldiff_bc::printstate(Solver&s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]) << " in ["
+       << _x[i].min(s) << ", " << _x[i].max(s) << "]";
+  }
+  os << ")";
+  return os;
+}
+
+void cons_alldiff_bc::sort_bounds(Solver &s)
+{
+  for(size_t i = 0; i != n; ++i) {
+    _lo[i] = _x[i].min(s);
+    _hi[i] = _x[i].max(s);
+    _minsorted[i] = _maxsorted[i] = i;
+  }
+  std::sort(_minsorted.begin(), _minsorted.end(),
+            [&](int i, int j) { return _lo[i] < _lo[j]; });
+  std::sort(_maxsorted.begin(), _maxsorted.end(),
+            [&](int i, int j) { return _hi[i] < _hi[j]; });
+
+  // ranks of the distinct values among the lbs and ubs+1
+  int min = _lo[_minsorted[0]], max = _hi[_maxsorted[0]]+1;
+  int last = min-2;
+  nb = 0;
+  _bounds[0] = last;
+  for(size_t i = 0, j = 0;;) {
+    if( i != n && min <= max ) {
+      if( min != last ) _bounds[++nb] = last = min;
+      _minrank[_minsorted[i]] = nb;
+      if( ++i != n ) min = _lo[_minsorted[i]];
+    } else {
+      if( max != last ) _bounds[++nb] = last = max;
+      _maxrank[_maxsorted[j]] = nb;
+      if( ++j == n ) break;
+      max = _hi[_maxsorted[j]]+1;
+    }
+  }
+  _bounds[nb+1] = _bounds[nb]+2;
+}
+
+int cons_alldiff_bc::filter_lower()
+{
+  for(int i = 1; i <= nb+1; ++i) {
+    _t[i] = _h[i] = i-1;
+    _d[i] = _bounds[i]-_bounds[i-1];
+  }
+  for(size_t i = 0; i != n; ++i) {
+    int v = _maxsorted[i];
+    int x = _minrank[v], y = _maxrank[v];
+    int z = pathmax(_t, x+1), j = _t[z];
+    if( --_d[z] == 0 ) {
+      _t[z] = z+1;
+      z = pathmax(_t, _t[z]);
+      _t[z] = j;
+    }
+    pathset(_t, x+1, z, z);
+    if( _d[z] < _bounds[z]-_bounds[y] ) return v;
+    _newbound[v] = _lo[v];
+    if( _h[x] > x ) {
+      // the Hall interval ends at w, and _h[w] is just below its
+      // start
+      int w = pathmax(_h, _h[x]);
+      _newbound[v] = _bounds[w];
+      _hall[v] = _bounds[_h[w]+1];
+      pathset(_h, x, w, w);
+    }
+    if( _d[z] == _bounds[z]-_bounds[y] ) {
+      pathset(_h, _h[y], j-1, y);
+      _h[y] = j-1;
+    }
+  }
+  return -1;
+}
+
+int cons_alldiff_bc::filter_upper()
+{
+  for(int i = 0; i <= nb; ++i) {
+    _t[i] = _h[i] = i+1;
+    _d[i] = _bounds[i+1]-_bounds[i];
+  }
+  for(size_t i = n; i-- != 0; ) {
+    int v = _minsorted[i];
+    int x = _maxrank[v], y = _minrank[v];
+    int z = pathmin(_t, x-1), j = _t[z];
+    if( --_d[z] == 0 ) {
+      _t[z] = z-1;
+      z = pathmin(_t, _t[z]);
+      _t[z] = j;
+    }
+    pathset(_t, x-1, z, z);
+    if( _d[z] < _bounds[y]-_bounds[z] ) return v;
+    _newbound[v] = _hi[v];
+    if( _h[x] < x ) {
+      // the Hall interval starts at w, and _h[w] is just above its
+      // end
+      int w = pathmin(_h, _h[x]);
+      _newbound[v] = _bounds[w]-1;
+      _hall[v] = _bounds[_h[w]-1]-1;
+      pathset(_h, x, w, w);
+    }
+    if( _d[z] == _bounds[y]-_bounds[z] ) {
+      pathset(_h, _h[y], j+1, y);
+      _h[y] = j+1;
+    }
+  }
+  return -1;
+}
+
+void cons_alldiff_bc::explain_interval(Solver &s, int a, int b,
+                                       size_t except, int t,
+                                       vec<Lit>& c)
+{
+  using deferred::value_at;
+  int count = 0;
+  for(size_t i = 0; i != n; ++i) {
+    if( i == except ) continue;
+    cspvar x = _x[i];
+    if( t == s.nAssigns() ) {
+      if( x.min(s) < a || x.max(s) > b ) continue;
+    } else {
+      // x is eager, the bounds it had are those whose literals were
+      // already set
+      if( a > x.omin(s) &&
+          value_at(s, x.leqiUnsafe(s, a-1), t) != l_False ) continue;
+      if( b < x.omax(s) &&
+          value_at(s, x.leqiUnsafe(s, b), t) != l_True ) continue;
+    }
+    ++count;
+    pushifdef(c, x.r_geq(s, a));
+    pushifdef(c, x.r_leq(s, b));
+  }
+  assert(count >= b-a+1); (void)count;
+}
+
+Clause *cons_alldiff_bc::explain_failure(Solver &s, int v, bool lower)
+{
+  // grow the interval from the bound of v, counting the vars inside
+  int count = 0;
+  if( lower ) {
+    int b = _hi[v];
+    for(size_t i = n; i-- != 0; ) {
+      int k = _minsorted[i], a = _lo[k];
+      if( _hi[k] <= b ) ++count;
+      if( a <= b && (i == 0 || _lo[_minsorted[i-1]] != a) &&
+          count > b-a+1 ) {
+        _ps.clear();
+        explain_interval(s, a, b, n, s.nAssigns(), _ps);
+        return s.addInactiveClause(_ps);
+      }
+    }
+  } else {
+    int a = _lo[v];
+    for(size_t i = 0; i != n; ++i) {
+      int k = _maxsorted[i], b = _hi[k];
+      if( _lo[k] >= a ) ++count;
+      if( a <= b && (i == n-1 || _hi[_maxsorted[i+1]] != b) &&
+          count > b-a+1 ) {
+        _ps.clear();
+        explain_interval(s, a, b, n, s.nAssigns(), _ps);
+        return s.addInactiveClause(_ps);
+      }
+    }
+  }
+  assert(0);
+  return 0L;
+}
+
+void cons_alldiff_bc::explain(Solver &s, Lit p, vec<Lit>& c)
+{
+  domevent pe = s.event(p);
+  size_t i = 0;
+  while( _x[i].id() != pe.x.id() ) ++i;
+  int a, b;
+  if( pe.type == domevent::GEQ ) {
+    a = _deferred_hall[var(p)];
+    b = pe.d-1;
+  } else {
+    assert(pe.type == domevent::LEQ);
+    a = pe.d+1;
+    b = _deferred_hall[var(p)];
+  }
+  c.push(p);
+  if( pe.type == domevent::GEQ )
+    pushifdef(c, _x[i].r_geq(s, a));
+  else
+    pushifdef(c, _x[i].r_leq(s, b));
+  explain_interval(s, a, b, i, s.varTrailPos(p), c);
+}
+
+Clause *cons_alldiff_bc::propagate(Solver &s)
+{
+  sort_bounds(s);
+  int v = filter_lower();
+  if( v >= 0 )
+    return explain_failure(s, v, true);
+  for(size_t i = 0; i != n; ++i) {
+    if( _newbound[i] == _lo[i] ) continue;
+    cspvar x = _x[i];
+    int a = _hall[i], b = _newbound[i]-1;
+    assert(a <= _lo[i]);
+    if( _deferred ) {
+      Lit l = ~Lit(x.leqiUnsafe(s, b));
+      _deferred_hall[var(l)] = a;
+      s.uncheckedEnqueueDeferred(l, this);
+      continue;
+    }
+    _ps.clear();
+    pushifdef(_ps, x.r_geq(s, a));
+    explain_interval(s, a, b, i, s.nAssigns(), _ps);
+    DO_OR_RETURN(x.setminf(s, _newbound[i], _ps));
+  }
+
+  sort_bounds(s);
+  v = filter_upper();
+  if( v >= 0 )
+    return explain_failure(s, v, false);
+  for(size_t i = 0; i != n; ++i) {
+    if( _newbound[i] == _hi[i] ) continue;
+    cspvar x = _x[i];
+    int a = _newbound[i]+1, b = _hall[i];
+    assert(b >= _hi[i]);
+    if( _deferred ) {
+      Lit l = Lit(x.leqiUnsafe(s, a-1));
+      _deferred_hall[var(l)] = b;
+      s.uncheckedEnqueueDeferred(l, this);
+      continue;
+    }
+    _ps.clear();
+    pushifdef(_ps, x.r_leq(s, b));
+    explain_interval(s, a, b, i, s.nAssigns(), _ps);
+    DO_OR_RETURN(x.setmaxf(s, _newbound[i], _ps));
+  }
+  return 0L;
+}
+
 void post_alldiff(Solver &s, std::vector<cspvar> const &x, bool gac)
 {
   vector<cspvar> xp;
@@ -3238,9 +4441,12 @@ void post_alldiff(Solver &s, std::vector<cspvar> const &x, bool gac)
     } else
       xp.push_back(x[i]);
   }
+  std::sort(rem.begin(), rem.end());
+  if( std::adjacent_find(rem.begin(), rem.end()) != rem.end() )
+    throw unsat();
   for(size_t i = 0; i != xp.size(); ++i) {
     for(size_t q = 0; q != rem.size(); ++q)
-      xp[i].remove(s, q, NO_REASON);
+      xp[i].remove(s, rem[q], NO_REASON);
   }
   if( xp.empty() ) return;
 
@@ -3248,53 +4454,1373 @@ void post_alldiff(Solver &s, std::vector<cspvar> const &x, bool gac)
   s.addConstraint(con);
 }
 
-class cons_gcc;
+void post_alldiff(Solver &s, std::vector<cspvar> const &x, consistency c)
+{
+  if( c == CONSISTENCY_AUTO ) {
+    c = CONSISTENCY_BOUNDS;
+    for(size_t i = 0; i != x.size(); ++i)
+      if( x[i].domsize(s) != x[i].max(s) - x[i].min(s) + 1 )
+        c = CONSISTENCY_DOMAIN;
+  }
+  if( c == CONSISTENCY_DOMAIN ) {
+    post_alldiff(s, x, true);
+    return;
+  }
+  if( x.empty() ) return;
 
-/* Regular */
-namespace regular {
-  struct layered_fa {
-    vector<transition> d;     // all transitions, ordered by layer
-    vector<int> layer_trans;  // an index into the beginning of each
-                              // layer in d
-    vector<int> layer_states; // the first state of each layer
-    vector<int> state_trans;  // index of first transition of each state
-    vector<int> state_layer;  // the layer of each state
-    int q0;
-    set<int> F;
+  cons *con = new cons_alldiff_bc(s, x);
+  s.addConstraint(con);
+}
 
-    int nlayers() const { return layer_states.size()-1; }
-  };
+/* Global cardinality: the number of vars that take each value is
+   within its bounds, which are either constants or cardinality vars
+
+   The vars are matched to groups of values, so that the number of
+   vars in each group is within the sum of the bounds of its values
+   (a flow with lower bounds, as in Regin 1996). With domain
+   consistency each value is a group, and a var can be matched to the
+   values of its domain. With bounds consistency a var can be matched
+   to any value between its bounds, and the groups are the bounds of
+   the vars, as singletons, and the intervals between them, so there
+   are O(n) groups however large the domains are. An edge between a
+   var and a group is supported iff it is in the matching or both are
+   in the same SCC of the residual graph, so this is GAC over the
+   groups. With bounds consistency only the bounds are pruned, to the
+   first supported group, and when that is not a singleton it is
+   checked on the next call.
+
+   The matching is kept between calls and repaired: vars that lost
+   their group are moved by augmenting paths, then groups below their
+   lower bound are filled from groups above theirs. The augmenting
+   paths and the SCCs are found by matching::residual, as in alldiff.
+
+   Explanations are Hall sets of the residual graph. If R is the set
+   of nodes that group g reaches, the domains of the vars in R are
+   within the groups in R. Then the vars outside R cannot take g:
+   either R has no group with spare capacity and its vars saturate
+   its groups, or the vars outside R are exactly as many as the lower
+   bounds of the groups outside R, which only they can take. So the
+   cardinality vars contribute their upper bounds in the first case
+   and their lower bounds in the second. Failures of the repair are
+   explained by the nodes that it explored, in the same way.
+*/
+class cons_gcc : public cons
+{
+  vector<cspvar> _x;
+  size_t n;
+  bool _bounds;
+
+  // the values with bounds, sorted, and their bounds. _card is
+  // empty if the bounds are constants
+  vector<int> _cval, _clb, _cub;
+  vector<cspvar> _card;
+
+  int umin, umax; // the universe
+
+  // the groups of this call: group g is [_gstart[g], _gstart[g+1])
+  // and its values with bounds are [_gcfirst[g], _gcfirst[g+1]) in
+  // _cval. With domain consistency they never change
+  int G;
+  vector<int> _gstart, _gcfirst;
+  vector<int> _glb, _gub, _gcount;
+
+  // the matching. _match survives between calls, the rest is
+  // rebuilt from it
+  vector<int> _match;    // value of each var
+  vector<int> _mgroup;   // group of each var, -1 if it is free
+  vector<int> _ghead;    // vars matched to each group, linked
+  vector<int> _vnext, _vprev;
+  vector<int> _glo, _ghi; // groups within the bounds of each var
+  vector<int> _bnd;       // the bounds of the vars, sorted
+
+  // graph search. nodes are the vars, then the groups, then t, which
+  // is the sink of the flow
+  matching::residual _search;
+  vector<int> _vtarget; // for the paths of repair_lower
+  vector<int> _comp;
+  int _ncomp;
+
+  // explanations
+  vector<unsigned char> _excl; // per group, the groups excluded
+  vector<int> _exclpre;        // prefix sums of _excl
+  vector< vec<Lit> > _reasons; // per SCC, computed on demand
+  vector<unsigned char> _rdone;
+  vector<int> _rfilled;
+  vec<Lit> _ps;
 
-  struct rejecting {
-    typedef bool value_type;
-    bool operator()(transition const& t) {
-      return t.q1 == 0;
-    }
-  };
+  int maxgroups() const {
+    return _bounds ? 4*n+2 : umax-umin+1;
+  }
+  int tnode() const { return n+G; }
+  int group_of(int v) const {
+    if( !_bounds ) return v - umin;
+    return std::upper_bound(_gstart.begin(), _gstart.begin()+G+1, v)
+      - _gstart.begin() - 1;
+  }
+  // can var i be matched to group g, given that g is within its bounds
+  bool edge(Solver &s, int i, int g) const {
+    return _bounds || _x[i].indomainUnsafe(s, _gstart[g]);
+  }
+  int cardlb(Solver &s, int c) const {
+    return _card.empty() ? _clb[c] : _card[c].min(s);
+  }
+  int cardub(Solver &s, int c) const {
+    return _card.empty() ? _cub[c] : _card[c].max(s);
+  }
+
+  void build_groups(Solver &s);
+  void build_matching(Solver &s);
+  void assign(int i, int g);
+  bool repair_upper(Solver &s, int i);
+  bool repair_lower(Solver &s, int g);
+
+  // successors of node u in the residual graph, pos is the position
+  // of the iteration, starting from first_pos(u)
+  friend class matching::residual;
+  int first_pos(Solver &s, int u) const;
+  int succ(Solver &s, int u, int& pos) const;
+  bool room(int u) const { return _gcount[u-n] < _gub[u-n]; }
+  int matched_node(int i) const {
+    return _mgroup[i] < 0 ? -1 : int(n) + _mgroup[i];
+  }
+  void match_node(int i, int u) { assign(i, u-n); }
+  void scc_edge(Solver &, int, int) {}
+  void scc_found(Solver &, int const* first, int const* last);
+  void tarjan(Solver &s);
+
+  // x_i takes no value of the excluded groups
+  void explain_excluded(Solver &s, int i, vec<Lit>& ps);
+  void set_excluded_prefix();
+  // the lower or upper bounds of the cardinality vars of group g
+  void explain_card(Solver &s, int g, bool lower, vec<Lit>& ps);
+  // the reason that group g is unsupported for the vars it does not
+  // reach
+  vec<Lit>& reason_for(Solver &s, int g);
+
+  Clause *prune_vars(Solver &s);
+  Clause *prune_card(Solver &s);
+public:
+  cons_gcc(Solver &s, vector<cspvar> const& x,
+           vector<int> const& vals,
+           vector<int> const& lb, vector<int> const& ub,
+           vector<cspvar> const& card, bool bounds);
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
 
-  struct compare_transition {
-    typedef bool value_type;
-    bool operator()(transition t1, transition t2) {
-      // (t1.q0,t1.s,t1.q1) <=lex (t2.q0,t2.s, t2.q1)
-      return t1.q0 < t2.q0 ||
-        (t1.q0 == t2.q0 && (t1.s < t2.s ||
-                            (t1.s == t2.s && t1.q1 <= t2.q1)));
-    }
-  };
+cons_gcc::cons_gcc(Solver &s, vector<cspvar> const& x,
+                   vector<int> const& vals,
+                   vector<int> const& lb, vector<int> const& ub,
+                   vector<cspvar> const& card, bool bounds) :
+  _x(x), n(x.size()), _bounds(bounds), _cval(vals), _clb(lb), _cub(ub),
+  _card(card)
+{
+  set_priority(3);
+  umin = _x[0].min(s);
+  umax = _x[0].max(s);
+  for(size_t i = 0; i != n; ++i) {
+    umin = std::min(umin, _x[i].min(s));
+    umax = std::max(umax, _x[i].max(s));
+    if( _bounds ) {
+      s.schedule_on_lb(_x[i], this);
+      s.schedule_on_ub(_x[i], this);
+    } else
+      s.schedule_on_dom(_x[i], this);
+  }
+  for(size_t c = 0; c != _card.size(); ++c) {
+    s.schedule_on_lb(_card[c], this);
+    s.schedule_on_ub(_card[c], this);
+  }
+
+  int maxg = maxgroups();
+  _gstart.resize(maxg+1);
+  _gcfirst.resize(maxg+1);
+  _glb.resize(maxg);
+  _gub.resize(maxg);
+  _gcount.resize(maxg);
+  _ghead.resize(maxg);
+  _excl.resize(maxg);
+  _exclpre.resize(maxg+1);
+  if( !_bounds ) {
+    G = maxg;
+    for(int g = 0; g <= G; ++g)
+      _gstart[g] = umin+g;
+    for(int g = 0; g <= G; ++g)
+      _gcfirst[g] = std::lower_bound(_cval.begin(), _cval.end(),
+                                     _gstart[g]) - _cval.begin();
+  }
+
+  _match.resize(n, umin-1);
+  _mgroup.resize(n);
+  _vnext.resize(n);
+  _vprev.resize(n);
+  _glo.resize(n);
+  _ghi.resize(n);
+  _vtarget.resize(n);
+
+  int maxnodes = n + maxg + 1;
+  _search.init(n, maxnodes);
+  _comp.resize(maxnodes);
+  _rdone.resize(maxnodes, false);
+  // vec cannot be copied, so the vector is never resized
+  _reasons = vector< vec<Lit> >(maxnodes);
+
+  if( propagate(s) )
+    throw unsat();
+}
 
-  void unfold(automaton const& aut,
-              Solver& solver,
-              vector<cspvar> X,
-              layered_fa& l)
-  {
-    // note for a string of length $n$ we need $n+1$ layers
-    size_t n = X.size();
-    using std::max;
-    size_t ns = 0;
-    for(size_t i = 0; i != aut.d.size(); ++i) {
-      transition const& t = aut.d[i];
-      ns = max(ns, max(t.q0, t.q1));
-    }
+void cons_gcc::clone(Solver &other)
+{
+  cons *con = new cons_gcc(other, _x, _cval, _clb, _cub, _card, _bounds);
+  other.addConstraint(con);
+}
+
+ostream& cons_gcc::print(Solver &s, ostream& os) const
+{
+  os << "gcc([";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]);
+  }
+  os << "], {";
+  for(size_t c = 0; c != _cval.size(); ++c) {
+    if( c ) os << ", ";
+    os << _cval[c] << ": ";
+    if( _card.empty() )
+      os << "[" << _clb[c] << ", " << _cub[c] << "]";
+    else
+      os << cspvar_printer(s, _card[c]);
+  }
+  os << "})";
+  return os;
+}
+
+ostream& cons_gcc::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]) << " in " << domain_as_set(s, _x[i]);
+  }
+  for(size_t c = 0; c != _card.size(); ++c)
+    os << ", " << cspvar_printer(s, _card[c]) << " in "
+       << domain_as_set(s, _card[c]);
+  os << ")";
+  return os;
+}
+
+void cons_gcc::build_groups(Solver &s)
+{
+  if( _bounds ) {
+    // the bounds are singletons, the gaps between them are groups
+    _bnd.clear();
+    for(size_t i = 0; i != n; ++i) {
+      _bnd.push_back(_x[i].min(s));
+      _bnd.push_back(_x[i].max(s));
+    }
+    std::sort(_bnd.begin(), _bnd.end());
+    G = 0;
+    int next = umin;
+    for(size_t j = 0; j != _bnd.size(); ++j) {
+      int b = _bnd[j];
+      if( b < next ) continue;
+      if( b > next )
+        _gstart[G++] = next;
+      _gstart[G++] = b;
+      next = b+1;
+    }
+    if( next <= umax )
+      _gstart[G++] = next;
+    _gstart[G] = umax+1;
+    for(int g = 0; g <= G; ++g)
+      _gcfirst[g] = std::lower_bound(_cval.begin(), _cval.end(),
+                                     _gstart[g]) - _cval.begin();
+  }
+  for(int g = 0; g != G; ++g) {
+    int64_t lb = 0, ub = 0;
+    for(int c = _gcfirst[g]; c != _gcfirst[g+1]; ++c) {
+      lb += cardlb(s, c);
+      ub += cardub(s, c);
+    }
+    int64_t nfree = _gstart[g+1] - _gstart[g] - (_gcfirst[g+1] - _gcfirst[g]);
+    ub += nfree * n;
+    _glb[g] = std::min(lb, int64_t(n+1));
+    _gub[g] = std::min(ub, int64_t(n));
+    _gcount[g] = 0;
+    _ghead[g] = -1;
+  }
+  for(size_t i = 0; i != n; ++i) {
+    _glo[i] = group_of(_x[i].min(s));
+    _ghi[i] = group_of(_x[i].max(s));
+  }
+}
+
+void cons_gcc::assign(int i, int g)
+{
+  int old = _mgroup[i];
+  if( old >= 0 ) {
+    --_gcount[old];
+    if( _vprev[i] >= 0 ) _vnext[_vprev[i]] = _vnext[i];
+    else _ghead[old] = _vnext[i];
+    if( _vnext[i] >= 0 ) _vprev[_vnext[i]] = _vprev[i];
+  }
+  _mgroup[i] = g;
+  if( g < 0 ) return;
+  ++_gcount[g];
+  _vprev[i] = -1;
+  _vnext[i] = _ghead[g];
+  if( _ghead[g] >= 0 ) _vprev[_ghead[g]] = i;
+  _ghead[g] = i;
+  // any value of the group will do, the first one is within the
+  // bounds of i
+  _match[i] = _gstart[g];
+}
+
+void cons_gcc::build_matching(Solver &s)
+{
+  for(size_t i = 0; i != n; ++i) {
+    _mgroup[i] = -1;
+    int v = _match[i];
+    if( v < _x[i].min(s) || v > _x[i].max(s) ) continue;
+    int g = group_of(v);
+    if( !edge(s, i, g) || _gcount[g] >= _gub[g] ) continue;
+    assign(i, g);
+    _match[i] = v;
+  }
+}
+
+bool cons_gcc::repair_upper(Solver &s, int i)
+{
+  if( _search.augment(s, *this, i) )
+    return true;
+
+  // the vars we reached have their domains within the groups we
+  // reached, which are saturated, and they are one too many
+  _ps.clear();
+  for(int g = 0; g != G; ++g) {
+    _excl[g] = !_search.reached(n+g);
+    if( !_excl[g] )
+      explain_card(s, g, false, _ps);
+  }
+  set_excluded_prefix();
+  for(size_t q = 0; q != _search.queue.size(); ++q)
+    if( _search.queue[q] < (int)n )
+      explain_excluded(s, _search.queue[q], _ps);
+  return false;
+}
+
+bool cons_gcc::repair_lower(Solver &s, int g0)
+{
+  vector<int>& queue = _search.queue;
+  vector<int>& stamp = _search.stamp;
+  while( _gcount[g0] < _glb[g0] ) {
+    _search.restart();
+    queue.push_back(g0);
+    stamp[n+g0] = _search.curstamp;
+    for(size_t q = 0; q != queue.size(); ++q) {
+      int h = queue[q];
+      for(size_t y = 0; y != n; ++y) {
+        int h2 = _mgroup[y];
+        if( h2 == h || _search.reached(y) || h < _glo[y] || h > _ghi[y]
+            || !edge(s, y, h) )
+          continue;
+        stamp[y] = _search.curstamp;
+        _vtarget[y] = h;
+        if( _gcount[h2] > _glb[h2] ) {
+          // move y to h, and refill h from the var that reached it
+          for(int z = y;;) {
+            int t = _vtarget[z];
+            assign(z, t);
+            if( t == g0 ) break;
+            z = _search.par[n+t];
+          }
+          goto repaired;
+        }
+        if( !_search.reached(n+h2) ) {
+          stamp[n+h2] = _search.curstamp;
+          _search.par[n+h2] = y;
+          queue.push_back(h2);
+        }
+      }
+    }
+
+    {
+      // only the vars in the groups we reached can take them, and
+      // they are too few
+      _ps.clear();
+      for(int g = 0; g != G; ++g) {
+        _excl[g] = _search.reached(n+g);
+        if( _excl[g] )
+          explain_card(s, g, true, _ps);
+      }
+      set_excluded_prefix();
+      for(size_t y = 0; y != n; ++y)
+        if( !_excl[_mgroup[y]] )
+          explain_excluded(s, y, _ps);
+      return false;
+    }
+  repaired:
+    ;
+  }
+  return true;
+}
+
+int cons_gcc::first_pos(Solver &, int u) const
+{
+  if( u < (int)n ) return _glo[u];
+  if( u < tnode() ) return _ghead[u-n];
+  return 0;
+}
+
+int cons_gcc::succ(Solver &s, int u, int& pos) const
+{
+  if( u < (int)n ) { // var: the groups it is not matched to
+    for(; pos <= _ghi[u]; ++pos)
+      if( pos != _mgroup[u] && edge(s, u, pos) )
+        return n + pos++;
+    return -1;
+  }
+  if( u < tnode() ) { // group: its vars, then t if it has room
+    int g = u-n;
+    if( pos >= 0 ) {
+      int y = pos;
+      pos = _vnext[y];
+      return y;
+    }
+    if( pos == -1 ) {
+      pos = -2;
+      if( _gcount[g] < _gub[g] ) return tnode();
+    }
+    return -1;
+  }
+  // t: the groups above their lower bound
+  for(; pos != G; ++pos)
+    if( _gcount[pos] > _glb[pos] )
+      return n + pos++;
+  return -1;
+}
+
+void cons_gcc::scc_found(Solver &, int const* first, int const* last)
+{
+  for(; first != last; ++first)
+    _comp[*first] = _ncomp;
+  ++_ncomp;
+}
+
+void cons_gcc::tarjan(Solver &s)
+{
+  _ncomp = 0;
+  for(int r = 0; r != tnode()+1; ++r)
+    if( !_search.visited(r) )
+      _search.scc(s, *this, r);
+  _search.clear_scc();
+}
+
+void cons_gcc::set_excluded_prefix()
+{
+  _exclpre[0] = 0;
+  for(int g = 0; g != G; ++g)
+    _exclpre[g+1] = _exclpre[g] + _excl[g];
+}
+
+void cons_gcc::explain_excluded(Solver &s, int i, vec<Lit>& ps)
+{
+  // the bounds may have moved since the groups were built, but they
+  // are still at the start and end of groups
+  cspvar x = _x[i];
+  int lo = group_of(x.min(s)), hi = group_of(x.max(s));
+  if( _exclpre[lo] > 0 )
+    pushifdef(ps, x.r_min(s));
+  if( _exclpre[G] - _exclpre[hi+1] > 0 )
+    pushifdef(ps, x.r_max(s));
+  if( _bounds ) return;
+  for(int g = lo+1; g < hi; ++g)
+    if( _excl[g] ) {
+      assert(!edge(s, i, g));
+      ps.push(x.r_neq(s, _gstart[g]));
+    }
+}
+
+void cons_gcc::explain_card(Solver &s, int g, bool lower, vec<Lit>& ps)
+{
+  if( _card.empty() ) return;
+  for(int c = _gcfirst[g]; c != _gcfirst[g+1]; ++c)
+    pushifdef(ps, lower ? _card[c].r_min(s) : _card[c].r_max(s));
+}
+
+vec<Lit>& cons_gcc::reason_for(Solver &s, int g)
+{
+  int c = _comp[n+g];
+  vec<Lit>& ps = _reasons[c];
+  if( _rdone[c] ) return ps;
+  _rdone[c] = true;
+  _rfilled.push_back(c);
+
+  _search.reach(s, *this, n+g);
+  bool reached_t = _search.reached(tnode());
+  for(int h = 0; h != G; ++h) {
+    _excl[h] = !_search.reached(n+h);
+    if( reached_t ? _excl[h] : !_excl[h] )
+      explain_card(s, h, reached_t, ps);
+  }
+  set_excluded_prefix();
+  for(size_t q = 0; q != _search.queue.size(); ++q)
+    if( _search.queue[q] < (int)n )
+      explain_excluded(s, _search.queue[q], ps);
+  unique_lits(ps, 0);
+  return ps;
+}
+
+Clause *cons_gcc::prune_vars(Solver &s)
+{
+  for(size_t i = 0; i != n; ++i) {
+    cspvar x = _x[i];
+    int ci = _comp[i];
+    if( !_bounds ) {
+      for(int g = _glo[i]; g <= _ghi[i]; ++g) {
+        if( g == _mgroup[i] || _comp[n+g] == ci || !edge(s, i, g) )
+          continue;
+        DO_OR_RETURN(x.removef(s, _gstart[g], reason_for(s, g)));
+      }
+      continue;
+    }
+    int lo = _glo[i], hi = _ghi[i];
+    while( lo != _mgroup[i] && _comp[n+lo] != ci ) ++lo;
+    while( hi != _mgroup[i] && _comp[n+hi] != ci ) --hi;
+    // the groups past the current bounds are excluded by them
+    if( lo != _glo[i] ) {
+      _ps.clear();
+      pushifdef(_ps, x.r_min(s));
+      for(int g = _glo[i]; g != lo; ++g) {
+        vec<Lit>& r = reason_for(s, g);
+        for(int j = 0; j != r.size(); ++j) _ps.push(r[j]);
+      }
+      unique_lits(_ps, 0);
+      DO_OR_RETURN(x.setminf(s, _gstart[lo], _ps));
+    }
+    if( hi != _ghi[i] ) {
+      _ps.clear();
+      pushifdef(_ps, x.r_max(s));
+      for(int g = hi+1; g <= _ghi[i]; ++g) {
+        vec<Lit>& r = reason_for(s, g);
+        for(int j = 0; j != r.size(); ++j) _ps.push(r[j]);
+      }
+      unique_lits(_ps, 0);
+      DO_OR_RETURN(x.setmaxf(s, _gstart[hi+1]-1, _ps));
+    }
+  }
+  return 0L;
+}
+
+Clause *cons_gcc::prune_card(Solver &s)
+{
+  // between the vars fixed to the value and those that can take it
+  for(size_t c = 0; c != _card.size(); ++c) {
+    int v = _cval[c], fixed = 0, possible = 0;
+    for(size_t i = 0; i != n; ++i) {
+      if( _x[i].min(s) == v && _x[i].max(s) == v ) ++fixed;
+      if( _bounds ? _x[i].min(s) <= v && _x[i].max(s) >= v
+          : _x[i].indomain(s, v) )
+        ++possible;
+    }
+    if( _card[c].min(s) < fixed ) {
+      _ps.clear();
+      for(size_t i = 0; i != n; ++i)
+        if( _x[i].min(s) == v && _x[i].max(s) == v ) {
+          pushifdef(_ps, _x[i].r_min(s));
+          pushifdef(_ps, _x[i].r_max(s));
+        }
+      unique_lits(_ps, 0);
+      DO_OR_RETURN(_card[c].setminf(s, fixed, _ps));
+    }
+    if( _card[c].max(s) > possible ) {
+      _ps.clear();
+      for(size_t i = 0; i != n; ++i) {
+        cspvar x = _x[i];
+        if( v < x.min(s) ) pushifdef(_ps, x.r_min(s));
+        else if( v > x.max(s) ) pushifdef(_ps, x.r_max(s));
+        else if( !_bounds && !x.indomain(s, v) ) _ps.push(x.r_neq(s, v));
+      }
+      unique_lits(_ps, 0);
+      DO_OR_RETURN(_card[c].setmaxf(s, possible, _ps));
+    }
+  }
+  return 0L;
+}
+
+Clause *cons_gcc::propagate(Solver &s)
+{
+  build_groups(s);
+  build_matching(s);
+  for(size_t i = 0; i != n; ++i)
+    if( _mgroup[i] < 0 && !repair_upper(s, i) ) {
+      unique_lits(_ps, 0);
+      return s.addInactiveClause(_ps);
+    }
+  for(int g = 0; g != G; ++g)
+    if( !repair_lower(s, g) ) {
+      unique_lits(_ps, 0);
+      return s.addInactiveClause(_ps);
+    }
+
+  tarjan(s);
+  Clause *confl = prune_vars(s);
+  for(size_t j = 0; j != _rfilled.size(); ++j) {
+    _reasons[_rfilled[j]].clear();
+    _rdone[_rfilled[j]] = false;
+  }
+  _rfilled.clear();
+  if( confl ) return confl;
+  return prune_card(s);
+}
+
+void post_gcc_common(Solver &s, vector<cspvar> const& x,
+                     vector<int> const& vals,
+                     vector<int> const& lb, vector<int> const& ub,
+                     vector<cspvar> const& card, consistency c)
+{
+  int n = x.size();
+  int umin = std::numeric_limits<int>::max(),
+    umax = std::numeric_limits<int>::min();
+  for(int i = 0; i != n; ++i) {
+    umin = std::min(umin, x[i].min(s));
+    umax = std::max(umax, x[i].max(s));
+  }
+
+  vector< pair<int, int> > order;
+  for(size_t j = 0; j != vals.size(); ++j)
+    order.push_back(make_pair(vals[j], j));
+  std::sort(order.begin(), order.end());
+  vector<int> pvals, plb, pub;
+  vector<cspvar> pcard;
+  for(size_t k = 0; k != order.size(); ++k) {
+    int v = order[k].first, j = order[k].second;
+    assert( k == 0 || v != order[k-1].first );
+    bool inuniverse = n > 0 && v >= umin && v <= umax;
+    if( !card.empty() ) {
+      cspvar cj = card[j];
+      cj.setmin(s, 0, NO_REASON);
+      cj.setmax(s, inuniverse ? n : 0, NO_REASON);
+    } else if( std::max(lb[j], 0) > std::min(ub[j], inuniverse ? n : 0) )
+      throw unsat();
+    if( !inuniverse ) continue;
+    pvals.push_back(v);
+    if( !card.empty() )
+      pcard.push_back(card[j]);
+    else {
+      plb.push_back(std::max(lb[j], 0));
+      pub.push_back(std::min(ub[j], n));
+    }
+  }
+  if( x.empty() ) return;
+
+  bool bounds = c == CONSISTENCY_BOUNDS ||
+    (c == CONSISTENCY_AUTO && umax - umin >= 256);
+  cons *con = new cons_gcc(s, x, pvals, plb, pub, pcard, bounds);
+  s.addConstraint(con);
+}
+
+void post_gcc(Solver &s, std::vector<cspvar> const& x,
+              std::vector<int> const& vals,
+              std::vector<int> const& lb, std::vector<int> const& ub,
+              consistency c)
+{
+  assert(vals.size() == lb.size() && vals.size() == ub.size());
+  post_gcc_common(s, x, vals, lb, ub, vector<cspvar>(), c);
+}
+
+void post_gcc(Solver &s, std::vector<cspvar> const& x,
+              std::vector<int> const& vals,
+              std::vector<cspvar> const& card, consistency c)
+{
+  assert(vals.size() == card.size());
+  post_gcc_common(s, x, vals, vector<int>(), vector<int>(), card, c);
+}
+
+/* Circuit and subcircuit: x[i] is the successor of node i, shifted
+   by offset. In a subcircuit a node may point to itself, which
+   removes it from the circuit, and the other nodes form a single
+   circuit. A node is mandatory if it cannot point to itself, so in a
+   circuit all nodes are mandatory.
+
+   The values are kept distinct by a separate alldiff. wake_advised()
+   tracks the chains of fixed successors in backtrackable memory and,
+   in a circuit, forbids the edge that would close a chain shorter
+   than n. propagate() checks that the mandatory nodes are in one
+   SCC: all nodes must be reachable from the first mandatory node m
+   and must reach it. A node that fails either check cannot be in the
+   circuit, so it is a failure if it is mandatory and a self loop
+   otherwise. The explanation is the cut: the reachable set has no
+   outgoing edge (resp. the set that reaches m no incoming edge), and
+   m is mandatory.
+*/
+class cons_circuit : public cons
+{
+  vector<cspvar> _x;
+  size_t n;
+  int _offset;
+  bool _sub;
+
+  // for a chain start, its end and size (0 if it is not a chain
+  // start), for a chain end, its start
+  btptr _end_ptr, _size_ptr, _start_ptr;
+
+  // all these are here to avoid allocations
+  vector<unsigned char> _mark;
+  vector<int> _queue;
+  vector<int> _redge, _rfirst; // the reverse edges, by target
+  vec<Lit> _ps, _cut;
+
+  bool mandatory(Solver &s, size_t i) const {
+    return !_x[i].indomain(s, i+_offset);
+  }
+  // push to ps why x[i] takes no value v with _mark[v] == m
+  void explain_avoids(Solver &s, size_t i, unsigned char m, vec<Lit>& ps);
+  // push to ps the fixed successors from chain start u to end e
+  void explain_chain(Solver &s, int u, int e, vec<Lit>& ps);
+  // x[i] was fixed to j, for the reason r (a false literal)
+  Clause *join(Solver &s, int i, int j, Lit r);
+  // mark the nodes that reach (or are reached by) root, ignoring self
+  // loops
+  void reach(Solver &s, int root, bool forward);
+  // the nodes not marked by reach() are out of the circuit
+  Clause *prune_unreached(Solver &s, int root, bool forward);
+public:
+  cons_circuit(Solver &s, vector<cspvar> const& x, int offset, bool sub);
+
+  Clause *wake_advised(Solver &s, Lit p, void *advice);
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+cons_circuit::cons_circuit(Solver &s, vector<cspvar> const& x,
+                           int offset, bool sub) :
+  _x(x), n(x.size()), _offset(offset), _sub(sub)
+{
+  _end_ptr = s.alloc_backtrackable(n*sizeof(int));
+  _size_ptr = s.alloc_backtrackable(n*sizeof(int));
+  _start_ptr = s.alloc_backtrackable(n*sizeof(int));
+  int *end = s.deref_array<int>(_end_ptr);
+  int *size = s.deref_array<int>(_size_ptr);
+  int *start = s.deref_array<int>(_start_ptr);
+  for(size_t i = 0; i != n; ++i) {
+    end[i] = start[i] = i;
+    size[i] = 1;
+  }
+  _mark.resize(n);
+  _rfirst.resize(n+1);
+
+  set_priority(3);
+  for(size_t i = 0; i != n; ++i) {
+    s.schedule_on_dom(_x[i], this);
+    s.wake_on_fix(_x[i], this, (void*)(i+1));
+  }
+
+  for(size_t i = 0; i != n; ++i)
+    if( _x[i].min(s) == _x[i].max(s)
+        && join(s, i, _x[i].min(s)-_offset, _x[i].r_eq(s)) )
+      throw unsat();
+  if( propagate(s) )
+    throw unsat();
+}
+
+void cons_circuit::clone(Solver& other)
+{
+  cons *con = new cons_circuit(other, _x, _offset, _sub);
+  other.addConstraint(con);
+}
+
+ostream& cons_circuit::print(Solver& s, ostream& os) const
+{
+  os << (_sub ? "subcircuit([" : "circuit([");
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]);
+  }
+  os << "], " << _offset << ")";
+  return os;
+}
+
+ostream& cons_circuit::printstate(Solver&s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]) << " in " << domain_as_set(s, _x[i]);
+  }
+  os << ")";
+  return os;
+}
+
+void cons_circuit::explain_avoids(Solver &s, size_t i, unsigned char m,
+                                  vec<Lit>& ps)
+{
+  cspvar x = _x[i];
+  int lo = x.min(s)-_offset, hi = x.max(s)-_offset;
+  for(int v = std::min(lo, (int)n)-1; v >= 0; --v)
+    if( _mark[v] == m ) {
+      pushifdef(ps, x.r_geq(s, v+_offset+1));
+      break;
+    }
+  for(int v = std::max(hi, -1)+1; v < (int)n; ++v)
+    if( _mark[v] == m ) {
+      pushifdef(ps, x.r_leq(s, v+_offset-1));
+      break;
+    }
+  for(int v = std::max(lo, 0); v <= hi && v < (int)n; ++v)
+    if( _mark[v] == m && !x.indomain(s, v+_offset) )
+      ps.push(x.r_neq(s, v+_offset));
+}
+
+void cons_circuit::explain_chain(Solver &s, int u, int e, vec<Lit>& ps)
+{
+  for(; u != e; u = _x[u].min(s)-_offset)
+    ps.push(_x[u].r_eq(s));
+}
+
+Clause *cons_circuit::wake_advised(Solver &s, Lit p, void *advice)
+{
+  domevent de = s.event(p);
+  return join(s, reinterpret_cast<size_t>(advice)-1, de.d-_offset, ~p);
+}
+
+Clause *cons_circuit::join(Solver &s, int i, int j, Lit r)
+{
+  if( j == i ) return 0L;
+
+  int *end = s.deref_array<int>(_end_ptr);
+  int *size = s.deref_array<int>(_size_ptr);
+  int *start = s.deref_array<int>(_start_ptr);
+  // j already has a predecessor: the alldiff fails
+  if( !size[j] ) return 0L;
+
+  int u = start[i], e = end[j];
+  if( u == j ) {
+    // closed a cycle
+    if( _sub || size[j] == (int)n ) return 0L;
+    _ps.clear();
+    explain_chain(s, j, i, _ps);
+    _ps.push(r);
+    return s.addInactiveClause(_ps);
+  }
+  int sz = size[u]+size[j];
+  s.bt_write_array(_end_ptr, u, e);
+  s.bt_write_array(_start_ptr, e, u);
+  s.bt_write_array(_size_ptr, u, sz);
+  s.bt_write_array(_size_ptr, j, 0);
+  if( _sub || sz == (int)n || !_x[e].indomain(s, u+_offset) )
+    return 0L;
+  _ps.clear();
+  explain_chain(s, u, e, _ps);
+  return _x[e].removef(s, u+_offset, _ps);
+}
+
+void cons_circuit::reach(Solver &s, int root, bool forward)
+{
+  for(size_t i = 0; i != n; ++i)
+    _mark[i] = 0;
+  _queue.clear();
+  _queue.push_back(root);
+  _mark[root] = 1;
+  for(size_t q = 0; q != _queue.size(); ++q) {
+    int u = _queue[q];
+    if( forward ) {
+      cspvar x = _x[u];
+      for(int v = x.min(s)-_offset, e = x.max(s)-_offset; v <= e; ++v)
+        if( !_mark[v] && x.indomain(s, v+_offset) ) {
+          _mark[v] = 1;
+          _queue.push_back(v);
+        }
+    } else {
+      for(int k = _rfirst[u]; k != _rfirst[u+1]; ++k) {
+        int v = _redge[k];
+        if( !_mark[v] ) {
+          _mark[v] = 1;
+          _queue.push_back(v);
+        }
+      }
+    }
+  }
+}
+
+Clause *cons_circuit::prune_unreached(Solver &s, int root, bool forward)
+{
+  if( _queue.size() == n ) return 0L;
+  // the cut. Forward, the reached nodes point to reached nodes,
+  // backward the others point to the others (or to themselves)
+  _cut.clear();
+  pushifdef(_cut, _x[root].r_neq(s, root+_offset));
+  for(size_t i = 0; i != n; ++i)
+    if( _mark[i] == forward )
+      explain_avoids(s, i, !forward, _cut);
+  unique_lits(_cut, 0);
+
+  for(size_t i = 0; i != n; ++i) {
+    if( _mark[i] ) continue;
+    if( mandatory(s, i) ) {
+      _cut.copyTo(_ps);
+      _ps.push(_x[i].r_neq(s, i+_offset));
+      return s.addInactiveClause(_ps);
+    }
+    DO_OR_RETURN(_x[i].assignf(s, i+_offset, _cut));
+  }
+  return 0L;
+}
+
+Clause *cons_circuit::propagate(Solver &s)
+{
+  int root = -1;
+  for(size_t i = 0; i != n && root < 0; ++i)
+    if( mandatory(s, i) ) root = i;
+  if( root < 0 ) return 0L;
+
+  reach(s, root, true);
+  DO_OR_RETURN(prune_unreached(s, root, true));
+
+  // the reverse graph, without self loops. _rfirst[v] is first the
+  // end of the edges into v, then moves back to their start
+  for(size_t i = 0; i <= n; ++i)
+    _rfirst[i] = 0;
+  for(size_t i = 0; i != n; ++i) {
+    cspvar x = _x[i];
+    for(int v = x.min(s)-_offset, e = x.max(s)-_offset; v <= e; ++v)
+      if( v != (int)i && x.indomain(s, v+_offset) ) ++_rfirst[v];
+  }
+  for(size_t i = 1; i <= n; ++i)
+    _rfirst[i] += _rfirst[i-1];
+  _redge.resize(_rfirst[n]);
+  for(size_t i = 0; i != n; ++i) {
+    cspvar x = _x[i];
+    for(int v = x.min(s)-_offset, e = x.max(s)-_offset; v <= e; ++v)
+      if( v != (int)i && x.indomain(s, v+_offset) )
+        _redge[--_rfirst[v]] = i;
+  }
+
+  reach(s, root, false);
+  return prune_unreached(s, root, false);
+}
+
+void post_circuit_common(Solver &s, vector<cspvar> const& x, int offset,
+                         bool sub)
+{
+  int n = x.size();
+  if( !n ) return;
+  for(int i = 0; i != n; ++i) {
+    cspvar xi = x[i];
+    xi.setmin(s, offset, NO_REASON);
+    xi.setmax(s, offset+n-1, NO_REASON);
+    if( !sub && n > 1 )
+      xi.remove(s, offset+i, NO_REASON);
+  }
+  post_alldiff(s, x);
+  cons *con = new cons_circuit(s, x, offset, sub);
+  s.addConstraint(con);
+}
+
+void post_circuit(Solver &s, std::vector<cspvar> const& x, int offset)
+{
+  post_circuit_common(s, x, offset, false);
+}
+
+void post_subcircuit(Solver &s, std::vector<cspvar> const& x, int offset)
+{
+  post_circuit_common(s, x, offset, true);
+}
+
+/* Inverse: x[i] = j + yoffset iff y[j] = i + xoffset. If x is
+   shorter than y, only x[i] = j + yoffset -> y[j] = i + xoffset.
+
+   The literal x[i] = j is the literal y[j] = i, so each event is
+   channelled to the other side in O(1) and explained by itself:
+   x[i] != j gives y[j] != i and x[i] = j gives y[j] = i, and the same
+   from y to x. Lazy vars lose the values outside their bounds
+   without NEQ events, so we keep the bounds that we have seen in
+   backtrackable memory and channel the values between them and the
+   new bound, each once.
+*/
+class cons_inverse : public cons
+{
+  vector<cspvar> _x, _y;
+  size_t n, m;
+  int _xoffset, _yoffset;
+  bool _partial;
+
+  // the bounds seen so far, of the vars of x then y
+  btptr _lo_ptr, _hi_ptr;
+
+  vec<Lit> _ps; // here to avoid allocations
+
+  // k indexes x then y
+  cspvar var(size_t k) const { return k < n ? _x[k] : _y[k-n]; }
+  // the values of var k that are indices of the other side. In a
+  // partial inverse y may take others, which are not constrained
+  int first(size_t k) const { return k < n ? _yoffset : _xoffset; }
+  int last(size_t k) const { return first(k) + int(k < n ? m : n) - 1; }
+  // var k lost value v (resp. was fixed to v), for the reason r (a
+  // false literal)
+  Clause *removed(Solver &s, size_t k, int v, Lit r);
+  Clause *fixed(Solver &s, size_t k, int v, Lit r);
+public:
+  cons_inverse(Solver &s, vector<cspvar> const& x, vector<cspvar> const& y,
+               int xoffset, int yoffset);
+
+  Clause *wake_advised(Solver &s, Lit p, void *advice);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+cons_inverse::cons_inverse(Solver &s, vector<cspvar> const& x,
+                           vector<cspvar> const& y,
+                           int xoffset, int yoffset) :
+  _x(x), _y(y), n(x.size()), m(y.size()),
+  _xoffset(xoffset), _yoffset(yoffset), _partial(n < m)
+{
+  _lo_ptr = s.alloc_backtrackable((n+m)*sizeof(int));
+  _hi_ptr = s.alloc_backtrackable((n+m)*sizeof(int));
+  int *lo = s.deref_array<int>(_lo_ptr);
+  int *hi = s.deref_array<int>(_hi_ptr);
+  for(size_t k = 0; k != n+m; ++k) {
+    cspvar xk = var(k);
+    lo[k] = std::max(xk.min(s), first(k));
+    hi[k] = std::min(xk.max(s), last(k));
+    // wake_on_dom() also wakes on the bounds and fix of a lazy var
+    void *advice = (void*)(k+1);
+    s.wake_on_dom(xk, this, advice);
+    if( !s.cspvarlazy(xk) )
+      s.wake_on_fix(xk, this, advice);
+  }
+
+  for(size_t k = 0; k != n+m; ++k) {
+    cspvar xk = var(k);
+    for(int v = first(k); v <= last(k); ++v)
+      if( !xk.indomain(s, v) && removed(s, k, v, xk.r_neq(s, v)) )
+        throw unsat();
+    if( xk.min(s) == xk.max(s) && fixed(s, k, xk.min(s), xk.r_eq(s)) )
+      throw unsat();
+  }
+}
+
+void cons_inverse::clone(Solver& other)
+{
+  cons *con = new cons_inverse(other, _x, _y, _xoffset, _yoffset);
+  other.addConstraint(con);
+}
+
+ostream& cons_inverse::print(Solver& s, ostream& os) const
+{
+  os << "inverse([";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]);
+  }
+  os << "], [";
+  for(size_t j = 0; j != m; ++j) {
+    if( j ) os << ", ";
+    os << cspvar_printer(s, _y[j]);
+  }
+  os << "], " << _xoffset << ", " << _yoffset << ")";
+  return os;
+}
+
+ostream& cons_inverse::printstate(Solver&s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t k = 0; k != n+m; ++k) {
+    if( k ) os << ", ";
+    os << cspvar_printer(s, var(k)) << " in " << domain_as_set(s, var(k));
+  }
+  os << ")";
+  return os;
+}
+
+Clause *cons_inverse::removed(Solver &s, size_t k, int v, Lit r)
+{
+  if( _partial && k < n ) return 0L;
+  _ps.clear();
+  pushifdef(_ps, r);
+  if( k < n ) {
+    int j = v - _yoffset;
+    if( j < 0 || j >= (int)m ) return 0L;
+    return _y[j].removef(s, k + _xoffset, _ps);
+  } else {
+    int i = v - _xoffset;
+    if( i < 0 || i >= (int)n ) return 0L;
+    return _x[i].removef(s, k - n + _yoffset, _ps);
+  }
+}
+
+Clause *cons_inverse::fixed(Solver &s, size_t k, int v, Lit r)
+{
+  if( _partial && k >= n ) return 0L;
+  _ps.clear();
+  pushifdef(_ps, r);
+  if( k < n )
+    return _y[v - _yoffset].assignf(s, k + _xoffset, _ps);
+  else
+    return _x[v - _xoffset].assignf(s, k - n + _yoffset, _ps);
+}
+
+Clause *cons_inverse::wake_advised(Solver &s, Lit p, void *advice)
+{
+  domevent de = s.event(p);
+  size_t k = reinterpret_cast<size_t>(advice)-1;
+  switch(de.type) {
+  case domevent::NEQ:
+    return removed(s, k, de.d, ~p);
+  case domevent::EQ:
+    return fixed(s, k, de.d, ~p);
+  case domevent::GEQ: {
+    int lo = s.deref_array<int>(_lo_ptr)[k];
+    for(int v = lo, e = std::min(de.d, last(k)+1); v < e; ++v)
+      DO_OR_RETURN(removed(s, k, v, ~p));
+    if( de.d > lo )
+      s.bt_write_array(_lo_ptr, k, de.d);
+    return 0L;
+  }
+  case domevent::LEQ: {
+    int hi = s.deref_array<int>(_hi_ptr)[k];
+    for(int v = hi, e = std::max(de.d, first(k)-1); v > e; --v)
+      DO_OR_RETURN(removed(s, k, v, ~p));
+    if( de.d < hi )
+      s.bt_write_array(_hi_ptr, k, de.d);
+    return 0L;
+  }
+  case domevent::NONE:
+    assert(0);
+  }
+  return 0L;
+}
+
+void post_inverse(Solver &s, std::vector<cspvar> const& x,
+                  std::vector<cspvar> const& y, int xoffset, int yoffset)
+{
+  if( x.size() > y.size() )
+    throw unsat();
+  if( x.empty() ) return;
+  for(size_t i = 0; i != x.size(); ++i) {
+    cspvar xi = x[i];
+    xi.setmin(s, yoffset, NO_REASON);
+    xi.setmax(s, yoffset+y.size()-1, NO_REASON);
+  }
+  // in a partial inverse, y may take values that are not indices of x
+  for(size_t j = 0; x.size() == y.size() && j != y.size(); ++j) {
+    cspvar yj = y[j];
+    yj.setmin(s, xoffset, NO_REASON);
+    yj.setmax(s, xoffset+x.size()-1, NO_REASON);
+  }
+  cons *con = new cons_inverse(s, x, y, xoffset, yoffset);
+  s.addConstraint(con);
+}
+
+/* Channel between Booleans and a var: b[i] = 1 iff x = i + offset.
+   Like inverse, each event gives one pruning, explained by it */
+class cons_channel : public cons
+{
+  vector<cspvar> _b;
+  cspvar _x;
+  int _offset;
+
+  // the bounds of x seen so far
+  btptr _lo_ptr, _hi_ptr;
+
+  vec<Lit> _ps; // here to avoid allocations
+
+  // x lost value v (resp. was fixed to v), for the reason r
+  Clause *removed(Solver &s, int v, Lit r);
+  Clause *fixed(Solver &s, int v, Lit r);
+public:
+  cons_channel(Solver &s, vector<cspvar> const& b, cspvar x, int offset);
+
+  Clause *wake_advised(Solver &s, Lit p, void *advice);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+cons_channel::cons_channel(Solver &s, vector<cspvar> const& b, cspvar x,
+                           int offset) :
+  _b(b), _x(x), _offset(offset)
+{
+  _lo_ptr = s.alloc_backtrackable(sizeof(int));
+  _hi_ptr = s.alloc_backtrackable(sizeof(int));
+  s.deref<int>(_lo_ptr) = _x.min(s);
+  s.deref<int>(_hi_ptr) = _x.max(s);
+
+  // the Booleans have advice i+1, x the one after them
+  void *xadvice = (void*)(_b.size()+1);
+  s.wake_on_dom(_x, this, xadvice);
+  if( !s.cspvarlazy(_x) )
+    s.wake_on_fix(_x, this, xadvice);
+  for(size_t i = 0; i != _b.size(); ++i)
+    s.wake_on_fix(_b[i], this, (void*)(i+1));
+
+  for(size_t i = 0; i != _b.size(); ++i) {
+    int v = i + _offset;
+    if( !_x.indomain(s, v) && removed(s, v, _x.r_neq(s, v)) )
+      throw unsat();
+    if( _b[i].min(s) == _b[i].max(s) ) {
+      _ps.clear();
+      pushifdef(_ps, _b[i].r_eq(s));
+      if( _b[i].min(s) ? _x.assignf(s, v, _ps) : _x.removef(s, v, _ps) )
+        throw unsat();
+    }
+  }
+  if( _x.min(s) == _x.max(s) && fixed(s, _x.min(s), _x.r_eq(s)) )
+    throw unsat();
+}
+
+void cons_channel::clone(Solver& other)
+{
+  cons *con = new cons_channel(other, _b, _x, _offset);
+  other.addConstraint(con);
+}
+
+ostream& cons_channel::print(Solver& s, ostream& os) const
+{
+  os << "channel([";
+  for(size_t i = 0; i != _b.size(); ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _b[i]);
+  }
+  os << "], " << cspvar_printer(s, _x) << ", " << _offset << ")";
+  return os;
+}
+
+ostream& cons_channel::printstate(Solver&s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t i = 0; i != _b.size(); ++i)
+    os << cspvar_printer(s, _b[i]) << " in " << domain_as_set(s, _b[i])
+       << ", ";
+  os << cspvar_printer(s, _x) << " in " << domain_as_set(s, _x) << ")";
+  return os;
+}
+
+Clause *cons_channel::removed(Solver &s, int v, Lit r)
+{
+  int i = v - _offset;
+  if( i < 0 || i >= (int)_b.size() ) return 0L;
+  _ps.clear();
+  pushifdef(_ps, r);
+  return _b[i].setmaxf(s, 0, _ps);
+}
+
+Clause *cons_channel::fixed(Solver &s, int v, Lit r)
+{
+  _ps.clear();
+  pushifdef(_ps, r);
+  return _b[v - _offset].setminf(s, 1, _ps);
+}
+
+Clause *cons_channel::wake_advised(Solver &s, Lit p, void *advice)
+{
+  domevent de = s.event(p);
+  size_t i = reinterpret_cast<size_t>(advice)-1;
+  if( i != _b.size() ) {
+    // a Boolean was fixed
+    _ps.clear();
+    _ps.push(~p);
+    if( de.d )
+      return _x.assignf(s, i + _offset, _ps);
+    return _x.removef(s, i + _offset, _ps);
+  }
+  switch(de.type) {
+  case domevent::NEQ:
+    return removed(s, de.d, ~p);
+  case domevent::EQ:
+    return fixed(s, de.d, ~p);
+  case domevent::GEQ: {
+    int lo = s.deref<int>(_lo_ptr);
+    for(int v = lo; v < de.d; ++v)
+      DO_OR_RETURN(removed(s, v, ~p));
+    if( de.d > lo )
+      s.bt_write(_lo_ptr, de.d);
+    return 0L;
+  }
+  case domevent::LEQ: {
+    int hi = s.deref<int>(_hi_ptr);
+    for(int v = hi; v > de.d; --v)
+      DO_OR_RETURN(removed(s, v, ~p));
+    if( de.d < hi )
+      s.bt_write(_hi_ptr, de.d);
+    return 0L;
+  }
+  case domevent::NONE:
+    assert(0);
+  }
+  return 0L;
+}
+
+void post_channel(Solver &s, std::vector<cspvar> const& b, cspvar x,
+                  int offset)
+{
+  if( b.empty() )
+    throw unsat();
+  for(size_t i = 0; i != b.size(); ++i) {
+    cspvar bi = b[i];
+    bi.setmin(s, 0, NO_REASON);
+    bi.setmax(s, 1, NO_REASON);
+  }
+  x.setmin(s, offset, NO_REASON);
+  x.setmax(s, offset+b.size()-1, NO_REASON);
+  cons *con = new cons_channel(s, b, x, offset);
+  s.addConstraint(con);
+}
+
+/* Regular */
+namespace regular {
+  struct layered_fa {
+    vector<transition> d;     // all transitions, ordered by layer
+    vector<int> layer_trans;  // an index into the beginning of each
+                              // layer in d
+    vector<int> layer_states; // the first state of each layer
+    vector<int> state_trans;  // index of first transition of each state
+    vector<int> state_layer;  // the layer of each state
+    int q0;
+    set<int> F;
+
+    int nlayers() const { return layer_states.size()-1; }
+  };
+
+  struct rejecting {
+    typedef bool value_type;
+    bool operator()(transition const& t) {
+      return t.q1 == 0;
+    }
+  };
+
+  struct compare_transition {
+    typedef bool value_type;
+    bool operator()(transition t1, transition t2) {
+      // (t1.q0,t1.s,t1.q1) <=lex (t2.q0,t2.s, t2.q1)
+      return t1.q0 < t2.q0 ||
+        (t1.q0 == t2.q0 && (t1.s < t2.s ||
+                            (t1.s == t2.s && t1.q1 <= t2.q1)));
+    }
+  };
+
+  void unfold(automaton const& aut,
+              Solver& solver,
+              vector<cspvar> X,
+              layered_fa& l)
+  {
+    // note for a string of length $n$ we need $n+1$ layers
+    size_t n = X.size();
+    using std::max;
+    size_t ns = 0;
+    for(size_t i = 0; i != aut.d.size(); ++i) {
+      transition const& t = aut.d[i];
+      ns = max(ns, max(t.q0, t.q1));
+    }
 
     vector<transition> d = aut.d;
     sort(d.begin(), d.end(), compare_transition());
@@ -3353,6 +5879,8 @@ namespace regular {
       transition& t = l.d[i];
       ns = max(ns, max(t.q0, t.q1));
     }
+    // states without transitions still get an entry
+    ns = max(ns, size_t(l.layer_states.back()));
 
     size_t accepting=0; // all accepting states are merged into one
     vector<int> remap(ns+1);
@@ -3444,11 +5972,365 @@ namespace regular {
     if( var == var_Undef )
       var = s.newVar();
   }
-};
+};
+
+/* MDD propagator on the layered graph of a regular constraint, which
+   enforces GAC (in the spirit of MDD-4R, Perez and Regin)
+
+   An arc is alive while its value is in the domain of the var of its
+   layer and both of its nodes are alive. A node other than the root
+   (resp. the accepting node) is alive while it has an alive incoming
+   (resp. outgoing) arc. The arc, node and (layer, value) counts are
+   kept in backtrackable memory and are only decremented, so the work
+   of a branch is proportional to the arcs it kills. A value with no
+   alive arc in the layer of its var is pruned.
+
+   The reason for x != a, from layer i, is a cut of the graph: the
+   removed values of the arcs that leave the nodes of layers < i that
+   were reachable from the root, and of the arcs that enter the nodes
+   of layers > i that could reach the accepting node, when x != a was
+   pruned. It is computed on demand if all vars are eager.
+*/
+class cons_mdd : public cons, public explainer {
+  vector<cspvar> _x;
+  size_t n;
+  bool _deferred;
+
+  int _root, _term;
+  vector<int> _nlayer;                // the layer of each node
+  vector<int> _afrom, _ato, _aval;    // the arcs
+  vector<int> _outfirst, _outarcs;    // arcs of each node
+  vector<int> _infirst, _inarcs;
+  // per layer, the first value and the index of its first (layer, value)
+  vector<int> _vmin, _vbase;
+  vector<int> _lvfirst, _lvarcs;      // arcs of each (layer, value)
+
+  btptr _alive;     // char per arc
+  btptr _outdeg;    // int per node, alive outgoing arcs
+  btptr _indeg;     // int per node, alive incoming arcs
+  btptr _lvcount;   // int per (layer, value), alive arcs
+  btptr _size;      // int per layer, domain size when last scanned
+
+  vector<int> _deadnodes;   // nodes to kill
+  vector<int> _unsupported; // (layer, value)s that lost their last arc
+
+  vector<int> _stamp;       // per node, reached in reach()
+  int _curstamp;
+  vector<int> _queue;
+  vec<Lit> _ps;
+
+  int lvidx(int i, int v) const { return _vbase[i] + v - _vmin[i]; }
+  bool lazy(Solver &s, size_t i) { return s.cspvarlazy(_x[i]); }
+
+  void kill_arc(Solver &s, int a);
+  void kill_node(Solver &s, int u);
+  Lit removed(Solver &s, int a, int t);
+  // mark with stamp (forward) the nodes of layers < upto reachable
+  // from the root through arcs not removed at t, or (backward) those
+  // of layers > upto that reach the accepting node, and append the
+  // cut to c
+  void reach(Solver &s, bool forward, int upto, int t, int stamp,
+             vec<Lit>& c);
+  // the reason that no arc of (i, v) is alive at t. false if it
+  // does not hold
+  bool explain_value(Solver &s, int i, int v, int t, vec<Lit>& c);
+public:
+  cons_mdd(Solver &s, vector<cspvar> const& x,
+           regular::layered_fa const& l, set<size_t> const& r);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+
+  void explain(Solver& s, Lit p, vec<Lit>& c);
+  void use() {}
+  void release() {}
+};
+
+cons_mdd::cons_mdd(Solver &s, vector<cspvar> const& x,
+                   regular::layered_fa const& l, set<size_t> const& r) :
+  _x(x), n(x.size()), _deferred(true), _curstamp(0)
+{
+  // renumber the reachable states
+  map<size_t, int> node;
+  for(set<size_t>::const_iterator i = r.begin(); i != r.end(); ++i) {
+    int u = node.size();
+    node[*i] = u;
+    _nlayer.push_back(l.state_layer[*i]);
+  }
+  int nnodes = node.size();
+  _root = node[l.q0];
+  _term = node[*l.F.begin()];
+  for(set<size_t>::const_iterator i = r.begin(); i != r.end(); ++i)
+    for(int t = l.state_trans[*i]; t != l.state_trans[*i+1]; ++t) {
+      regular::transition const& tr = l.d[t];
+      if( tr.q1 == 0 ) continue;
+      _afrom.push_back(node[tr.q0]);
+      _ato.push_back(node[tr.q1]);
+      _aval.push_back(tr.s);
+    }
+  int narcs = _afrom.size();
+
+  _vmin.resize(n);
+  _vbase.resize(n+1);
+  _vbase[0] = 0;
+  for(size_t i = 0; i != n; ++i) {
+    if( lazy(s, i) ) _deferred = false;
+    _vmin[i] = _x[i].min(s);
+    _vbase[i+1] = _vbase[i] + _x[i].max(s) - _x[i].min(s) + 1;
+  }
+  int nvals = _vbase[n];
+
+  // the arcs of each node and each (layer, value), by counting sort
+  _outfirst.assign(nnodes+1, 0);
+  _infirst.assign(nnodes+1, 0);
+  _lvfirst.assign(nvals+1, 0);
+  for(int a = 0; a != narcs; ++a) {
+    ++_outfirst[_afrom[a]+1];
+    ++_infirst[_ato[a]+1];
+    ++_lvfirst[lvidx(_nlayer[_afrom[a]], _aval[a])+1];
+  }
+  for(int u = 0; u != nnodes; ++u) {
+    _outfirst[u+1] += _outfirst[u];
+    _infirst[u+1] += _infirst[u];
+  }
+  for(int k = 0; k != nvals; ++k)
+    _lvfirst[k+1] += _lvfirst[k];
+  _outarcs.resize(narcs);
+  _inarcs.resize(narcs);
+  _lvarcs.resize(narcs);
+  vector<int> outfill(_outfirst), infill(_infirst), lvfill(_lvfirst);
+  for(int a = 0; a != narcs; ++a) {
+    _outarcs[outfill[_afrom[a]]++] = a;
+    _inarcs[infill[_ato[a]]++] = a;
+    _lvarcs[lvfill[lvidx(_nlayer[_afrom[a]], _aval[a])]++] = a;
+  }
+
+  _alive = s.alloc_backtrackable(narcs);
+  _outdeg = s.alloc_backtrackable(nnodes*sizeof(int));
+  _indeg = s.alloc_backtrackable(nnodes*sizeof(int));
+  _lvcount = s.alloc_backtrackable(nvals*sizeof(int));
+  _size = s.alloc_backtrackable(n*sizeof(int));
+  char *alive = s.deref_array<char>(_alive);
+  int *outdeg = s.deref_array<int>(_outdeg);
+  int *indeg = s.deref_array<int>(_indeg);
+  int *lvcount = s.deref_array<int>(_lvcount);
+  int *size = s.deref_array<int>(_size);
+  for(int a = 0; a != narcs; ++a)
+    alive[a] = true;
+  for(int u = 0; u != nnodes; ++u) {
+    outdeg[u] = _outfirst[u+1] - _outfirst[u];
+    indeg[u] = _infirst[u+1] - _infirst[u];
+  }
+  for(int k = 0; k != nvals; ++k) {
+    lvcount[k] = _lvfirst[k+1] - _lvfirst[k];
+    if( !lvcount[k] ) _unsupported.push_back(k);
+  }
+  // a size that no domain has, so that the first call looks at all
+  for(size_t i = 0; i != n; ++i)
+    size[i] = -1;
+  _stamp.assign(nnodes, 0);
+
+  for(size_t i = 0; i != n; ++i)
+    s.schedule_on_dom(_x[i], this);
+  if( propagate(s) )
+    throw unsat();
+}
+
+void cons_mdd::kill_arc(Solver &s, int a)
+{
+  if( !s.deref_array<char>(_alive)[a] ) return;
+  s.bt_write_array<char>(_alive, a, false);
+  int u = _afrom[a], w = _ato[a];
+  int& od = s.deref_array_mut<int>(_outdeg, u);
+  if( --od == 0 && u != _term ) _deadnodes.push_back(u);
+  int& id = s.deref_array_mut<int>(_indeg, w);
+  if( --id == 0 && w != _root ) _deadnodes.push_back(w);
+  int k = lvidx(_nlayer[u], _aval[a]);
+  int& lc = s.deref_array_mut<int>(_lvcount, k);
+  if( --lc == 0 ) _unsupported.push_back(k);
+}
+
+void cons_mdd::kill_node(Solver &s, int u)
+{
+  for(int p = _outfirst[u]; p != _outfirst[u+1]; ++p)
+    kill_arc(s, _outarcs[p]);
+  for(int p = _infirst[u]; p != _infirst[u+1]; ++p)
+    kill_arc(s, _inarcs[p]);
+}
+
+Lit cons_mdd::removed(Solver &s, int a, int t)
+{
+  cspvar x = _x[_nlayer[_afrom[a]]];
+  int v = _aval[a];
+  if( !_deferred )
+    return x.indomain(s, v) ? lit_Undef : x.r_neq(s, v);
+  return deferred::removed_at(s, x, v, t);
+}
+
+void cons_mdd::reach(Solver &s, bool forward, int upto, int t, int stamp,
+                     vec<Lit>& c)
+{
+  vector<int> const& first = forward ? _outfirst : _infirst;
+  vector<int> const& arcs = forward ? _outarcs : _inarcs;
+  vector<int> const& next = forward ? _ato : _afrom;
+
+  _queue.clear();
+  int start = forward ? _root : _term;
+  _stamp[start] = stamp;
+  _queue.push_back(start);
+  for(size_t q = 0; q != _queue.size(); ++q) {
+    int u = _queue[q];
+    if( forward ? _nlayer[u] >= upto : _nlayer[u] <= upto ) continue;
+    for(int p = first[u]; p != first[u+1]; ++p) {
+      int a = arcs[p], w = next[a];
+      if( _stamp[w] == stamp || removed(s, a, t) != lit_Undef ) continue;
+      _stamp[w] = stamp;
+      _queue.push_back(w);
+    }
+  }
+  for(size_t q = 0; q != _queue.size(); ++q) {
+    int u = _queue[q];
+    if( forward ? _nlayer[u] >= upto : _nlayer[u] <= upto ) continue;
+    for(int p = first[u]; p != first[u+1]; ++p) {
+      int a = arcs[p];
+      if( _stamp[next[a]] == stamp ) continue;
+      c.push( removed(s, a, t) );
+    }
+  }
+}
+
+bool cons_mdd::explain_value(Solver &s, int i, int v, int t, vec<Lit>& c)
+{
+  int cbeg = c.size();
+  int fstamp = ++_curstamp;
+  reach(s, true, i, t, fstamp, c);
+  int bstamp = ++_curstamp;
+  reach(s, false, i+1, t, bstamp, c);
+  unique_lits(c, cbeg);
+  int k = lvidx(i, v);
+  for(int p = _lvfirst[k]; p != _lvfirst[k+1]; ++p) {
+    int a = _lvarcs[p];
+    if( _stamp[_afrom[a]] == fstamp && _stamp[_ato[a]] == bstamp ) {
+      c.shrink(c.size() - cbeg);
+      return false;
+    }
+  }
+  return true;
+}
+
+void cons_mdd::explain(Solver &s, Lit p, vec<Lit>& c)
+{
+  domevent pe = s.event(p);
+  c.push(p);
+  // the var may be in several layers, any one of them explains it
+  for(size_t i = 0; i != n; ++i)
+    if( _x[i].id() == pe.x.id() &&
+        explain_value(s, i, pe.d, s.varTrailPos(p), c) )
+      return;
+  assert(0);
+}
+
+Clause *cons_mdd::propagate(Solver &s)
+{
+  int const *size = s.deref_array<int>(_size);
+  for(size_t i = 0; i != n; ++i) {
+    cspvar x = _x[i];
+    if( !lazy(s, i) && x.domsize(s) == size[i] ) continue;
+    s.bt_write_array<int>(_size, i, x.domsize(s));
+    size = s.deref_array<int>(_size);
+    for(int v = _vmin[i], vend = _vmin[i] + _vbase[i+1] - _vbase[i];
+        v != vend; ++v) {
+      if( x.indomain(s, v) ) continue;
+      int k = lvidx(i, v);
+      if( !s.deref_array<int>(_lvcount)[k] ) continue;
+      for(int p = _lvfirst[k]; p != _lvfirst[k+1]; ++p)
+        kill_arc(s, _lvarcs[p]);
+    }
+  }
+  while( !_deadnodes.empty() ) {
+    int u = _deadnodes.back();
+    _deadnodes.pop_back();
+    kill_node(s, u);
+  }
+
+  if( !s.deref_array<int>(_outdeg)[_root] ) {
+    _unsupported.clear();
+    _ps.clear();
+    // the accepting node is not reachable
+    reach(s, true, n+1, s.nAssigns(), ++_curstamp, _ps);
+    unique_lits(_ps, 0);
+    return s.addInactiveClause(_ps);
+  }
+
+  while( !_unsupported.empty() ) {
+    int k = _unsupported.back();
+    _unsupported.pop_back();
+    size_t i = std::upper_bound(_vbase.begin(), _vbase.end(), k)
+      - _vbase.begin() - 1;
+    cspvar x = _x[i];
+    int v = _vmin[i] + k - _vbase[i];
+    if( !x.indomain(s, v) ) continue;
+    if( _deferred && x.min(s) != x.max(s) ) {
+      s.uncheckedEnqueueDeferred(~Lit(x.eqiUnsafe(s, v)), this);
+      continue;
+    }
+    _ps.clear();
+    explain_value(s, i, v, s.nAssigns(), _ps);
+    Clause *confl = x.removef(s, v, _ps);
+    if( confl ) {
+      _unsupported.clear();
+      return confl;
+    }
+  }
+  return 0L;
+}
+
+void cons_mdd::clone(Solver &other)
+{
+  // the same graph, as an automaton: node u is state u+1
+  vector<regular::transition> d;
+  for(size_t a = 0; a != _afrom.size(); ++a)
+    d.push_back(regular::transition(_afrom[a]+1, _aval[a], _ato[a]+1));
+  set<int> F;
+  F.insert(_term+1);
+  regular::automaton aut(d, _root+1, F);
+  post_regular(other, _x, aut, true, true);
+}
+
+ostream& cons_mdd::print(Solver &s, ostream& os) const
+{
+  os << "mdd([";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]);
+  }
+  os << "], " << _nlayer.size() << " nodes, " << _afrom.size() << " arcs)";
+  return os;
+}
+
+ostream& cons_mdd::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  int const *outdeg = s.deref_array<int>(_outdeg);
+  int const *indeg = s.deref_array<int>(_indeg);
+  int alive = 0;
+  for(size_t u = 0; u != _nlayer.size(); ++u)
+    alive += (outdeg[u] > 0 || int(u) == _term) &&
+      (indeg[u] > 0 || int(u) == _root);
+  os << " (with ";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]) << " in " << domain_as_set(s, _x[i]);
+  }
+  os << ", " << alive << " nodes alive)";
+  return os;
+}
 
 void post_regular(Solver &s, vector< cspvar > const& vars,
                   regular::automaton const& aut,
-                  bool gac)
+                  bool gac, bool mdd)
 {
   using namespace regular;
   layered_fa l;
@@ -3463,6 +6345,12 @@ void post_regular(Solver &s, vector< cspvar > const& vars,
   if( r.find(*l.F.begin()) == r.end() )
     throw unsat();
 
+  if( mdd && !vars.empty() ) {
+    cons *con = new cons_mdd(s, vars, l, r);
+    s.addConstraint(con);
+    return;
+  }
+
   vector<Var> sv(l.state_trans.size(), var_Undef); // State variables
   vector<Var> tv(l.d.size(), var_Undef); // Transition variables
 
@@ -3587,15 +6475,306 @@ namespace cumulative {
   std::map<Solver *, running_map> solver_running;
 }
 
+/* cons_cumulative
+
+   Native cumulative with timetable filtering. The compulsory part of
+   task i is [max(s[i]), min(s[i])+min(d[i])), during which it surely
+   runs and uses at least min(r[i]) of the resource. The profile is
+   the sum of the compulsory parts, kept as a sorted list of segments
+   of constant height.
+
+   A segment higher than max(c) is a failure, the highest segment is a
+   lower bound for c, and a task that would overload a segment it does
+   not already cover cannot overlap it, so its start is pushed past
+   it, or its end pushed before it.
+
+   Every explanation is built from the x >= d and x <= d literals of
+   the starts, durations and requirements: a task j covers [a, b) if
+   s[j] <= a and s[j] >= b-d[j], and only as many of the tasks that
+   cover a segment as are needed to exceed the capacity are used.
+*/
+class cons_cumulative : public cons {
+  struct segment {
+    int a, b; // [a, b)
+    int h;
+  };
+
+  vector<cspvar> _start, _dur, _req;
+  cspvar _cap;
+
+  // the bounds of each task when propagate() started
+  vector<int> _smin, _smax, _dmin, _rmin;
+  vector< pair<int, int> > _events;
+  vector<segment> _profile;
+  vec<Lit> _ps;
+
+  // whether the compulsory part of task j contains [a, b)
+  bool covers(size_t j, int a, int b) const;
+  // push to _ps 'x >= d' or 'x <= d', unless it holds at the root
+  void pushgeq(Solver &s, cspvar x, int d);
+  void pushleq(Solver &s, cspvar x, int d);
+  // push to _ps the reason that task j covers [a, b)
+  void explain_task(Solver &s, size_t j, int a, int b);
+  // push to _ps the reason that the tasks other than skip that cover
+  // [a, b) need at least 'need' of the resource there
+  void explain_segment(Solver &s, size_t skip, int a, int b, int need);
+  void build_profile(Solver &s);
+  Clause *prune_start(Solver &s, size_t i, int cmax);
+  Clause *prune_end(Solver &s, size_t i, int cmax);
+public:
+  cons_cumulative(Solver &s, vector<cspvar> const& start,
+                  vector<cspvar> const& dur,
+                  vector<cspvar> const& req,
+                  cspvar cap);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+cons_cumulative::cons_cumulative(Solver &s, vector<cspvar> const& start,
+                                 vector<cspvar> const& dur,
+                                 vector<cspvar> const& req,
+                                 cspvar cap) :
+  _start(start), _dur(dur), _req(req), _cap(cap)
+{
+  const size_t n = _start.size();
+  _smin.resize(n);
+  _smax.resize(n);
+  _dmin.resize(n);
+  _rmin.resize(n);
+  for(size_t i = 0; i != n; ++i) {
+    s.schedule_on_lb(_start[i], this);
+    s.schedule_on_ub(_start[i], this);
+    s.schedule_on_lb(_dur[i], this);
+    s.schedule_on_lb(_req[i], this);
+  }
+  s.schedule_on_ub(_cap, this);
+  if( propagate(s) )
+    throw unsat();
+}
+
+bool cons_cumulative::covers(size_t j, int a, int b) const
+{
+  return _dmin[j] > 0 && _rmin[j] > 0 &&
+    _smax[j] <= a && _smin[j] + _dmin[j] >= b;
+}
+
+void cons_cumulative::pushgeq(Solver &s, cspvar x, int d)
+{
+  if( d > x.omin(s) )
+    _ps.push( x.r_geq(s, d) );
+}
+
+void cons_cumulative::pushleq(Solver &s, cspvar x, int d)
+{
+  if( d < x.omax(s) )
+    _ps.push( x.r_leq(s, d) );
+}
+
+void cons_cumulative::explain_task(Solver &s, size_t j, int a, int b)
+{
+  pushleq(s, _start[j], a);
+  pushgeq(s, _start[j], b - _dmin[j]);
+  pushgeq(s, _dur[j], _dmin[j]);
+  pushgeq(s, _req[j], _rmin[j]);
+}
+
+void cons_cumulative::explain_segment(Solver &s, size_t skip, int a, int b,
+                                      int need)
+{
+  int h = 0;
+  for(size_t j = 0; j != _start.size() && h < need; ++j) {
+    if( j == skip || !covers(j, a, b) ) continue;
+    explain_task(s, j, a, b);
+    h += _rmin[j];
+  }
+  assert(h >= need);
+}
+
+void cons_cumulative::build_profile(Solver &s)
+{
+  _events.clear();
+  _profile.clear();
+  for(size_t i = 0; i != _start.size(); ++i) {
+    _smin[i] = _start[i].min(s);
+    _smax[i] = _start[i].max(s);
+    _dmin[i] = std::max(0, _dur[i].min(s));
+    _rmin[i] = std::max(0, _req[i].min(s));
+    if( _rmin[i] == 0 || _smax[i] >= _smin[i] + _dmin[i] ) continue;
+    _events.push_back( make_pair(_smax[i], _rmin[i]) );
+    _events.push_back( make_pair(_smin[i] + _dmin[i], -_rmin[i]) );
+  }
+  std::sort(_events.begin(), _events.end());
+
+  int h = 0;
+  for(size_t e = 0; e != _events.size(); ) {
+    int t = _events[e].first;
+    for(; e != _events.size() && _events[e].first == t; ++e)
+      h += _events[e].second;
+    if( h > 0 ) {
+      assert(e != _events.size());
+      segment seg = { t, _events[e].first, h };
+      _profile.push_back(seg);
+    }
+  }
+}
+
+Clause *cons_cumulative::prune_start(Solver &s, size_t i, int cmax)
+{
+  int lb = _smin[i];
+  for(size_t k = 0; k != _profile.size(); ++k) {
+    segment const& seg = _profile[k];
+    if( seg.b <= lb ) continue;
+    if( seg.a >= lb + _dmin[i] ) break;
+    if( seg.h + _rmin[i] <= cmax || covers(i, seg.a, seg.b) ) continue;
+    // task i cannot overlap [a, b) if it starts at lb or later
+    int a = std::max(seg.a, lb);
+    _ps.clear();
+    explain_segment(s, i, a, seg.b, cmax - _rmin[i] + 1);
+    pushleq(s, _cap, cmax);
+    pushgeq(s, _dur[i], _dmin[i]);
+    pushgeq(s, _req[i], _rmin[i]);
+    pushgeq(s, _start[i], a - _dmin[i] + 1);
+    if( seg.b > _start[i].max(s) ) {
+      pushleq(s, _start[i], _start[i].max(s));
+      return s.addInactiveClause(_ps);
+    }
+    _ps.push( _start[i].e_geq(s, seg.b) );
+    DO_OR_RETURN(_start[i].setmin(s, seg.b, _ps));
+    lb = seg.b;
+  }
+  return 0L;
+}
+
+Clause *cons_cumulative::prune_end(Solver &s, size_t i, int cmax)
+{
+  int ub = _smax[i];
+  for(size_t k = _profile.size(); k-- != 0; ) {
+    segment const& seg = _profile[k];
+    if( seg.a >= ub + _dmin[i] ) continue;
+    if( seg.b <= ub ) break;
+    if( seg.h + _rmin[i] <= cmax || covers(i, seg.a, seg.b) ) continue;
+    // task i cannot overlap [a, b) if it starts at ub or earlier
+    int b = std::min(seg.b, ub + _dmin[i]);
+    _ps.clear();
+    explain_segment(s, i, seg.a, b, cmax - _rmin[i] + 1);
+    pushleq(s, _cap, cmax);
+    pushgeq(s, _dur[i], _dmin[i]);
+    pushgeq(s, _req[i], _rmin[i]);
+    pushleq(s, _start[i], b - 1);
+    if( seg.a - _dmin[i] < _start[i].min(s) ) {
+      pushgeq(s, _start[i], _start[i].min(s));
+      return s.addInactiveClause(_ps);
+    }
+    _ps.push( _start[i].e_leq(s, seg.a - _dmin[i]) );
+    DO_OR_RETURN(_start[i].setmax(s, seg.a - _dmin[i], _ps));
+    ub = seg.a - _dmin[i];
+  }
+  return 0L;
+}
+
+Clause *cons_cumulative::propagate(Solver &s)
+{
+  build_profile(s);
+  if( _profile.empty() ) return 0L;
+
+  int cmax = _cap.max(s);
+  size_t top = 0;
+  for(size_t k = 0; k != _profile.size(); ++k) {
+    segment const& seg = _profile[k];
+    if( seg.h > cmax ) {
+      _ps.clear();
+      explain_segment(s, _start.size(), seg.a, seg.b, cmax + 1);
+      pushleq(s, _cap, cmax);
+      return s.addInactiveClause(_ps);
+    }
+    if( seg.h > _profile[top].h ) top = k;
+  }
+
+  segment const& tseg = _profile[top];
+  if( tseg.h > _cap.min(s) ) {
+    _ps.clear();
+    explain_segment(s, _start.size(), tseg.a, tseg.b, tseg.h);
+    _ps.push( _cap.e_geq(s, tseg.h) );
+    DO_OR_RETURN(_cap.setmin(s, tseg.h, _ps));
+  }
+
+  for(size_t i = 0; i != _start.size(); ++i) {
+    if( _dmin[i] == 0 || _rmin[i] == 0 ) continue;
+    DO_OR_RETURN(prune_start(s, i, cmax));
+    DO_OR_RETURN(prune_end(s, i, cmax));
+  }
+  return 0L;
+}
+
+void cons_cumulative::clone(Solver &other)
+{
+  cons *con = new cons_cumulative(other, _start, _dur, _req, _cap);
+  other.addConstraint(con);
+}
+
+ostream& cons_cumulative::print(Solver &s, ostream& os) const
+{
+  os << "cumulative([";
+  for(size_t i = 0; i != _start.size(); ++i) {
+    if( i ) os << ", ";
+    os << "(" << cspvar_printer(s, _start[i])
+       << ", " << cspvar_printer(s, _dur[i])
+       << ", " << cspvar_printer(s, _req[i]) << ")";
+  }
+  os << "], " << cspvar_printer(s, _cap) << ")";
+  return os;
+}
+
+ostream& cons_cumulative::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t i = 0; i != _start.size(); ++i) {
+    os << cspvar_printer(s, _start[i]) << " in "
+       << domain_as_range(s, _start[i]) << ", "
+       << cspvar_printer(s, _dur[i]) << " in "
+       << domain_as_range(s, _dur[i]) << ", "
+       << cspvar_printer(s, _req[i]) << " in "
+       << domain_as_range(s, _req[i]) << ", ";
+  }
+  os << cspvar_printer(s, _cap) << " in " << domain_as_range(s, _cap) << ")";
+  return os;
+}
+
 void post_cumulative(Solver& s, vector<cspvar> const& start,
                      vector<cspvar> const& dur,
                      vector<cspvar> const& req,
-                     cspvar cap)
+                     cspvar cap, bool native)
 {
   using namespace cumulative;
 
   const size_t n = start.size();
   assert( dur.size() == n && req.size() == n );
+  if( cap.min(s) == 1 && cap.max(s) == 1 &&
+      std::all_of(dur.begin(), dur.end(),
+                  [&](cspvar d) { return fixed(s, d); }) &&
+      std::all_of(req.begin(), req.end(),
+                  [&](cspvar r) { return fixed(s, r); }) ) {
+    // a unary resource
+    vector<cspvar> ustart;
+    vector<int> udur;
+    for(size_t i = 0; i != n; ++i) {
+      if( value(s, req[i]) == 0 || value(s, dur[i]) == 0 ) continue;
+      if( value(s, req[i]) > 1 ) throw unsat();
+      ustart.push_back(start[i]);
+      udur.push_back(value(s, dur[i]));
+    }
+    post_disjunctive(s, ustart, udur);
+    return;
+  }
+  if( native ) {
+    cons *con = new cons_cumulative(s, start, dur, req, cap);
+    s.addConstraint(con);
+    return;
+  }
   int mint = start[0].min(s);
   int maxt = start[0].max(s)+dur[0].max(s);
   for(size_t i = 1; i != n; ++i) {
@@ -3674,22 +6853,546 @@ void post_cumulative(Solver& s, vector<cspvar> const& start,
       if( !fixed(s, req[i]) ) unfixed_req = true;
     }
 
-    if( unfixed_req ) { // at least one task has unfixed resource
-                        // requirement
-      assert(0);
-    } else {
-      vector<int> w;
-      vector<int> v;
-      for(size_t i = 0; i != n; ++i) {
-        if( running[i] == lit_Undef ) continue;
-        w.push_back( value(s, req[i]) );
-        v.push_back( var(running[i]) );
-      }
-      cspvar tcap = s.newCSPVar(0, cap.max(s));
-      post_leq(s, tcap, cap, 0);
-      post_pb(s, v, w, 0, tcap);
-    }
+    if( unfixed_req ) { // at least one task has unfixed resource
+                        // requirement
+      assert(0);
+    } else {
+      vector<int> w;
+      vector<int> v;
+      for(size_t i = 0; i != n; ++i) {
+        if( running[i] == lit_Undef ) continue;
+        w.push_back( value(s, req[i]) );
+        v.push_back( var(running[i]) );
+      }
+      cspvar tcap = s.newCSPVar(0, cap.max(s));
+      post_leq(s, tcap, cap, 0);
+      post_pb(s, v, w, 0, tcap);
+    }
+  }
+}
+
+/* Disjunctive (unary resource) constraint: tasks 0..n-1 with start
+   s[i] and fixed duration p[i] do not overlap.
+
+   The propagator runs edge-finding (which includes overload
+   checking), detectable precedences and not-last on a Theta-Lambda
+   tree, as described by Vilim. Each rule is run on the tasks as they
+   are and on their mirror image, where est and lct swap roles, which
+   gives the symmetric rules (not-first, pruning of the end times).
+
+   Every rule boils down to: a set of tasks must fit in a window
+   [a, b), so explanations only use the literals 'est(k) >= a' and
+   'lct(k) <= b' of the tasks in the window, plus those of the task
+   that is pruned.
+
+   The rules only test the ect of Theta, which the tree maintains, so
+   a pass that prunes nothing takes O(n log n). Finding the window
+   that explains a pruning or a failure takes O(n), and is only done
+   once the pruning or failure is certain.
+*/
+namespace disjunctive {
+  const int64_t NEG = std::numeric_limits<int64_t>::min()/4;
+
+  // Theta-Lambda tree. Leaves are tasks in est order, white tasks
+  // are in Theta and gray tasks in Lambda.
+  class thetalambda {
+    struct node {
+      int64_t sp, ect;       // sum of durations and ect of Theta
+      int64_t spbar, ectbar; // same, with at most one gray task
+      int rp, rect;          // the gray task responsible for each
+    };
+    vector<node> t;
+    size_t leaves;
+
+    void update(size_t v);
+  public:
+    void init(size_t n);
+    void white(size_t pos, int est, int p);
+    void gray(size_t pos, int est, int p, int task);
+    void empty(size_t pos);
+
+    int64_t ect() const { return t[1].ect; }
+    int64_t ectbar() const { return t[1].ectbar; }
+    int responsible() const { return t[1].rect; }
+  };
+
+  void thetalambda::init(size_t n)
+  {
+    leaves = 1;
+    while( leaves < n ) leaves *= 2;
+    node e = { 0, NEG, 0, NEG, -1, -1 };
+    t.assign(2*leaves, e);
+  }
+
+  void thetalambda::update(size_t v)
+  {
+    for(v /= 2; v != 0; v /= 2) {
+      node const& l = t[2*v];
+      node const& r = t[2*v+1];
+      node& n = t[v];
+      n.sp = l.sp + r.sp;
+      n.ect = std::max(r.ect, l.ect + r.sp);
+      if( l.spbar + r.sp >= l.sp + r.spbar ) {
+        n.spbar = l.spbar + r.sp;
+        n.rp = l.rp;
+      } else {
+        n.spbar = l.sp + r.spbar;
+        n.rp = r.rp;
+      }
+      n.ectbar = r.ectbar;
+      n.rect = r.rect;
+      if( l.ect + r.spbar > n.ectbar ) {
+        n.ectbar = l.ect + r.spbar;
+        n.rect = r.rp;
+      }
+      if( l.ectbar + r.sp > n.ectbar ) {
+        n.ectbar = l.ectbar + r.sp;
+        n.rect = l.rect;
+      }
+    }
+  }
+
+  void thetalambda::white(size_t pos, int est, int p)
+  {
+    node w = { p, int64_t(est) + p, p, int64_t(est) + p, -1, -1 };
+    t[leaves + pos] = w;
+    update(leaves + pos);
+  }
+
+  void thetalambda::gray(size_t pos, int est, int p, int task)
+  {
+    node g = { 0, NEG, p, int64_t(est) + p, task, task };
+    t[leaves + pos] = g;
+    update(leaves + pos);
+  }
+
+  void thetalambda::empty(size_t pos)
+  {
+    node e = { 0, NEG, 0, NEG, -1, -1 };
+    t[leaves + pos] = e;
+    update(leaves + pos);
+  }
+}
+
+class cons_disjunctive : public cons {
+  vector<cspvar> _start;
+  vector<int> _dur;
+  size_t n;
+
+  // the current view: if _mirror, est and lct are those of the
+  // mirror image, i.e., est(i) = -(max(s[i])+p[i]), lct(i) = -min(s[i])
+  bool _mirror;
+  vector<int> _est, _lct;
+  vector<int> _byest;  // tasks sorted by est
+  vector<int> _rank;   // position of each task in _byest
+  vector<int> _order, _order2;
+  vector<char> _in;    // in Theta
+  disjunctive::thetalambda _tree;
+
+  // the literals that go in the next explanation
+  vector<int> _needest, _needlct;
+  vec<Lit> _ps;
+
+  int lst(int i) const { return _lct[i] - _dur[i]; }
+  int ect(int i) const { return _est[i] + _dur[i]; }
+
+  void snapshot(Solver &s);
+  void insert(int k);
+  void remove(int k);
+
+  void need_clear();
+  void need_est(int k, int v) { _needest[k] = std::max(_needest[k], v); }
+  void need_lct(int k, int v) { _needlct[k] = std::min(_needlct[k], v); }
+  // need est(k) >= a and lct(k) <= b for all k in Theta with est(k) >= a
+  void need_window(int a, int b);
+  // put the needed literals in _ps
+  void flush(Solver &s);
+
+  // the ect of Theta, and the est a that gives it
+  int64_t theta_ect(int& a) const;
+  // the largest a <= amax such that a + extra + the durations of the
+  // tasks in Theta with est >= a exceed bound
+  bool theta_overload(int64_t extra, int64_t bound, int amax,
+                      int& a, int64_t& sum) const;
+  // the largest lst of the tasks in Theta with est >= a
+  int theta_lst(int a) const;
+
+  // prune with _ps as the reason
+  Clause *setmin(Solver &s, int i, int d);
+  Clause *setmax(Solver &s, int i, int d);
+  Clause *set_est(Solver &s, int i, int v);
+  Clause *set_lct(Solver &s, int i, int v);
+
+  Clause *edge_finding(Solver &s);
+  Clause *detectable_precedences(Solver &s);
+  Clause *not_last(Solver &s);
+public:
+  cons_disjunctive(Solver &s, vector<cspvar> const& start,
+                   vector<int> const& dur);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+cons_disjunctive::cons_disjunctive(Solver &s, vector<cspvar> const& start,
+                                   vector<int> const& dur) :
+  _start(start), _dur(dur), n(start.size()), _mirror(false)
+{
+  _est.resize(n);
+  _lct.resize(n);
+  _byest.resize(n);
+  _rank.resize(n);
+  _order.resize(n);
+  _order2.resize(n);
+  _in.resize(n);
+  _needest.resize(n);
+  _needlct.resize(n);
+  for(size_t i = 0; i != n; ++i) {
+    s.schedule_on_lb(_start[i], this);
+    s.schedule_on_ub(_start[i], this);
+  }
+  if( propagate(s) )
+    throw unsat();
+}
+
+void cons_disjunctive::snapshot(Solver &s)
+{
+  for(size_t i = 0; i != n; ++i) {
+    if( _mirror ) {
+      _est[i] = -(_start[i].max(s) + _dur[i]);
+      _lct[i] = -_start[i].min(s);
+    } else {
+      _est[i] = _start[i].min(s);
+      _lct[i] = _start[i].max(s) + _dur[i];
+    }
+    _byest[i] = i;
+  }
+  std::sort(_byest.begin(), _byest.end(),
+            [&](int i, int j) { return _est[i] < _est[j]; });
+  for(size_t r = 0; r != n; ++r)
+    _rank[_byest[r]] = r;
+  std::fill(_in.begin(), _in.end(), 0);
+  _tree.init(n);
+}
+
+void cons_disjunctive::insert(int k)
+{
+  _in[k] = 1;
+  _tree.white(_rank[k], _est[k], _dur[k]);
+}
+
+void cons_disjunctive::remove(int k)
+{
+  _in[k] = 0;
+  _tree.empty(_rank[k]);
+}
+
+void cons_disjunctive::need_clear()
+{
+  std::fill(_needest.begin(), _needest.end(),
+            std::numeric_limits<int>::min());
+  std::fill(_needlct.begin(), _needlct.end(),
+            std::numeric_limits<int>::max());
+}
+
+void cons_disjunctive::need_window(int a, int b)
+{
+  for(size_t k = 0; k != n; ++k) {
+    if( !_in[k] || _est[k] < a ) continue;
+    need_est(k, a);
+    need_lct(k, b);
+  }
+}
+
+void cons_disjunctive::flush(Solver &s)
+{
+  _ps.clear();
+  for(size_t k = 0; k != n; ++k) {
+    cspvar x = _start[k];
+    int e = _needest[k], l = _needlct[k];
+    if( e != std::numeric_limits<int>::min() ) {
+      int d = _mirror ? -e - _dur[k] : e;
+      if( !_mirror && d > x.omin(s) ) _ps.push( x.r_geq(s, d) );
+      if( _mirror && d < x.omax(s) ) _ps.push( x.r_leq(s, d) );
+    }
+    if( l != std::numeric_limits<int>::max() ) {
+      int d = _mirror ? -l : l - _dur[k];
+      if( !_mirror && d < x.omax(s) ) _ps.push( x.r_leq(s, d) );
+      if( _mirror && d > x.omin(s) ) _ps.push( x.r_geq(s, d) );
+    }
+  }
+}
+
+int64_t cons_disjunctive::theta_ect(int& a) const
+{
+  int64_t sum = 0, best = disjunctive::NEG;
+  // no task has this est, in case Theta is empty
+  a = std::numeric_limits<int>::max();
+  for(size_t r = n; r-- != 0; ) {
+    int k = _byest[r];
+    if( !_in[k] ) continue;
+    sum += _dur[k];
+    if( _est[k] + sum > best ) {
+      best = _est[k] + sum;
+      a = _est[k];
+    }
+  }
+  return best;
+}
+
+bool cons_disjunctive::theta_overload(int64_t extra, int64_t bound,
+                                      int amax, int& a,
+                                      int64_t& sum) const
+{
+  sum = 0;
+  size_t r = n;
+  for(; r != 0 && _est[_byest[r-1]] >= amax; --r)
+    if( _in[_byest[r-1]] ) sum += _dur[_byest[r-1]];
+  if( amax != std::numeric_limits<int>::max() &&
+      amax + sum + extra > bound ) {
+    a = amax;
+    return true;
+  }
+  for(; r-- != 0; ) {
+    int k = _byest[r];
+    if( !_in[k] ) continue;
+    sum += _dur[k];
+    if( _est[k] + sum + extra > bound ) {
+      a = _est[k];
+      return true;
+    }
+  }
+  return false;
+}
+
+int cons_disjunctive::theta_lst(int a) const
+{
+  int L = std::numeric_limits<int>::min();
+  for(size_t k = 0; k != n; ++k)
+    if( _in[k] && _est[k] >= a )
+      L = std::max(L, lst(k));
+  return L;
+}
+
+Clause *cons_disjunctive::setmin(Solver &s, int i, int d)
+{
+  cspvar x = _start[i];
+  if( d <= x.min(s) ) return 0L;
+  if( d > x.max(s) ) {
+    if( x.max(s) < x.omax(s) ) _ps.push( x.r_leq(s, x.max(s)) );
+    return s.addInactiveClause(_ps);
+  }
+  _ps.push( x.e_geq(s, d) );
+  return x.setmin(s, d, _ps);
+}
+
+Clause *cons_disjunctive::setmax(Solver &s, int i, int d)
+{
+  cspvar x = _start[i];
+  if( d >= x.max(s) ) return 0L;
+  if( d < x.min(s) ) {
+    if( x.min(s) > x.omin(s) ) _ps.push( x.r_geq(s, x.min(s)) );
+    return s.addInactiveClause(_ps);
+  }
+  _ps.push( x.e_leq(s, d) );
+  return x.setmax(s, d, _ps);
+}
+
+Clause *cons_disjunctive::set_est(Solver &s, int i, int v)
+{
+  if( _mirror ) return setmax(s, i, -v - _dur[i]);
+  return setmin(s, i, v);
+}
+
+Clause *cons_disjunctive::set_lct(Solver &s, int i, int v)
+{
+  if( _mirror ) return setmin(s, i, -v);
+  return setmax(s, i, v - _dur[i]);
+}
+
+Clause *cons_disjunctive::edge_finding(Solver &s)
+{
+  snapshot(s);
+  for(size_t k = 0; k != n; ++k) {
+    insert(k);
+    _order[k] = k;
+  }
+  std::sort(_order.begin(), _order.end(),
+            [&](int i, int j) { return _lct[i] > _lct[j]; });
+
+  for(size_t q = 0; q != n; ++q) {
+    int j = _order[q], b = _lct[j];
+    if( _tree.ect() > b ) {
+      int a;
+      int64_t sum;
+      theta_overload(0, b, std::numeric_limits<int>::max(), a, sum);
+      need_clear();
+      need_window(a, b);
+      flush(s);
+      return s.addInactiveClause(_ps);
+    }
+    while( _tree.ectbar() > b ) {
+      int i = _tree.responsible();
+      if( i < 0 ) break;
+      // i cannot end before all of Theta, so it starts after them
+      int64_t v = _tree.ect();
+      if( v > _est[i] ) {
+        int a, a2;
+        int64_t sum;
+        theta_ect(a2);
+        bool found = theta_overload(_dur[i], b, _est[i], a, sum);
+        assert(found); (void)found;
+        need_clear();
+        need_window(a, b);
+        need_window(a2, b);
+        need_est(i, a);
+        flush(s);
+        DO_OR_RETURN(set_est(s, i, v));
+      }
+      _tree.empty(_rank[i]);
+    }
+    _in[j] = 0;
+    _tree.gray(_rank[j], _est[j], _dur[j], j);
+  }
+  return 0L;
+}
+
+Clause *cons_disjunctive::detectable_precedences(Solver &s)
+{
+  snapshot(s);
+  for(size_t k = 0; k != n; ++k)
+    _order[k] = _order2[k] = k;
+  std::sort(_order.begin(), _order.end(),
+            [&](int i, int j) { return ect(i) < ect(j); });
+  std::sort(_order2.begin(), _order2.end(),
+            [&](int i, int j) { return lst(i) < lst(j); });
+
+  size_t qj = 0;
+  for(size_t q = 0; q != n; ++q) {
+    int i = _order[q];
+    // every task that must start before i ends precedes it
+    for(; qj != n && lst(_order2[qj]) < ect(i); ++qj)
+      insert(_order2[qj]);
+    bool had = _in[i];
+    if( had ) remove(i);
+    if( _tree.ect() > _est[i] ) {
+      int a;
+      int64_t v = theta_ect(a);
+      int L = theta_lst(a);
+      need_clear();
+      need_est(i, L - _dur[i] + 1);
+      for(size_t k = 0; k != n; ++k) {
+        if( !_in[k] || _est[k] < a ) continue;
+        need_est(k, a);
+        need_lct(k, L + _dur[k]);
+      }
+      flush(s);
+      DO_OR_RETURN(set_est(s, i, v));
+    }
+    if( had ) insert(i);
+  }
+  return 0L;
+}
+
+Clause *cons_disjunctive::not_last(Solver &s)
+{
+  snapshot(s);
+  for(size_t k = 0; k != n; ++k)
+    _order[k] = _order2[k] = k;
+  std::sort(_order.begin(), _order.end(),
+            [&](int i, int j) { return _lct[i] < _lct[j]; });
+  std::sort(_order2.begin(), _order2.end(),
+            [&](int i, int j) { return lst(i) < lst(j); });
+
+  size_t qj = 0;
+  for(size_t q = 0; q != n; ++q) {
+    int i = _order[q];
+    for(; qj != n && lst(_order2[qj]) < _lct[i]; ++qj)
+      insert(_order2[qj]);
+    bool had = _in[i];
+    if( had ) remove(i);
+    if( _tree.ect() > lst(i) ) {
+      // i cannot start after all of Theta, so it ends before the
+      // last of them starts
+      int a;
+      int64_t sum;
+      bool found = theta_overload(0, lst(i),
+                                  std::numeric_limits<int>::max(), a, sum);
+      assert(found); (void)found;
+      int L = theta_lst(a);
+      need_clear();
+      need_lct(i, a + sum - 1 + _dur[i]);
+      for(size_t k = 0; k != n; ++k) {
+        if( !_in[k] || _est[k] < a ) continue;
+        need_est(k, a);
+        need_lct(k, L + _dur[k]);
+      }
+      flush(s);
+      DO_OR_RETURN(set_lct(s, i, L));
+    }
+    if( had ) insert(i);
+  }
+  return 0L;
+}
+
+Clause *cons_disjunctive::propagate(Solver &s)
+{
+  for(int m = 0; m != 2; ++m) {
+    _mirror = m;
+    DO_OR_RETURN(edge_finding(s));
+    DO_OR_RETURN(detectable_precedences(s));
+    DO_OR_RETURN(not_last(s));
+  }
+  return 0L;
+}
+
+void cons_disjunctive::clone(Solver &other)
+{
+  cons *con = new cons_disjunctive(other, _start, _dur);
+  other.addConstraint(con);
+}
+
+ostream& cons_disjunctive::print(Solver &s, ostream& os) const
+{
+  os << "disjunctive([";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << "(" << cspvar_printer(s, _start[i]) << ", " << _dur[i] << ")";
+  }
+  os << "])";
+  return os;
+}
+
+ostream& cons_disjunctive::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _start[i]) << " in "
+       << domain_as_range(s, _start[i]);
+  }
+  os << ")";
+  return os;
+}
+
+void post_disjunctive(Solver &s, vector<cspvar> const& start,
+                      vector<int> const& dur)
+{
+  assert(start.size() == dur.size());
+  vector<cspvar> pstart;
+  vector<int> pdur;
+  for(size_t i = 0; i != start.size(); ++i) {
+    assert(dur[i] >= 0);
+    if( dur[i] == 0 ) continue;
+    pstart.push_back(start[i]);
+    pdur.push_back(dur[i]);
   }
+  if( pstart.size() < 2 ) return;
+  cons *con = new cons_disjunctive(s, pstart, pdur);
+  s.addConstraint(con);
 }
 
 namespace table {
@@ -3836,6 +7539,49 @@ namespace table {
     }
   }
 
+  // a trie of the tuples as a layered automaton, in which a star
+  // leads to a child of its own on every value of its column. Since
+  // that makes it non-deterministic, it is only minimized by merging
+  // equivalent states
+  regular::automaton table_to_mdd(Solver &s, vector<cspvar> const& x,
+                                  vector< vector<int> > const& tuples)
+  {
+    const int q0 = 1, accepting = 2;
+    int numstates = 3;
+    map< pair<int, int>, int > child;  // STAR_CONSTANT for stars
+    vector<regular::transition> d;
+    for(size_t i = 0; i != tuples.size(); ++i) {
+      if( tuples[i].size() != x.size() )
+        throw non_table();
+      int q = q0;
+      for(size_t j = 0; j != x.size(); ++j) {
+        int v = tuples[i][j];
+        int& next = child[make_pair(q, v)];
+        if( !next ) {
+          next = j+1 == x.size() ? accepting : numstates++;
+          if( v != STAR_CONSTANT )
+            d.push_back(regular::transition(q, v, next));
+          else
+            for(int w = x[j].min(s); w <= x[j].max(s); ++w)
+              if( x[j].indomain(s, w) )
+                d.push_back(regular::transition(q, w, next));
+        }
+        q = next;
+      }
+    }
+    // unfold() expects the transitions of a state to be contiguous
+    vector< pair< pair<size_t, int>, size_t > > sorted;
+    for(size_t i = 0; i != d.size(); ++i)
+      sorted.push_back(make_pair(make_pair(d[i].q0, d[i].s), d[i].q1));
+    sort(sorted.begin(), sorted.end());
+    for(size_t i = 0; i != d.size(); ++i)
+      d[i] = regular::transition(sorted[i].first.first,
+                                 sorted[i].first.second, sorted[i].second);
+    set<int> F;
+    F.insert(accepting);
+    return regular::automaton(d, q0, F);
+  }
+
   void post_positive_table_regular(Solver &s, std::vector<cspvar> const& x,
                                    std::vector< std::vector<int> > const& tuples)
   {
@@ -3845,17 +7591,642 @@ namespace table {
   }
 }
 
+namespace table {
+  /* The tuples of a table that are still valid (all their values are
+     in the domains), as a reversible sparse bitset (Demeyer et al.)
+
+     Each (var, value) has a mask of the tuples that contain it, or a
+     star in its place, stored sparsely as (word, bits) pairs, since
+     most of its words are 0. update() removes from the set the tuples
+     of the values that each var lost since its size was last
+     recorded, either by the masks of its missing values or by
+     everything but the masks of its remaining values, whichever is
+     cheaper (always the latter if the var has a star in some tuple,
+     since a star tuple is in the masks of the missing values too).
+     Holes in lazy vars do not change their size, so those are always
+     considered changed.
+   */
+  class tupleset {
+  public:
+    struct sword {
+      int w;
+      uint64_t bits;
+    };
+
+    vector<cspvar> x;
+    size_t n;
+    int ntuples;
+    vector<int> tuples;   // n ints per tuple
+    vector<char> star;    // per var, whether a tuple has a star there
+    vector<char> lazy;    // per var, lazy: its size ignores holes
+
+    // per var, the first value and the index of its first (var, value)
+    vector<int> vmin, vbase;
+    // per (var, value), its mask in masks[mfirst[k]..mfirst[k+1])
+    vector<int> mfirst;
+    vector<sword> masks;
+
+    // the valid tuples: words, a sparse set of the non-zero words and
+    // its size
+    btptr words_ptr;
+    btptr limit_ptr;
+    vector<int> index;
+    vector<uint64_t> mask;
+
+    btptr size_ptr;       // int[n]: domain size when last recorded
+    vector<int> changed;  // the vars seen changed by the last update()
+
+    // keeps the tuples that are valid in the current domains
+    void init(Solver &s, vector<cspvar> const& x,
+              vector< vector<int> > const& tuples);
+
+    int vidx(size_t j, int v) const { return vbase[j] + v - vmin[j]; }
+    uint64_t const *words(Solver &s) const {
+      return s.deref_array<uint64_t>(words_ptr);
+    }
+    int limit(Solver &s) const { return s.deref<int>(limit_ptr); }
+    void record_size(Solver &s, size_t j) {
+      s.bt_write_array<int>(size_ptr, j, x[j].domsize(s));
+    }
+
+    void clear_mask();
+    void add_to_mask(int k);
+    void intersect_with_mask(Solver &s, bool complement);
+    // false if no tuple is left
+    bool update(Solver &s);
 
-void post_positive_table(Solver &s, std::vector<cspvar> const& x,
-                         std::vector< std::vector<int> > const& tuples)
+    // a false literal that excludes v from x[j] at trail position t
+    // (if deferred, otherwise now), or lit_Undef
+    Lit removal_at(Solver &s, size_t j, int v, int t, bool deferred);
+  };
+
+  void tupleset::init(Solver &s, vector<cspvar> const& vars,
+                      vector< vector<int> > const& ts)
+  {
+    x = vars;
+    n = x.size();
+    for(size_t i = 0; i != ts.size(); ++i) {
+      if( ts[i].size() != n )
+        throw non_table();
+      bool valid = true;
+      for(size_t j = 0; j != n && valid; ++j)
+        valid = ts[i][j] == STAR_CONSTANT || x[j].indomain(s, ts[i][j]);
+      if( valid )
+        tuples.insert(tuples.end(), ts[i].begin(), ts[i].end());
+    }
+    ntuples = tuples.size()/std::max(n, size_t(1));
+
+    vmin.resize(n);
+    vbase.resize(n+1);
+    star.assign(n, false);
+    lazy.assign(n, false);
+    for(int i = 0; i != ntuples; ++i)
+      for(size_t j = 0; j != n; ++j)
+        if( tuples[i*n+j] == STAR_CONSTANT ) star[j] = true;
+    vbase[0] = 0;
+    for(size_t j = 0; j != n; ++j) {
+      lazy[j] = s.cspvarlazy(x[j]);
+      vmin[j] = x[j].min(s);
+      vbase[j+1] = vbase[j] + x[j].max(s) - x[j].min(s) + 1;
+    }
+
+    // the masks, built by counting the words of each (var, value)
+    const int nwords = (ntuples + 63)/64;
+    const int nvals = vbase[n];
+    mfirst.assign(nvals+1, 0);
+    vector<int> lastw(nvals, -1);
+    for(int w = 0; w != nwords; ++w)
+      for(int i = 64*w; i != std::min(64*(w+1), ntuples); ++i)
+        for(size_t j = 0; j != n; ++j) {
+          int t = tuples[i*n+j];
+          if( t != STAR_CONSTANT ) {
+            int k = vidx(j, t);
+            if( lastw[k] != w ) { lastw[k] = w; ++mfirst[k+1]; }
+            continue;
+          }
+          for(int v = x[j].min(s); v <= x[j].max(s); ++v) {
+            int k = vidx(j, v);
+            if( lastw[k] != w ) { lastw[k] = w; ++mfirst[k+1]; }
+          }
+        }
+    for(int k = 0; k != nvals; ++k)
+      mfirst[k+1] += mfirst[k];
+    masks.resize(mfirst[nvals]);
+    vector<int> fill(mfirst.begin(), mfirst.end()-1);
+    std::fill(lastw.begin(), lastw.end(), -1);
+    for(int i = 0; i != ntuples; ++i)
+      for(size_t j = 0; j != n; ++j) {
+        int v = tuples[i*n+j], lo = v, hi = v;
+        if( v == STAR_CONSTANT ) {
+          lo = x[j].min(s);
+          hi = x[j].max(s);
+        }
+        for(v = lo; v <= hi; ++v) {
+          int k = vidx(j, v);
+          if( lastw[k] != i/64 ) {
+            lastw[k] = i/64;
+            sword sw = { i/64, 0 };
+            masks[fill[k]++] = sw;
+          }
+          masks[fill[k]-1].bits |= uint64_t(1) << (i%64);
+        }
+      }
+
+    // one word even without tuples, left empty
+    words_ptr = s.alloc_backtrackable(std::max(nwords, 1)*sizeof(uint64_t));
+    uint64_t *ws = s.deref_array<uint64_t>(words_ptr);
+    ws[0] = 0;
+    for(int w = 0; w != nwords; ++w)
+      ws[w] = ~uint64_t(0);
+    if( ntuples % 64 )
+      ws[nwords-1] = (uint64_t(1) << (ntuples % 64)) - 1;
+    limit_ptr = s.alloc_backtrackable(sizeof(int));
+    s.deref<int>(limit_ptr) = nwords;
+    index.resize(nwords);
+    for(int w = 0; w != nwords; ++w)
+      index[w] = w;
+    mask.resize(nwords);
+
+    // a size that no domain has, so that the first update looks at all
+    size_ptr = s.alloc_backtrackable(n*sizeof(int));
+    int *size = s.deref_array<int>(size_ptr);
+    for(size_t j = 0; j != n; ++j)
+      size[j] = -1;
+  }
+
+  void tupleset::clear_mask()
+  {
+    std::fill(mask.begin(), mask.end(), 0);
+  }
+
+  void tupleset::add_to_mask(int k)
+  {
+    for(int p = mfirst[k]; p != mfirst[k+1]; ++p)
+      mask[masks[p].w] |= masks[p].bits;
+  }
+
+  void tupleset::intersect_with_mask(Solver &s, bool complement)
+  {
+    uint64_t *ws = s.deref_array<uint64_t>(words_ptr);
+    int lim = s.deref<int>(limit_ptr), oldlim = lim;
+    for(int i = lim-1; i >= 0; --i) {
+      int w = index[i];
+      uint64_t m = complement ? ~mask[w] : mask[w];
+      uint64_t nw = ws[w] & m;
+      if( nw == ws[w] ) continue;
+      s.bt_write_array<uint64_t>(words_ptr, w, nw);
+      ws = s.deref_array<uint64_t>(words_ptr);
+      if( nw == 0 ) {
+        std::swap(index[i], index[lim-1]);
+        --lim;
+      }
+    }
+    if( lim != oldlim )
+      s.deref_mut<int>(limit_ptr) = lim;
+  }
+
+  bool tupleset::update(Solver &s)
+  {
+    int const *size = s.deref_array<int>(size_ptr);
+    changed.clear();
+    for(size_t j = 0; j != n; ++j)
+      if( lazy[j] || x[j].domsize(s) != size[j] )
+        changed.push_back(j);
+
+    for(size_t c = 0; c != changed.size(); ++c) {
+      size_t j = changed[c];
+      cspvar y = x[j];
+      int dsize = y.domsize(s), removed = vbase[j+1] - vbase[j] - dsize;
+      record_size(s, j);
+      clear_mask();
+      if( removed < dsize && !star[j] ) {
+        for(int v = vmin[j], vend = vmin[j] + vbase[j+1] - vbase[j];
+            v != vend; ++v)
+          if( !y.indomain(s, v) ) add_to_mask(vidx(j, v));
+        intersect_with_mask(s, true);
+      } else {
+        for(int v = y.min(s); v <= y.max(s); ++v)
+          if( y.indomain(s, v) ) add_to_mask(vidx(j, v));
+        intersect_with_mask(s, false);
+      }
+      if( limit(s) == 0 )
+        return false;
+    }
+    return true;
+  }
+
+  Lit tupleset::removal_at(Solver &s, size_t j, int v, int t, bool deferred)
+  {
+    cspvar y = x[j];
+    if( !deferred )
+      return y.indomain(s, v) ? lit_Undef : y.r_neq(s, v);
+    return deferred::removed_at(s, y, v, t);
+  }
+}
+
+/* Compact-Table: positive table propagated by the set of its valid
+   tuples. After the update, every value with no valid tuple left is
+   pruned, checking the word of its last support first.
+
+   If all vars are eager, prunings are explained on demand: the
+   reason for x != a is, for each tuple that supported it, the
+   removal of one of its other values before x != a was enqueued.
+*/
+class cons_ct : public cons, public explainer {
+  table::tupleset _t;
+  bool _deferred;
+
+  vector<int> _resid;   // position in _t.masks of the last support
+  vector<int> _mark;    // stamps of (var, value) pairs in a reason
+  int _stamp;
+  vec<Lit> _ps;
+
+  bool supported(Solver &s, int k);
+
+  // append to c the reason that none of the tuples in mask k (or
+  // all tuples if k < 0) is valid at trail position t, skipping var
+  // skip
+  void explain_tuples(Solver &s, int k, size_t skip, int t, vec<Lit>& c);
+public:
+  cons_ct(Solver &s, vector<cspvar> const& x,
+          vector< vector<int> > const& tuples);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+
+  void explain(Solver& s, Lit p, vec<Lit>& c);
+  void use() {}
+  void release() {}
+};
+
+cons_ct::cons_ct(Solver &s, vector<cspvar> const& x,
+                 vector< vector<int> > const& tuples) :
+  _stamp(0)
 {
-  table::post_positive_table_ac4(s, x, tuples);
+  _t.init(s, x, tuples);
+  if( _t.ntuples == 0 )
+    throw unsat();
+  _deferred = std::none_of(_t.lazy.begin(), _t.lazy.end(),
+                           [](char l) { return l; });
+  _resid.assign(_t.mfirst.begin(), _t.mfirst.end()-1);
+  _mark.assign(_t.vbase[_t.n], 0);
+  for(size_t j = 0; j != _t.n; ++j)
+    s.schedule_on_dom(x[j], this);
+  if( propagate(s) )
+    throw unsat();
 }
 
-// Here we just post everything as a clause, better encodings later
-void post_negative_table(Solver &s, std::vector<cspvar> const& x,
-                         std::vector< std::vector<int> > const& tuples)
+bool cons_ct::supported(Solver &s, int k)
+{
+  uint64_t const *words = _t.words(s);
+  int r = _resid[k];
+  if( r != _t.mfirst[k+1] && (words[_t.masks[r].w] & _t.masks[r].bits) )
+    return true;
+  for(int p = _t.mfirst[k]; p != _t.mfirst[k+1]; ++p)
+    if( words[_t.masks[p].w] & _t.masks[p].bits ) {
+      _resid[k] = p;
+      return true;
+    }
+  return false;
+}
+
+void cons_ct::explain_tuples(Solver &s, int k, size_t skip, int t,
+                             vec<Lit>& c)
+{
+  size_t n = _t.n;
+  ++_stamp;
+  int cbeg = c.size();
+  int pbeg = k < 0 ? 0 : _t.mfirst[k],
+    pend = k < 0 ? (_t.ntuples+63)/64 : _t.mfirst[k+1];
+  for(int p = pbeg; p != pend; ++p) {
+    int w = k < 0 ? p : _t.masks[p].w;
+    uint64_t bits = k < 0 ? ~uint64_t(0) : _t.masks[p].bits;
+    for(; bits; bits &= bits-1) {
+      int i = 64*w + __builtin_ctzll(bits);
+      if( i >= _t.ntuples ) break;
+      int const *tuple = &_t.tuples[i*n];
+      bool covered = false;
+      for(size_t j = 0; j != n && !covered; ++j)
+        covered = j != skip && tuple[j] != STAR_CONSTANT &&
+          _mark[_t.vidx(j, tuple[j])] == _stamp;
+      if( covered ) continue;
+      size_t j = 0;
+      Lit l = lit_Undef;
+      for(; j != n && l == lit_Undef; ++j)
+        if( j != skip && tuple[j] != STAR_CONSTANT )
+          l = _t.removal_at(s, j, tuple[j], t, _deferred);
+      assert(l != lit_Undef);
+      _mark[_t.vidx(j-1, tuple[j-1])] = _stamp;
+      c.push(l);
+    }
+  }
+  // bound literals of lazy vars may repeat
+  if( !_deferred )
+    unique_lits(c, cbeg);
+}
+
+void cons_ct::explain(Solver &s, Lit p, vec<Lit>& c)
+{
+  domevent pe = s.event(p);
+  size_t j = 0;
+  while( _t.x[j].id() != pe.x.id() ) ++j;
+  c.push(p);
+  explain_tuples(s, _t.vidx(j, pe.d), j, s.varTrailPos(p), c);
+}
+
+Clause *cons_ct::propagate(Solver &s)
+{
+  if( !_t.update(s) ) {
+    _ps.clear();
+    explain_tuples(s, -1, _t.n, s.nAssigns(), _ps);
+    return s.addInactiveClause(_ps);
+  }
+  if( _t.changed.empty() ) return 0L;
+
+  for(size_t j = 0; j != _t.n; ++j) {
+    cspvar x = _t.x[j];
+    if( x.min(s) == x.max(s) ) continue;
+    // only x changed: its values lost no tuples
+    if( _t.changed.size() == 1 && size_t(_t.changed[0]) == j ) continue;
+    for(int v = x.min(s), vmax = x.max(s); v <= vmax; ++v) {
+      if( !x.indomain(s, v) ) continue;
+      int k = _t.vidx(j, v);
+      if( supported(s, k) ) continue;
+      if( _deferred ) {
+        s.uncheckedEnqueueDeferred(~Lit(x.eqiUnsafe(s, v)), this);
+        continue;
+      }
+      _ps.clear();
+      explain_tuples(s, k, j, 0, _ps);
+      DO_OR_RETURN(x.removef(s, v, _ps));
+    }
+    // the pruned values had no valid tuple left anyway
+    _t.record_size(s, j);
+  }
+  return 0L;
+}
+
+void cons_ct::clone(Solver &other)
+{
+  size_t n = _t.n;
+  vector< vector<int> > tuples(_t.ntuples);
+  for(int i = 0; i != _t.ntuples; ++i)
+    tuples[i].assign(&_t.tuples[i*n], &_t.tuples[i*n] + n);
+  cons *con = new cons_ct(other, _t.x, tuples);
+  other.addConstraint(con);
+}
+
+ostream& cons_ct::print(Solver &s, ostream& os) const
+{
+  os << "table([";
+  for(size_t j = 0; j != _t.n; ++j) {
+    if( j ) os << ", ";
+    os << cspvar_printer(s, _t.x[j]);
+  }
+  os << "], " << _t.ntuples << " tuples)";
+  return os;
+}
+
+ostream& cons_ct::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  os << " (with ";
+  for(size_t j = 0; j != _t.n; ++j) {
+    if( j ) os << ", ";
+    os << cspvar_printer(s, _t.x[j]) << " in " << domain_as_set(s, _t.x[j]);
+  }
+  os << ", " << _t.limit(s) << " words left)";
+  return os;
+}
+
+/* Negative table, propagated by the set of its valid forbidden
+   tuples (CT-neg, Verhaeghe et al.)
+
+   Without stars, the forbidden tuples are distinct, so x = a has no
+   support iff the valid tuples that contain it are as many as the
+   assignments of the other vars. With stars they may overlap, so
+   x = a is only pruned when the other vars are fixed and some valid
+   tuple contains it, as the clause of the tuple would do.
+
+   Either way, the reason for x != a is the domains of the other vars
+   when it was pruned, and it is computed on demand if all vars are
+   eager. The domain sizes are only recorded by the update, so that
+   the counts always match the sizes they are compared with.
+*/
+class cons_ctneg : public cons, public explainer {
+  table::tupleset _t;
+  bool _deferred;
+  bool _stars;
+  vector<int64_t> _prefix, _suffix; // products of domain sizes
+  vec<Lit> _ps;
+
+  // the valid tuples in mask k, stopping at cap
+  int64_t count(Solver &s, int k, int64_t cap);
+  // append to c the domains of all vars but skip at trail position t
+  void explain_domains(Solver &s, size_t skip, int t, vec<Lit>& c);
+public:
+  cons_ctneg(Solver &s, vector<cspvar> const& x,
+             vector< vector<int> > const& tuples);
+
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+
+  void explain(Solver& s, Lit p, vec<Lit>& c);
+  void use() {}
+  void release() {}
+};
+
+cons_ctneg::cons_ctneg(Solver &s, vector<cspvar> const& x,
+                       vector< vector<int> > const& tuples)
+{
+  // counting needs distinct tuples
+  vector< vector<int> > sorted(tuples);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  _t.init(s, x, sorted);
+  _deferred = std::none_of(_t.lazy.begin(), _t.lazy.end(),
+                           [](char l) { return l; });
+  _stars = std::any_of(_t.star.begin(), _t.star.end(),
+                       [](char st) { return st; });
+  _prefix.resize(_t.n+1);
+  _suffix.resize(_t.n+1);
+  for(size_t j = 0; j != _t.n; ++j)
+    s.schedule_on_dom(x[j], this);
+  if( propagate(s) )
+    throw unsat();
+}
+
+int64_t cons_ctneg::count(Solver &s, int k, int64_t cap)
+{
+  uint64_t const *words = _t.words(s);
+  int64_t c = 0;
+  for(int p = _t.mfirst[k]; p != _t.mfirst[k+1] && c < cap; ++p)
+    c += __builtin_popcountll(words[_t.masks[p].w] & _t.masks[p].bits);
+  return c;
+}
+
+void cons_ctneg::explain_domains(Solver &s, size_t skip, int t,
+                                 vec<Lit>& c)
+{
+  int cbeg = c.size();
+  for(size_t j = 0; j != _t.n; ++j) {
+    if( j == skip ) continue;
+    cspvar y = _t.x[j];
+    int lo, hi;
+    if( _deferred ) {
+      lo = deferred::min_at(s, y, t);
+      hi = deferred::max_at(s, y, t);
+      if( lo > y.omin(s) ) c.push( Lit(y.leqiUnsafe(s, lo-1)) );
+      if( hi < y.omax(s) ) c.push( ~Lit(y.leqiUnsafe(s, hi)) );
+    } else {
+      lo = y.min(s);
+      hi = y.max(s);
+      if( lo > y.omin(s) ) c.push( y.r_geq(s, lo) );
+      if( hi < y.omax(s) ) c.push( y.r_leq(s, hi) );
+    }
+    for(int v = lo+1; v < hi; ++v) {
+      Lit l = _t.removal_at(s, j, v, t, _deferred);
+      if( l != lit_Undef ) c.push(l);
+    }
+  }
+  if( !_deferred )
+    unique_lits(c, cbeg);
+}
+
+void cons_ctneg::explain(Solver &s, Lit p, vec<Lit>& c)
+{
+  domevent pe = s.event(p);
+  size_t j = 0;
+  while( _t.x[j].id() != pe.x.id() ) ++j;
+  c.push(p);
+  explain_domains(s, j, s.varTrailPos(p), c);
+}
+
+Clause *cons_ctneg::propagate(Solver &s)
+{
+  // no forbidden tuple left, entailed
+  if( !_t.update(s) ) return 0L;
+  if( _t.changed.empty() ) return 0L;
+
+  uint64_t const *words = _t.words(s);
+  int64_t valid = 0;
+  for(int i = 0; i != _t.limit(s); ++i)
+    valid += __builtin_popcountll(words[_t.index[i]]);
+
+  // the assignments of all vars but j, capped above the valid tuples
+  size_t n = _t.n;
+  int const *size = s.deref_array<int>(_t.size_ptr);
+  int64_t cap = _stars ? 2 : valid+1;
+  _prefix[0] = _suffix[n] = 1;
+  for(size_t j = 0; j != n; ++j)
+    _prefix[j+1] = std::min(cap, _prefix[j]*size[j]);
+  for(size_t j = n; j != 0; --j)
+    _suffix[j-1] = std::min(cap, _suffix[j]*size[j-1]);
+
+  for(size_t j = 0; j != n; ++j) {
+    int64_t others = std::min(cap, _prefix[j]*_suffix[j+1]);
+    if( others >= cap ) continue;
+    cspvar x = _t.x[j];
+    for(int v = x.min(s), vmax = x.max(s); v <= vmax; ++v) {
+      if( !x.indomain(s, v) ) continue;
+      if( count(s, _t.vidx(j, v), others) < others ) continue;
+      if( _deferred && x.min(s) != x.max(s) ) {
+        s.uncheckedEnqueueDeferred(~Lit(x.eqiUnsafe(s, v)), this);
+        continue;
+      }
+      _ps.clear();
+      explain_domains(s, j, s.nAssigns(), _ps);
+      DO_OR_RETURN(x.removef(s, v, _ps));
+    }
+  }
+  return 0L;
+}
+
+void cons_ctneg::clone(Solver &other)
+{
+  size_t n = _t.n;
+  vector< vector<int> > tuples(_t.ntuples);
+  for(int i = 0; i != _t.ntuples; ++i)
+    tuples[i].assign(&_t.tuples[i*n], &_t.tuples[i*n] + n);
+  cons *con = new cons_ctneg(other, _t.x, tuples);
+  other.addConstraint(con);
+}
+
+ostream& cons_ctneg::print(Solver &s, ostream& os) const
+{
+  os << "negative_table([";
+  for(size_t j = 0; j != _t.n; ++j) {
+    if( j ) os << ", ";
+    os << cspvar_printer(s, _t.x[j]);
+  }
+  os << "], " << _t.ntuples << " tuples)";
+  return os;
+}
+
+ostream& cons_ctneg::printstate(Solver &s, ostream& os) const
 {
+  print(s, os);
+  os << " (with ";
+  for(size_t j = 0; j != _t.n; ++j) {
+    if( j ) os << ", ";
+    os << cspvar_printer(s, _t.x[j]) << " in " << domain_as_set(s, _t.x[j]);
+  }
+  os << ", " << _t.limit(s) << " words left)";
+  return os;
+}
+
+void post_positive_table(Solver &s, std::vector<cspvar> const& x,
+                         std::vector< std::vector<int> > const& tuples,
+                         table_propagator p)
+{
+  if( p == TABLE_AUTO )
+    p = tuples.size() >= 64 ? TABLE_CT : TABLE_CLAUSES;
+  // Compact-Table explains a pruning of x by the other vars
+  set<int> ids;
+  for(size_t i = 0; i != x.size(); ++i)
+    if( !ids.insert(x[i].id()).second && p == TABLE_CT )
+      p = TABLE_CLAUSES;
+  if( p == TABLE_CLAUSES ) {
+    table::post_positive_table_ac4(s, x, tuples);
+    return;
+  }
+  if( p == TABLE_MDD && !x.empty() ) {
+    if( tuples.empty() ) throw unsat();
+    post_regular(s, x, table::table_to_mdd(s, x, tuples), true, true);
+    return;
+  }
+  if( x.empty() ) {
+    for(size_t i = 0; i != tuples.size(); ++i)
+      if( !tuples[i].empty() ) throw non_table();
+    if( tuples.empty() ) throw unsat();
+    return;
+  }
+  cons *con = new cons_ct(s, x, tuples);
+  s.addConstraint(con);
+}
+
+void post_negative_table(Solver &s, std::vector<cspvar> const& x,
+                         std::vector< std::vector<int> > const& tuples,
+                         table_propagator p)
+{
+  if( p == TABLE_AUTO )
+    p = tuples.size() >= 64 ? TABLE_CT : TABLE_CLAUSES;
+  // CT-neg counts the assignments of the other vars
+  set<int> ids;
+  for(size_t i = 0; i != x.size(); ++i)
+    if( !ids.insert(x[i].id()).second )
+      p = TABLE_CLAUSES;
+  if( p != TABLE_CLAUSES && !x.empty() ) {
+    cons *con = new cons_ctneg(s, x, tuples);
+    s.addConstraint(con);
+    return;
+  }
+
+  // one clause per tuple
   for(size_t i = 0; i != tuples.size(); ++i) {
     if(tuples[i].size() != x.size())
       throw non_table();
@@ -3867,68 +8238,181 @@ void post_negative_table(Solver &s, std::vector<cspvar> const& x,
   }
 }
 
-void post_lex_common(Solver &s, std::vector<cspvar> const& x,
-                     std::vector<cspvar> const& y,
-                     std::vector<Var> const& b,
-                     std::vector<Var> const& c)
-{
-    /* we post the decomposition
-     * bi -> xi <= yi
-     * ci <-> xi < yi
-     * bi /\ -ci -> b(i+1)
-     * b0
-     *
-     * Note that the first constraint is a one-way implication. If it
-     * is equivalence we would need a third Boolean var to get the
-     * same effect.
-     */
+/* lex_leq and lex_less, by the two pointer algorithm of Frisch,
+   Hnich, Kiziltan, Miguel and Walsh, which enforces GAC
 
-    using std::size_t;
-    size_t n = x.size();
-    vec<Lit> ps;
+   alpha is the first index at which x and y are not fixed to the
+   same value. Only x[alpha] and y[alpha] are pruned: x[alpha] <=
+   y[alpha], and x[alpha] < y[alpha] if the rest of the strings
+   cannot be ordered, i.e., if lexmin(x[alpha+1:]) > lexmax(y[alpha+1:]).
+   beta is the index at which that comparison was decided, so bound
+   changes after beta are ignored until something at or before beta
+   changes.
+
+   The reason of a pruning is x[i] >= y[i] for i < alpha, the bound of
+   the other var at alpha and, if it is strict, x[j] >= y[j] for alpha
+   < j < beta and x[beta] > y[beta].
+*/
+class cons_lex : public cons {
+  vector<cspvar> _x, _y;
+  size_t n;
+  bool _strict;
+
+  btptr _alpha, _beta;
+  vec<Lit> _ps;
+
+  bool fixed_equal(Solver &s, size_t i) const {
+    return _x[i].min(s) == _x[i].max(s) && _y[i].min(s) == _y[i].max(s)
+      && _x[i].min(s) == _y[i].min(s);
+  }
+  // x[i] >= y[i], for from <= i < to
+  void explain_geq(Solver &s, size_t from, size_t to) {
+    for(size_t i = from; i != to; ++i) {
+      pushifdef(_ps, _x[i].r_min(s));
+      pushifdef(_ps, _y[i].r_max(s));
+    }
+  }
+public:
+  cons_lex(Solver &s, vector<cspvar> const& x, vector<cspvar> const& y,
+           bool strict) :
+    _x(x), _y(y), n(x.size()), _strict(strict)
+  {
+    assert(x.size() == y.size());
+    _alpha = s.alloc_backtrackable(sizeof(int));
+    _beta = s.alloc_backtrackable(sizeof(int));
+    s.deref<int>(_alpha) = 0;
+    s.deref<int>(_beta) = n;
     for(size_t i = 0; i != n; ++i) {
-        post_leq_re_li(s, x[i], y[i], 0, Lit(b[i]));
-        post_leq_re(s, x[i], y[i], -1, Lit(c[i]));
-
-        if( i < n-1 ) {
-            ps.clear();
-            ps.push(~Lit(b[i]));
-            ps.push(Lit(c[i]));
-            ps.push(Lit(b[i+1]));
-            s.addClause(ps);
-        }
+      void *advice = reinterpret_cast<void*>(i+1);
+      s.wake_on_lb(_x[i], this, advice);
+      s.wake_on_fix(_x[i], this, advice);
+      s.wake_on_ub(_y[i], this, advice);
+      s.wake_on_fix(_y[i], this, advice);
+    }
+    if( propagate(s) ) throw unsat();
+  }
+
+  Clause *wake_advised(Solver& s, Lit p, void *advice);
+  Clause *propagate(Solver& s);
+  void clone(Solver& other);
+  ostream& print(Solver &s, ostream& os) const;
+  ostream& printstate(Solver& s, ostream& os) const;
+};
+
+Clause *cons_lex::wake_advised(Solver &s, Lit, void *advice)
+{
+  int i = reinterpret_cast<size_t>(advice)-1;
+  if( i > s.deref<int>(_beta) ) return 0L;
+  return propagate(s);
+}
+
+Clause *cons_lex::propagate(Solver &s)
+{
+  size_t alpha = s.deref<int>(_alpha);
+  for(;;) {
+    while( alpha != n && fixed_equal(s, alpha) )
+      ++alpha;
+    if( alpha != (size_t)s.deref<int>(_alpha) )
+      s.deref_mut<int>(_alpha) = alpha;
+    if( alpha == n ) {
+      if( !_strict ) return 0L;
+      _ps.clear();
+      explain_geq(s, 0, n);
+      return s.addInactiveClause(_ps);
+    }
+
+    size_t beta = alpha+1;
+    while( beta != n && _x[beta].min(s) == _y[beta].max(s) )
+      ++beta;
+    if( beta != (size_t)s.deref<int>(_beta) )
+      s.deref_mut<int>(_beta) = beta;
+    bool strict = beta == n ? _strict : _x[beta].min(s) > _y[beta].max(s);
+    int lim = strict;
+
+    cspvar x = _x[alpha], y = _y[alpha];
+    if( x.max(s) + lim <= y.max(s) && x.min(s) + lim <= y.min(s) )
+      return 0L;
+
+    _ps.clear();
+    explain_geq(s, 0, alpha);
+    if( strict ) {
+      explain_geq(s, alpha+1, beta);
+      if( beta != n ) {
+        pushifdef(_ps, _x[beta].r_min(s));
+        pushifdef(_ps, _y[beta].r_leq(s, _x[beta].min(s)-1));
+      }
+    }
+    int psize = _ps.size();
+
+    if( x.min(s) + lim > y.max(s) ) { // failure
+      pushifdef(_ps, x.r_min(s));
+      pushifdef(_ps, y.r_leq(s, x.min(s)+lim-1));
+      return s.addInactiveClause(_ps);
+    }
+    if( x.max(s) + lim > y.max(s) ) {
+      pushifdef(_ps, y.r_max(s));
+      DO_OR_RETURN(x.setmaxf(s, y.max(s)-lim, _ps));
+      _ps.shrink(_ps.size() - psize);
     }
-    s.enqueue(Lit(b[0]));
+    if( x.min(s) + lim > y.min(s) ) {
+      pushifdef(_ps, x.r_min(s));
+      DO_OR_RETURN(y.setminf(s, x.min(s)+lim, _ps));
+    }
+    // x[alpha] = y[alpha] is only forced if the rest can be ordered,
+    // in which case alpha moves on
+    if( strict || !fixed_equal(s, alpha) ) return 0L;
+  }
+}
+
+void cons_lex::clone(Solver &other)
+{
+  cons *con = new cons_lex(other, _x, _y, _strict);
+  other.addConstraint(con);
+}
+
+ostream& cons_lex::print(Solver &s, ostream& os) const
+{
+  os << (_strict ? "lex_less([" : "lex_leq([");
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _x[i]);
+  }
+  os << "], [";
+  for(size_t i = 0; i != n; ++i) {
+    if( i ) os << ", ";
+    os << cspvar_printer(s, _y[i]);
+  }
+  os << "])";
+  return os;
+}
+
+ostream& cons_lex::printstate(Solver &s, ostream& os) const
+{
+  print(s, os);
+  os << " (with alpha = " << s.deref<int>(_alpha)
+     << ", beta = " << s.deref<int>(_beta);
+  for(size_t i = 0; i != n; ++i)
+    os << ", " << cspvar_printer(s, _x[i]) << " in "
+       << domain_as_set(s, _x[i]) << ", " << cspvar_printer(s, _y[i])
+       << " in " << domain_as_set(s, _y[i]);
+  os << ")";
+  return os;
 }
 
 void post_lex_leq(Solver &s, std::vector<cspvar> const& x,
                   std::vector<cspvar> const& y)
 {
     assert(x.size() == y.size());
-    std::size_t n = x.size();
-    std::vector<Var> b(n), c(n);
-    for(size_t i = 0; i != n; ++i) {
-        b[i] = s.newVar();
-        c[i] = s.newVar();
-    }
-    post_lex_common(s, x, y, b, c);
+    cons *con = new cons_lex(s, x, y, false);
+    s.addConstraint(con);
 }
 
 void post_lex_less(Solver &s, std::vector<cspvar> const& x,
                    std::vector<cspvar> const& y)
 {
     assert(x.size() == y.size());
-    size_t n = x.size();
-    std::vector<Var> b(n), c(n);
-    for(size_t i = 0; i != n; ++i) {
-        b[i] = s.newVar();
-        c[i] = s.newVar();
-    }
-    post_lex_common(s, x, y, b, c);
-    vec<Lit> ps;
-    ps.push(~Lit(b[n-1]));
-    ps.push(Lit(c[n-1]));
-    s.addClause(ps);
+    cons *con = new cons_lex(s, x, y, true);
+    s.addConstraint(con);
 }
 
 } // namespace minicsp
@@ -229,13 +229,75 @@ void post_max(Solver &s, cspvar x, cspvar y, cspvar z);
 /* Element: R = X[I-offset]
 
    offset is 0 by default for normal 0-based indexing, but the
-   flatzinc frontend uses 1 for its own 1-based indexing */
+   flatzinc frontend uses 1 for its own 1-based indexing.
+
+   It is propagated to domain consistency by a global constraint,
+   unless decomp is true, in which case it is decomposed into clauses
+   over O(n*d) auxiliary variables. If all X are fixed, it is posted
+   over the array of their values. */
+void post_element(Solver &s, cspvar R, cspvar I,
+                  std::vector<cspvar> const& X, int offset=0,
+                  bool decomp=false);
+
+// Element over an array of constants: R = X[I-offset]
 void post_element(Solver &s, cspvar R, cspvar I,
-                  std::vector<cspvar> const& X, int offset=0);
+                  std::vector<int> const& X, int offset=0);
+
+// the consistency that a global constraint enforces. Bounds
+// consistency ignores the holes in the domains, but its cost does not
+// depend on their size
+enum consistency { CONSISTENCY_AUTO, CONSISTENCY_DOMAIN, CONSISTENCY_BOUNDS };
 
 // alldiff. if gac is false it behaves like a clique of != and also
 // detects gac disentailment, otherwise enforces gac like usual
 void post_alldiff(Solver &s, std::vector<cspvar> const& vars, bool gac = true);
+// alldiff with the given consistency. Bounds consistency takes
+// O(n log n) per call. CONSISTENCY_AUTO enforces bounds consistency
+// when all domains are intervals, as then it only misses the holes
+// that domain consistency would punch in them
+void post_alldiff(Solver &s, std::vector<cspvar> const& vars, consistency c);
+
+/* global cardinality: for each j, the number of vars in x that take
+   the value vals[j] is in [lb[j], ub[j]] (resp. is card[j]). The
+   values of vals must be distinct and the other values are not
+   constrained.
+
+   It is propagated by a flow, to domain or bounds consistency on x,
+   the latter by default when the domains span more than 256
+   values. The cardinality vars are only bounded by the number of
+   vars fixed to their value and the number that can take it. */
+void post_gcc(Solver &s, std::vector<cspvar> const& x,
+              std::vector<int> const& vals,
+              std::vector<int> const& lb, std::vector<int> const& ub,
+              consistency c = CONSISTENCY_AUTO);
+void post_gcc(Solver &s, std::vector<cspvar> const& x,
+              std::vector<int> const& vals,
+              std::vector<cspvar> const& card,
+              consistency c = CONSISTENCY_AUTO);
+
+/* circuit: x[i] is the successor of node i (plus offset) and the
+   successors form a single circuit through all nodes. subcircuit: a
+   node i may have x[i] = i, which excludes it, and the other nodes
+   form a single circuit (which may be empty). Both post an alldiff
+   and prune the edges that close a subtour or leave the SCC of the
+   nodes that must be in the circuit. */
+void post_circuit(Solver &s, std::vector<cspvar> const& x, int offset = 0);
+void post_subcircuit(Solver &s, std::vector<cspvar> const& x,
+                     int offset = 0);
+
+/* inverse: x[i] = j + yoffset iff y[j] = i + xoffset, so x and y are
+   inverse permutations. If x is shorter than y, only x[i] = j +
+   yoffset -> y[j] = i + xoffset holds, and y[j] may take values
+   that are not indices of x; if it is longer there is no
+   solution. Each removal is channelled in O(1) with no new
+   literals. */
+void post_inverse(Solver &s, std::vector<cspvar> const& x,
+                  std::vector<cspvar> const& y,
+                  int xoffset = 0, int yoffset = 0);
+
+// channel: the Booleans b[i] are 1 iff x = i + offset
+void post_channel(Solver &s, std::vector<cspvar> const& b, cspvar x,
+                  int offset = 0);
 
 // atmostnvalue. The number of distinct values taken by the vector x
 // is at most N
@@ -292,18 +354,35 @@ namespace regular {
   };
 }
 
+//
+// With mdd, the unfolded and minimized automaton is propagated
+// directly as an MDD, without Boolean vars for its states and
+// transitions. This is always GAC.
 void post_regular(Solver& s, std::vector<cspvar> const& x,
                   regular::automaton const& aut,
-                  bool gac = true);
+                  bool gac = true, bool mdd = false);
 
 /* Cumulative constraint: holds if a set of tasks 0..n-1 is scheduled
    so that task i starts as s[i], has duration d[i] and requires r[i]
    of a given resource, and the resource requirements of all tasks
-   running at any given time is less than c. */
+   running at any given time is less than c.
+
+   By default it is decomposed into a pseudo-Boolean constraint per
+   time point, which requires fixed r[i]. If native is true, it is
+   propagated instead by a timetable propagator that accepts any
+   r[i]. Either way, if c is 1 and all d[i], r[i] are fixed, it is
+   posted as a disjunctive. */
 void post_cumulative(Solver& s, std::vector<cspvar> const& start,
                      std::vector<cspvar> const& dur,
                      std::vector<cspvar> const& req,
-                     cspvar cap);
+                     cspvar cap, bool native = false);
+
+/* Disjunctive constraint: tasks 0..n-1, where task i starts at s[i]
+   and has duration d[i], do not overlap. Propagated by overload
+   checking, detectable precedences, not-first/not-last and
+   edge-finding. */
+void post_disjunctive(Solver& s, std::vector<cspvar> const& start,
+                      std::vector<int> const& dur);
 
 
 /* Table constraints. Constraints defined in extension, either as a
@@ -320,16 +399,29 @@ struct non_table{};
 // x1 = 1, x2 = 2, regardless of the assignment we make to x3.
 static const int STAR_CONSTANT = INT_MAX;
 
+// how a table is propagated: by clauses (over one Boolean var per
+// tuple for a positive table, one clause per tuple for a negative
+// one), or by a bitset of the valid tuples (Compact-Table,
+// CT-neg). For positive tables both enforce GAC. For negative tables
+// without stars CT-neg enforces GAC, the clauses do not. TABLE_AUTO
+// uses the bitset for tables with 64 tuples or more. TABLE_MDD
+// compiles a positive table into an MDD and posts it as a regular
+// constraint with the MDD propagator, which suits tables with a lot
+// of shared structure. A negative table uses CT-neg instead
+enum table_propagator { TABLE_AUTO, TABLE_CLAUSES, TABLE_CT, TABLE_MDD };
+
 void post_positive_table(Solver &s, std::vector<cspvar> const& x,
-                         std::vector< std::vector<int> > const& tuples);
+                         std::vector< std::vector<int> > const& tuples,
+                         table_propagator p = TABLE_AUTO);
 void post_negative_table(Solver &s, std::vector<cspvar> const& x,
-                         std::vector< std::vector<int> > const& tuples);
+                         std::vector< std::vector<int> > const& tuples,
+                         table_propagator p = TABLE_AUTO);
 
 /* lex ordering constraints: given two vectors x,y of equal length, it
    holds if the string x is lexicographically leq (resp, less) than
    the string y. Declaratively lex_leq(x,y) <=> x[0] <= y[0] && (x[0]
    == y[0] -> lex_leq(x[1:n], y[1:n])). lex_less(x,y) <=> lex_leq(x,y)
-   && x != y. */
+   && x != y. Both enforce GAC. */
 void post_lex_leq(Solver &s, std::vector<cspvar> const& x,
                   std::vector<cspvar> const& y);
 void post_lex_less(Solver &s, std::vector<cspvar> const& x,
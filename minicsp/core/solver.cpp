@@ -70,12 +70,24 @@ Solver::Solver() :
   , phase_saving     (true)
   , solution_phase_saving(false)
   , allow_clause_dbg (true)
+  , trail_backtrackable(true)
+  , lazy_threshold   (-1)
+  , garbage_frac     (0.20)
 
   , conflict_lim     (-1)
 
     // branching heuristics
   , varbranch(VAR_VSIDS)
   , valbranch(VAL_LEX)
+  , learnt_policy(LEARNTS_ACTIVITY)
+  , restart_policy(RESTART_LUBY)
+  , lbd_queue_size(50)
+  , restart_K(0.8)
+  , trail_queue_size(5000)
+  , restart_R(1.4)
+  , blocking_first(10000)
+  , core_lbd(2)
+  , tier2_lbd(6)
     // Statistics: (formerly in 'SolverStats')
     //
   , starts(0), decisions(0), rnd_decisions(0), propagations(0), conflicts(0)
@@ -88,6 +100,8 @@ Solver::Solver() :
   , simpDB_assigns   (-1)
   , simpDB_props     (0)
   , order_heap       (VarOrderLt(activity))
+  , dom_heap         (DomLt(cspvars))
+  , domwdeg_heap     (DomWdegLt(cspvars))
   , random_seed      (91648253)
   , progress_estimate(0)
   , remove_satisfied (true)
@@ -96,31 +110,27 @@ Solver::Solver() :
     , backtrackable_cap(0)
     , backtrackable_space(0)
     , current_space(0L)
+    , bt_epoch(1)
 
     , active_constraint(0L)
 {
   consqs.growTo(MAX_PRIORITY+2);
   reset_queue();
   prop_queue = &consqs[0];
+  for(int k = 0; k != ENC_NUM; ++k)
+    encoding_expl[k].kind = encoding_clause(k);
 }
 
 
 Solver::~Solver()
 {
-  for (int i = 0; i < learnts.size(); i++) free(learnts[i]);
-  for (int i = 0; i < clauses.size(); i++) free(clauses[i]);
+  // clauses in the region go away with it, only the ones from
+  // Clause_new() have to be freed
   for (int i = 0; i < conses.size(); ++i) conses[i]->dispose();
-  for (int i = 0; i != inactive.size(); ++i) free(inactive[i]);
-  for (int i = 0; i != cspvars.size(); ++i) {
-    cspvar_fixed & xf = cspvars[i];
-    if( xf.omax == xf.omin ) continue;
-    for(int j = 0; j != (xf.omax-xf.omin+1); ++j) {
-      free(xf.ps1[j]);
-      free(xf.ps2[j]);
-      if( j > 0 ) free(xf.ps3[j]);
-      free(xf.ps4[j]);
-    }
-  }
+  for (int i = 0; i != inactive.size(); ++i)
+    if( !inactive[i]->arena() ) free(inactive[i]);
+  for (int i = 0; i != cspvars.size(); ++i)
+    delete cspvars[i].lazy;
   for(int i = 0; i != backtrackable_space.size(); ++i)
     free(backtrackable_space[i]);
   free(current_space);
@@ -141,6 +151,8 @@ Var Solver::newVar(bool sign, bool dvar)
     watches   .push();          // (list for negative literal)
     binwatches   .push();          // (list for positive literal)
     binwatches   .push();          // (list for negative literal)
+    dirty     .push(0);
+    dirty     .push(0);
 
     wakes_on_lit.push();
     sched_on_lit.push();
@@ -148,6 +160,7 @@ Var Solver::newVar(bool sign, bool dvar)
     reason    .push({});
     assigns   .push(toInt(l_Undef));
     level     .push(-1);
+    trailpos  .push(-1);
     activity  .push(0);
     seen      .push(0);
 
@@ -173,6 +186,9 @@ cspvar Solver::newCSPVar(int min, int max)
 {
   assert(max - min >= 0 );
 
+  if( max > min && lazy_threshold >= 0 && max - min + 1 > lazy_threshold )
+    return newLazyCSPVar(min, max);
+
   bool unary = false;
   if( max == min ) unary = true;
 
@@ -210,53 +226,18 @@ cspvar Solver::newCSPVar(int min, int max)
     events[ toInt( ~Lit(xf.leqi(i) ) ) ] = geq;
   }
 
-  if( !unary ) {
-    xf.ps1.growTo(xf.dsize);
-    xf.ps2.growTo(xf.dsize);
-    xf.ps3.growTo(xf.dsize);
-    xf.ps4.growTo(xf.dsize);
-  }
-
-  // (x <= i) => (x <= i+1)
-  // (x = i) <=> (x <= i) /\ -(x <= i-1)
-  for(int i = 0; i != xf.dsize; ++i) {
-    if( unary ) continue;
-    vec<Lit> ps1, ps2, ps3, ps4;
-    pushifdef(ps1,  ~Lit(xf.leqi(i+xf.omin)) );
-    pushifdef(ps1, Lit(xf.leqi(i + 1 + xf.omin)));
-    Clause *c1 = Clause_new(ps1);
-    xf.ps1[i] = c1;
-
-    ps2.push( ~Lit(xf.eqi(i+xf.omin)) );
-    ps2.push( Lit(xf.leqi(i+xf.omin)) );
-    Clause *c2 = Clause_new(ps2);
-    xf.ps2[i] = c2;
-
-    if( i > 0 ) {
-      ps3.push( ~Lit(xf.eqi(i+xf.omin)) );
-      ps3.push( ~Lit(xf.leqi(i-1+xf.omin) ) );
-      Clause *c3 = Clause_new(ps3);
-      xf.ps3[i] = c3;
-
-      ps4.push( ~Lit(xf.leqi(i+xf.omin)) );
-      ps4.push( Lit(xf.leqi(i-1+xf.omin)) );
-      ps4.push( Lit(xf.eqi(i+xf.omin)) );
-      Clause *c4 = Clause_new(ps4);
-      xf.ps4[i] = c4;
-    } else {
-      xf.ps3[i] = INVALID_CLAUSE;
-      ps4.push( ~Lit(xf.leqi(xf.omin)) );
-      ps4.push( Lit(xf.eqi(xf.omin)) );
-      Clause *c4 =Clause_new(ps4);
-      xf.ps4[i] = c4;
-    }
-  }
+  /* The clauses of the encoding are
+       (x <= d-1) => (x <= d)
+       (x = d) <=> (x <= d) /\ -(x <= d-1)
+     but we do not store them. uncheckedEnqueue_common() keeps the
+     encoding consistent and encoding_expl rebuilds them as reasons.
+   */
 
   /* x <= omax, so this is true always. We could just simplify the
      rest of the clauses but this seems easier
    */
   if( !unary )
-    x.setmax(*this, xf.omax, (Clause*)0L);
+    uncheckedEnqueue(Lit(xf.leqi(xf.omax)), (Clause*)0L);
 
   /* Unary vars are also hacky. Immediately set eqi(min) = l_True
    */
@@ -268,6 +249,370 @@ cspvar Solver::newCSPVar(int min, int max)
   return x;
 }
 
+/* A lazy var starts with a single literal, x <= omax, which is true
+   at the root. Everything else is created by lazy_leqi/lazy_eqi.
+ */
+cspvar Solver::newLazyCSPVar(int min, int max)
+{
+  assert(max - min >= 0 );
+
+  if( max == min ) return newCSPVar(min, max);
+
+  cspvar x(cspvars.size());
+
+  cspvars.push();
+  cspvarnames.push_back(std::string());
+
+  cspvar_fixed & xf = cspvars.last();
+
+  xf.omin = min;
+  xf.omax = max;
+  xf.min = min;
+  xf.max = max;
+  xf.dsize = max-min+1;
+  xf.firstbool = var_Undef;
+  xf.lazy = new lazy_domain;
+
+  reduce_var_seen.push_back(false);
+  reduce_var_min.push_back(xf.omin);
+  reduce_var_max.push_back(xf.omax);
+  reduce_var_asgn.push_back(false);
+
+  Var v = newVar();
+  events[ toInt( Lit(v) ) ] = domevent(x, domevent::LEQ, max);
+  events[ toInt( ~Lit(v) ) ] = domevent(x, domevent::GEQ, max+1);
+  xf.lazy->leq[max] = v;
+  uncheckedEnqueue(Lit(v));
+  xf.lazy->minlit = lit_Undef;
+  xf.lazy->maxlit = Lit(v);
+
+  return x;
+}
+
+Var Solver::lazy_leqi(cspvar x, int d)
+{
+  cspvar_fixed& xf = cspvars[x._id];
+  if( !xf.ind(d) ) return var_Undef;
+  lazy_domain& ld = *xf.lazy;
+  std::map<int, Var>::iterator hi = ld.leq.lower_bound(d);
+  if( hi != ld.leq.end() && hi->first == d ) return hi->second;
+
+  Var v = newVar();
+  events[ toInt( Lit(v) ) ] = domevent(x, domevent::LEQ, d);
+  events[ toInt( ~Lit(v) ) ] = domevent(x, domevent::GEQ, d+1);
+
+  // (x <= lo) => (x <= d) => (x <= hi), where lo and hi are the
+  // nearest literals that already exist. x <= omax always exists, so
+  // hi does too
+  vec<Lit> ps;
+  assert( hi != ld.leq.end() );
+  if( hi != ld.leq.begin() ) {
+    std::map<int, Var>::iterator lo = hi;
+    --lo;
+    ps.push( ~Lit(lo->second) );
+    ps.push( Lit(v) );
+    lazy_attach(ld, ps);
+    ps.clear();
+  }
+  ps.push( ~Lit(v) );
+  ps.push( Lit(hi->second) );
+  lazy_attach(ld, ps);
+  ld.leq.insert(hi, std::make_pair(d, v));
+
+  lazy_materialized(v);
+  return v;
+}
+
+Var Solver::lazy_eqi(cspvar x, int d)
+{
+  cspvar_fixed& xf = cspvars[x._id];
+  if( !xf.ind(d) ) return var_Undef;
+  Var v = xf.lazy->findeq(d);
+  if( v != var_Undef ) return v;
+
+  Var leq = lazy_leqi(x, d);
+  Var leqm1 = lazy_leqi(x, d-1); // var_Undef if d == omin
+
+  v = newVar();
+  events[ toInt( Lit(v) ) ] = domevent(x, domevent::EQ, d);
+  events[ toInt( ~Lit(v) ) ] = domevent(x, domevent::NEQ, d);
+
+  // (x = d) <=> (x <= d) /\ -(x <= d-1)
+  lazy_domain& ld = *xf.lazy;
+  vec<Lit> ps;
+  ps.push( ~Lit(v) );
+  ps.push( Lit(leq) );
+  lazy_attach(ld, ps);
+  ps.clear();
+  if( leqm1 != var_Undef ) {
+    ps.push( ~Lit(v) );
+    ps.push( ~Lit(leqm1) );
+    lazy_attach(ld, ps);
+    ps.clear();
+  }
+  ps.push( ~Lit(leq) );
+  pushifdef( ps, Lit(leqm1) );
+  ps.push( Lit(v) );
+  lazy_attach(ld, ps);
+  ld.eq[d] = v;
+
+  lazy_materialized(v);
+  return v;
+}
+
+/* The clause may be unit or satisfied if we are not at the root, so
+   we have to watch the right literals: non-false ones first, then
+   the false ones from the highest level.
+ */
+void Solver::lazy_attach(lazy_domain& ld, vec<Lit>& ps)
+{
+  Clause *c = allocClause(ps);
+  for(int w = 0; w != 2; ++w) {
+    int best = w;
+    for(int i = w+1; i < c->size(); ++i) {
+      Lit p = (*c)[i], q = (*c)[best];
+      if( value(q) != l_False ) break;
+      if( value(p) != l_False || level[var(p)] > level[var(q)] )
+        best = i;
+    }
+    std::swap( (*c)[w], (*c)[best] );
+  }
+  attachClause(*c);
+  ld.clauses.push(c);
+}
+
+Lit Solver::lazy_entailed(Var v, vec<Lit>& ps)
+{
+  domevent const &pevent = events[toInt(Lit(v))];
+  cspvar_fixed& xf = cspvars[pevent.x._id];
+  lazy_domain& ld = *xf.lazy;
+  Lit p = lit_Undef;
+  ps.clear();
+  switch( pevent.type ) {
+  case domevent::LEQ:
+    if( pevent.d >= xf.max ) {
+      p = Lit(v);
+      ps.push(p);
+      ps.push(~ld.maxlit);
+    } else if( pevent.d < xf.min ) {
+      p = ~Lit(v);
+      ps.push(p);
+      ps.push(~ld.minlit);
+    }
+    break;
+  case domevent::EQ:
+    if( pevent.d > xf.max ) {
+      p = ~Lit(v);
+      ps.push(p);
+      ps.push(~ld.maxlit);
+    } else if( pevent.d < xf.min ) {
+      p = ~Lit(v);
+      ps.push(p);
+      ps.push(~ld.minlit);
+    } else if( xf.min == xf.max ) {
+      p = Lit(v);
+      ps.push(p);
+      ps.push(~ld.maxlit);
+      if( ld.minlit != lit_Undef && ld.minlit != ld.maxlit )
+        ps.push(~ld.minlit);
+    }
+    break;
+  default:
+    assert(0);
+  }
+  return p;
+}
+
+void Solver::lazy_enqueue(Lit p, vec<Lit>& ps)
+{
+  // this is not the doing of the active constraint, so do not
+  // debug it as if it were
+  cons *ac = active_constraint;
+  active_constraint = 0L;
+  if( decisionLevel() == 0 )
+    uncheckedEnqueue(p);
+  else {
+    Clause *r = addInactiveClause(ps);
+    uncheckedEnqueue(p, r);
+  }
+  active_constraint = ac;
+}
+
+void Solver::lazy_materialized(Var v)
+{
+  vec<Lit> ps;
+  Lit p = lazy_entailed(v, ps);
+  if( p != lit_Undef )
+    lazy_enqueue(p, ps);
+  if( decisionLevel() > 0 ) {
+    lazy_recent r;
+    r.v = v;
+    r.level = decisionLevel();
+    lazy_recents.push(r);
+  }
+}
+
+/* When we backtrack to a level below the one where a literal was
+   created, the state at that level may imply it, but its clauses did
+   not exist when that state was propagated. So we enqueue it
+   here. Literals that are not entailed will be reached by unit
+   propagation through their clauses.
+ */
+void Solver::lazy_recheck(int lvl)
+{
+  vec<Lit> ps;
+  int i, j;
+  for(i = j = 0; i != lazy_recents.size(); ++i) {
+    lazy_recent& r = lazy_recents[i];
+    if( r.level <= lvl ) {
+      lazy_recents[j++] = r;
+      continue;
+    }
+    if( value(r.v) == l_Undef ) {
+      Lit p = lazy_entailed(r.v, ps);
+      if( p != lit_Undef )
+        lazy_enqueue(p, ps);
+    }
+    r.level = lvl;
+    if( lvl > 0 )
+      lazy_recents[j++] = r;
+  }
+  lazy_recents.shrink(i-j);
+}
+
+/* Bounds are updated right away. Holes at the bounds are skipped
+   right away too, so that the bounds are always in the domain. The
+   rest of the encoding is updated through its clauses. If p is not
+   consistent with the bounds, unit propagation will find the
+   conflict, so we leave the bounds as they are.
+ */
+void Solver::lazy_update(cspvar_fixed& xf, Lit p, domevent const& pevent)
+{
+  lazy_domain& ld = *xf.lazy;
+  int nmin = xf.min, nmax = xf.max;
+  Lit nminlit = ld.minlit, nmaxlit = ld.maxlit;
+  switch( pevent.type ) {
+  case domevent::LEQ:
+    if( pevent.d < nmax && pevent.d >= nmin ) {
+      nmax = pevent.d;
+      nmaxlit = p;
+    }
+    break;
+  case domevent::GEQ:
+    if( pevent.d > nmin && pevent.d <= nmax ) {
+      nmin = pevent.d;
+      nminlit = p;
+    }
+    break;
+  case domevent::EQ:
+    if( pevent.d >= nmin && pevent.d <= nmax && nmin != nmax ) {
+      nmin = nmax = pevent.d;
+      nminlit = nmaxlit = p;
+    }
+    break;
+  default:
+    break;
+  }
+
+  vec<Lit> ps;
+  Var e;
+  while( nmin < nmax && (e = ld.findeq(nmin)) != var_Undef &&
+         value(e) == l_False ) {
+    Lit q = ~Lit(ld.findleq(nmin));
+    if( value(q) == l_False ) break; // conflict pending
+    ps.clear();
+    ps.push(q);
+    ps.push(Lit(e));
+    pushifdef(ps, ~nminlit);
+    if( value(q) == l_Undef ) {
+      Clause *r = addInactiveClause(ps);
+      uncheckedEnqueue_np(q, r);
+    }
+    ++nmin;
+    nminlit = q;
+  }
+  while( nmax > nmin && (e = ld.findeq(nmax)) != var_Undef &&
+         value(e) == l_False ) {
+    Lit q = Lit(ld.findleq(nmax-1));
+    if( value(q) == l_False ) break;
+    ps.clear();
+    ps.push(q);
+    ps.push(Lit(e));
+    ps.push(~nmaxlit);
+    if( value(q) == l_Undef ) {
+      Clause *r = addInactiveClause(ps);
+      uncheckedEnqueue_np(q, r);
+    }
+    --nmax;
+    nmaxlit = q;
+  }
+  if( nmin == nmax && (e = ld.findeq(nmin)) != var_Undef &&
+      value(e) == l_Undef ) {
+    ps.clear();
+    ps.push(Lit(e));
+    ps.push(~nmaxlit);
+    if( nminlit != lit_Undef && nminlit != nmaxlit )
+      ps.push(~nminlit);
+    Clause *r = addInactiveClause(ps);
+    uncheckedEnqueue_np(Lit(e), r);
+  } else if( nmin == nmax && e == var_Undef && xf.min != xf.max )
+    lazy_fixed.push(pevent.x._id);
+
+  if( nmin == xf.min && nmax == xf.max )
+    return;
+  if( decisionLevel() > 0 ) {
+    lazy_undo u;
+    u.trailpos = trail.size();
+    u.x = pevent.x._id;
+    u.min = xf.min;
+    u.max = xf.max;
+    u.minlit = ld.minlit;
+    u.maxlit = ld.maxlit;
+    lazy_undos.push(u);
+  }
+  xf.min = nmin;
+  xf.max = nmax;
+  xf.dsize = nmax - nmin + 1;
+  ld.minlit = nminlit;
+  ld.maxlit = nmaxlit;
+}
+
+/* If the event is entailed, prefer the literal for exactly this
+   event if it is already set, otherwise use the literal that set the
+   current bound, which is stronger. If not, this is just the negation
+   of the e_ literal, as for eager vars.
+ */
+Lit Solver::cspvarlazyreason(cspvar x, domevent::event_type t, int d)
+{
+  cspvar_fixed& xf = cspvars[x._id];
+  lazy_domain& ld = *xf.lazy;
+  Var v;
+  switch(t) {
+  case domevent::GEQ:
+    if( d <= xf.omin || d > xf.omax+1 ) return lit_Undef;
+    if( d > xf.min ) return Lit(lazy_leqi(x, d-1));
+    v = ld.findleq(d-1);
+    if( v != var_Undef && value(v) == l_False ) return Lit(v);
+    return ~ld.minlit;
+  case domevent::LEQ:
+    if( d >= xf.omax || d < xf.omin-1 ) return ~Lit(lazy_leqi(x, d));
+    if( d < xf.max ) return ~Lit(lazy_leqi(x, d));
+    v = ld.findleq(d);
+    if( v != var_Undef && value(v) == l_True ) return ~Lit(v);
+    return ~ld.maxlit;
+  case domevent::EQ:
+    return ~Lit(lazy_eqi(x, d));
+  case domevent::NEQ:
+    if( d >= xf.min && d <= xf.max ) return Lit(lazy_eqi(x, d));
+    if( d < xf.min ) return cspvarlazyreason(x, domevent::GEQ, d+1);
+    return cspvarlazyreason(x, domevent::LEQ, d-1);
+  case domevent::NONE:
+    break;
+  }
+  assert(0);
+  return lit_Undef;
+}
+
 std::vector<cspvar> Solver::newCSPVarArray(int n, int min, int max)
 {
   std::vector<cspvar> rv;
@@ -351,7 +696,7 @@ void Solver::addClause(vec<Lit>& ps)
         if( !ok ) throw unsat();
         return;
     }else{
-        Clause* c = Clause_new(ps, false);
+        Clause* c = allocClause(ps, false);
         clauses.push(c);
         attachClause(*c);
         if( trace )
@@ -366,29 +711,35 @@ void Solver::addInactiveClause(Clause* c)
 
 void Solver::attachClause(Clause& c) {
     assert(c.size() > 1);
+    CRef cr = ca.ael(&c);
     if (c.size() == 2) {
-        binwatches[toInt(~c[0])].push({&c, c[1]});
-        binwatches[toInt(~c[1])].push({&c, c[0]});
+        binwatches[toInt(~c[0])].push({cr, c[1]});
+        binwatches[toInt(~c[1])].push({cr, c[0]});
     } else {
-        watches[toInt(~c[0])].push({&c, c[1]});
-        watches[toInt(~c[1])].push({&c, c[0]});
+        watches[toInt(~c[0])].push({cr, c[1]});
+        watches[toInt(~c[1])].push({cr, c[0]});
     }
     if (c.learnt()) learnts_literals += c.size();
     else            clauses_literals += c.size(); }
 
 
-void Solver::detachClause(Clause& c) {
+void Solver::detachClause(Clause& c, bool strict) {
     assert(c.size() > 1);
-    if (c.size() == 2) {
-      assert(find(binwatches[toInt(~c[0])], watch{&c, lit_Undef}));
-      assert(find(binwatches[toInt(~c[1])], watch{&c, lit_Undef}));
-      remove(binwatches[toInt(~c[0])], watch{&c, lit_Undef});
-      remove(binwatches[toInt(~c[1])], watch{&c, lit_Undef});
+    CRef cr = ca.ael(&c);
+    if (!strict) {
+      // the watches are removed later in one sweep by cleanWatches()
+      smudgeWatches(~c[0]);
+      smudgeWatches(~c[1]);
+    } else if (c.size() == 2) {
+      assert(find(binwatches[toInt(~c[0])], watch{cr, lit_Undef}));
+      assert(find(binwatches[toInt(~c[1])], watch{cr, lit_Undef}));
+      remove(binwatches[toInt(~c[0])], watch{cr, lit_Undef});
+      remove(binwatches[toInt(~c[1])], watch{cr, lit_Undef});
     } else {
-      assert(find(watches[toInt(~c[0])], watch{&c, lit_Undef}));
-      assert(find(watches[toInt(~c[1])], watch{&c, lit_Undef}));
-      remove(watches[toInt(~c[0])], watch{&c, lit_Undef});
-      remove(watches[toInt(~c[1])], watch{&c, lit_Undef});
+      assert(find(watches[toInt(~c[0])], watch{cr, lit_Undef}));
+      assert(find(watches[toInt(~c[1])], watch{cr, lit_Undef}));
+      remove(watches[toInt(~c[0])], watch{cr, lit_Undef});
+      remove(watches[toInt(~c[1])], watch{cr, lit_Undef});
     }
     if (c.learnt()) learnts_literals -= c.size();
     else            clauses_literals -= c.size(); }
@@ -396,7 +747,42 @@ void Solver::detachClause(Clause& c) {
 
 void Solver::removeClause(Clause& c) {
     detachClause(c);
-    free(&c); }
+    c.mark(1);
+    freeClause(c); }
+
+
+void Solver::smudgeWatches(Lit p) {
+    if (!dirty[toInt(p)]) {
+        dirty[toInt(p)] = 1;
+        dirties.push(p);
+    } }
+
+
+void Solver::cleanWatches(Lit p) {
+    vec<watch>* lists[2] = { &watches[toInt(p)], &binwatches[toInt(p)] };
+    for (vec<watch>* ws : lists) {
+        int i, j;
+        for (i = j = 0; i < ws->size(); i++)
+            if (ca[(*ws)[i].cr].mark() != 1)
+                (*ws)[j++] = (*ws)[i];
+        ws->shrink(i - j);
+    }
+    dirty[toInt(p)] = 0; }
+
+
+void Solver::cleanAllWatches() {
+    for (int i = 0; i < dirties.size(); i++)
+        // a literal may appear twice if it was cleaned and smudged again
+        if (dirty[toInt(dirties[i])])
+            cleanWatches(dirties[i]);
+    dirties.clear(); }
+
+
+void Solver::freeClause(Clause& c) {
+    if (c.arena())
+        ca.free(c);
+    else
+        free(&c); }
 
 
 bool Solver::satisfied(const Clause& c) const {
@@ -419,21 +805,32 @@ void Solver::wake_on_lit(Var v, cons *c, void *advice)
 void Solver::wake_on_dom(cspvar x, cons *c, void *advice)
 {
   cspvars[x._id].wake_on_dom.push( make_pair(c, advice) );
+  // a lazy var has x != d events only for the literals it has
+  // created, so its bounds and assignment may change without one
+  if( cspvars[x._id].lazy ) {
+    cspvars[x._id].wake_on_lb.push( make_pair(c, advice) );
+    cspvars[x._id].wake_on_ub.push( make_pair(c, advice) );
+    cspvars[x._id].wake_on_fix.push( make_pair(c, advice) );
+  }
+  wdegRegister(x, c);
 }
 
 void Solver::wake_on_lb(cspvar x, cons *c, void *advice)
 {
   cspvars[x._id].wake_on_lb.push( make_pair(c, advice) );
+  wdegRegister(x, c);
 }
 
 void Solver::wake_on_ub(cspvar x, cons *c, void *advice)
 {
   cspvars[x._id].wake_on_ub.push( make_pair(c, advice) );
+  wdegRegister(x, c);
 }
 
 void Solver::wake_on_fix(cspvar x, cons *c, void *advice)
 {
   cspvars[x._id].wake_on_fix.push( make_pair(c, advice) );
+  wdegRegister(x, c);
 }
 
 void Solver::ensure_can_schedule(cons *c)
@@ -455,24 +852,46 @@ void Solver::schedule_on_dom(cspvar x, cons *c)
 {
   ensure_can_schedule(c);
   cspvars[x._id].schedule_on_dom.push(c->cqidx);
+  // a lazy var has x != d events only for the literals it has
+  // created, so its bounds and assignment may change without one
+  if( cspvars[x._id].lazy ) {
+    cspvars[x._id].schedule_on_lb.push(c->cqidx);
+    cspvars[x._id].schedule_on_ub.push(c->cqidx);
+    cspvars[x._id].schedule_on_fix.push(c->cqidx);
+  }
+  wdegRegister(x, c);
 }
 
 void Solver::schedule_on_lb(cspvar x, cons *c)
 {
   ensure_can_schedule(c);
   cspvars[x._id].schedule_on_lb.push(c->cqidx);
+  wdegRegister(x, c);
 }
 
 void Solver::schedule_on_ub(cspvar x, cons *c)
 {
   ensure_can_schedule(c);
   cspvars[x._id].schedule_on_ub.push(c->cqidx);
+  wdegRegister(x, c);
 }
 
 void Solver::schedule_on_fix(cspvar x, cons *c)
 {
   ensure_can_schedule(c);
   cspvars[x._id].schedule_on_fix.push(c->cqidx);
+  wdegRegister(x, c);
+}
+
+void Solver::wdegRegister(cspvar x, cons *c)
+{
+  cspvar_fixed& xf = cspvars[x._id];
+  // constraints usually register all events on a var together, so
+  // this is enough to count each constraint once per var
+  if( xf.wdeg_last == c ) return;
+  xf.wdeg_last = c;
+  xf.wdeg += c->weight;
+  c->scope.push(x._id);
 }
 
 void Solver::setVarName(Var v, std::string const& name)
@@ -519,18 +938,49 @@ void Solver::cancelUntil(int level) {
             domevent const &pevent = events[toInt(trail[c])];
             if( noevent(pevent) ) continue;
             cspvar_fixed& xf = cspvars[pevent.x._id];
+            if( xf.lazy ) continue;
             switch( pevent.type ) {
             case domevent::NEQ: ++xf.dsize; break;
             case domevent::LEQ: xf.max = max(xf.max, pevent.d+1); break;
             case domevent::GEQ: xf.min = min(xf.min, pevent.d-1); break;
             default: break;
             }
+            branchUpdate(pevent.x._id);
+        }
+        while( lazy_undos.size() > 0 &&
+               lazy_undos.last().trailpos > trail_lim[level] ) {
+          lazy_undo const& u = lazy_undos.last();
+          cspvar_fixed& xf = cspvars[u.x];
+          xf.min = u.min;
+          xf.max = u.max;
+          xf.dsize = u.max - u.min + 1;
+          xf.lazy->minlit = u.minlit;
+          xf.lazy->maxlit = u.maxlit;
+          branchUpdate(u.x);
+          lazy_undos.pop();
         }
         qhead = trail_lim[level];
         trail.shrink(trail.size() - trail_lim[level]);
         trail_lim.shrink(trail_lim.size() - level);
-        memcpy(current_space, backtrackable_space[level],
-               backtrackable_size);
+        if( trail_backtrackable ) {
+          for (int c = bt_trail.size()-1; c >= bt_trail_lim[level]; c--)
+            memcpy(((char*)current_space)+bt_trail[c].offset*sizeof(unsigned),
+                   &bt_trail[c].old, sizeof(unsigned));
+          bt_trail.shrink(bt_trail.size() - bt_trail_lim[level]);
+          bt_trail_lim.shrink(bt_trail_lim.size() - level);
+          bt_new_epoch();
+#ifdef INVARIANTS
+          // a write through deref() is not on the trail, so it would
+          // not be undone
+          assert( !std::memcmp(current_space, backtrackable_space[level],
+                               backtrackable_size) );
+#endif
+        } else
+          memcpy(current_space, backtrackable_space[level],
+                 backtrackable_size);
+        lazy_fixed.clear();
+        if( lazy_recents.size() > 0 )
+          lazy_recheck(level);
     }
 }
 
@@ -542,14 +992,19 @@ btptr Solver::alloc_backtrackable(unsigned size)
   assert(decisionLevel() == 0);
   assert(size > 0);
   btptr p;
-  // make sure the allocation is sizeof(int)-aligned
-  p.offset = unsigned(ceil(double(backtrackable_size)/sizeof(int)))*sizeof(int);
+  // make sure the allocation is 8-byte aligned, so that it can hold
+  // 64-bit counters
+  p.offset = unsigned(ceil(double(backtrackable_size)/sizeof(int64_t)))*sizeof(int64_t);
   backtrackable_size = p.offset+size;
   if( backtrackable_size > backtrackable_cap ) {
+    // keep the capacity a whole number of words, bt_save copies
+    // entire words
     backtrackable_cap = std::max(backtrackable_cap*2,
-                                 backtrackable_size);
+                                 p.offset+size+sizeof(unsigned));
+    backtrackable_cap -= backtrackable_cap % sizeof(unsigned);
     current_space = realloc(current_space, backtrackable_cap);
     if( !current_space ) throw std::bad_alloc();
+    bt_stamp.growTo(backtrackable_cap/sizeof(unsigned), 0);
 
     // free cached allocations
     for(int i = 0; i != backtrackable_space.size(); ++i) {
@@ -583,8 +1038,13 @@ Lit Solver::pickBranchLitVSIDS(int polarity_mode, double random_var_freq)
             next = order_heap.removeMin();
 
     if( next == var_Undef )
-        return lit_Undef;
+        return pickBranchLitLazy();
+
+    return Lit(next, branchSign(next, polarity_mode));
+}
 
+bool Solver::branchSign(Var next, int polarity_mode)
+{
     bool sign = false;
     switch (polarity_mode){
     case polarity_true:  sign = false; break;
@@ -593,16 +1053,34 @@ Lit Solver::pickBranchLitVSIDS(int polarity_mode, double random_var_freq)
     case polarity_rnd:   sign = irand(random_seed, 2); break;
     default: assert(false); }
 
-    if( next != var_Undef && phase_saving && phase[next] != l_Undef )
+    if( phase_saving && phase[next] != l_Undef )
       sign = (phase[next] == l_False);
 
-    return next == var_Undef ? lit_Undef : Lit(next, sign);
+    return sign;
 }
 
-Lit Solver::pickBranchLitLex()
+/* All literals may be assigned while a lazy var is not fixed, because
+   the literals that would fix it do not exist yet. Bisect its domain.
+ */
+Lit Solver::pickBranchLitLazy()
 {
   for(int i = 0; i != cspvars.size(); ++i) {
-    cspvar x(i);
+    cspvar_fixed& xf = cspvars[i];
+    if( xf.lazy && xf.min != xf.max ) {
+      int mid = xf.min + (xf.max - xf.min)/2;
+      return Lit( lazy_leqi(cspvar(i), mid) );
+    }
+  }
+  return lit_Undef;
+}
+
+/* lex_next only moves forward while going down the search tree, and
+   cancelUntil moves it back to the first var it unfixes.
+ */
+Lit Solver::pickBranchLitLex()
+{
+  for(; lex_next != cspvars.size(); ++lex_next) {
+    cspvar x(lex_next);
     if( x.min(*this) != x.max(*this) ) {
       return pickBranchLitFrom(x);
     }
@@ -612,40 +1090,169 @@ Lit Solver::pickBranchLitLex()
   return pickBranchLitVSIDS(polarity_mode, random_var_freq);
 }
 
+/* Fixed cspvars are removed from dom_heap and domwdeg_heap here
+   rather than when they get fixed. cancelUntil puts them back.
+ */
 Lit Solver::pickBranchLitDom()
 {
-  int mind{0};
-  int minv{-1};
-  for(int i = 0; i != cspvars.size(); ++i) {
-    cspvar x(i);
-    if(x.min(*this) != x.max(*this) && (minv == -1 || x.domsize(*this) < mind)) {
-      minv = i;
-      mind = x.domsize(*this);
-    }
+  while( !dom_heap.empty() ) {
+    int x = dom_heap[0];
+    cspvar_fixed& xf = cspvars[x];
+    if( xf.min != xf.max )
+      return pickBranchLitFrom(cspvar(x));
+    dom_heap.removeMin();
   }
-  if (minv != -1)
-    return pickBranchLitFrom(cspvar{minv});
   return pickBranchLitVSIDS(polarity_mode, random_var_freq);
 }
 
+Lit Solver::pickBranchLitDomWdeg()
+{
+  while( !domwdeg_heap.empty() ) {
+    int x = domwdeg_heap[0];
+    cspvar_fixed& xf = cspvars[x];
+    if( xf.min != xf.max )
+      return pickBranchLitFrom(cspvar(x));
+    domwdeg_heap.removeMin();
+  }
+  return pickBranchLitVSIDS(polarity_mode, random_var_freq);
+}
+
+void Solver::branchInit()
+{
+  switch(varbranch) {
+  case VAR_LEX:
+    lex_next = 0;
+    break;
+  case VAR_DOM:
+  case VAR_DOMWDEG:
+    for(int x = 0; x != cspvars.size(); ++x)
+      branchUpdate(x);
+    break;
+  default: break;
+  }
+}
+
+void Solver::branchUpdate(int x)
+{
+  cspvar_fixed& xf = cspvars[x];
+  switch(varbranch) {
+  case VAR_LEX:
+    if( xf.min != xf.max && x < lex_next )
+      lex_next = x;
+    break;
+  case VAR_DOM:
+    if( xf.min == xf.max && !dom_heap.inHeap(x) ) return;
+    dom_heap.update(x);
+    break;
+  case VAR_DOMWDEG:
+    if( xf.min == xf.max && !domwdeg_heap.inHeap(x) ) return;
+    domwdeg_heap.update(x);
+    break;
+  default: break;
+  }
+}
+
+void Solver::wdegBump(cons *c)
+{
+  if( varbranch != VAR_DOMWDEG ) return;
+  ++c->weight;
+  for(int x : c->scope) {
+    cspvars[x].wdeg += 1;
+    if( domwdeg_heap.inHeap(x) )
+      domwdeg_heap.decrease(x);
+  }
+}
+
+/* A clause has no weight of its own: each distinct cspvar that
+   appears in it gets its weighted degree bumped.
+ */
+void Solver::wdegBump(Clause& c)
+{
+  if( varbranch != VAR_DOMWDEG ) return;
+  ++wdeg_counter;
+  for(int i = 0; i != c.size(); ++i) {
+    domevent const& pe = events[toInt(c[i])];
+    if( noevent(pe) ) continue;
+    cspvar_fixed& xf = cspvars[pe.x._id];
+    if( xf.wdeg_stamp == wdeg_counter ) continue;
+    xf.wdeg_stamp = wdeg_counter;
+    xf.wdeg += 1;
+    if( domwdeg_heap.inHeap(pe.x._id) )
+      domwdeg_heap.decrease(pe.x._id);
+  }
+}
+
 Lit Solver::pickBranchLitFrom(cspvar x)
 {
+  int min = x.min(*this), max = x.max(*this);
+  int mid = min + (max - min)/2;
   switch(valbranch) {
-  case VAL_VSIDS: assert(0);
-  case VAL_LEX:   return Lit( x.eqi(*this, x.min(*this)) );
-  case VAL_BISECT:assert(0);
+  case VAL_VSIDS:  return pickBranchLitActive(x);
+  case VAL_LEX:    return Lit( x.eqi(*this, min) );
+  case VAL_MAX:    return Lit( x.eqi(*this, max) );
+  case VAL_MEDIAN: return pickBranchLitMedian(x);
+  case VAL_BISECT: return Lit( x.leqi(*this, mid) );
+  case VAL_REVERSE_BISECT: return ~Lit( x.leqi(*this, mid) );
   }
   assert(0);
 }
 
+Lit Solver::pickBranchLitMedian(cspvar x)
+{
+  int min = x.min(*this), max = x.max(*this);
+  // the domain of a lazy var is [min, max] minus the x = d literals
+  // that are false, so its domsize overestimates. Count instead
+  int size = 0;
+  for(int d = min; d <= max; ++d)
+    if( x.indomainUnsafe(*this, d) ) ++size;
+  int k = (size-1)/2;
+  for(int d = min; d <= max; ++d)
+    if( x.indomainUnsafe(*this, d) && k-- == 0 )
+      return Lit( x.eqi(*this, d) );
+  assert(0);
+  return lit_Undef;
+}
+
+/* Only the literals that already exist are candidates, so this never
+   materializes literals of a lazy var, unless none of its literals
+   are unassigned. Then we bisect, like pickBranchLitLazy.
+ */
+Lit Solver::pickBranchLitActive(cspvar x)
+{
+  cspvar_fixed& xf = cspvars[x._id];
+  Var best = var_Undef;
+  auto consider = [&](Var v) {
+    if( v != var_Undef && value(v) == l_Undef &&
+        (best == var_Undef || activity[v] > activity[best]) )
+      best = v;
+  };
+  if( xf.lazy ) {
+    lazy_domain& ld = *xf.lazy;
+    for(auto i = ld.eq.lower_bound(xf.min);
+        i != ld.eq.end() && i->first <= xf.max; ++i)
+      consider(i->second);
+    for(auto i = ld.leq.lower_bound(xf.min);
+        i != ld.leq.end() && i->first < xf.max; ++i)
+      consider(i->second);
+  } else {
+    for(int d = xf.min; d <= xf.max; ++d) {
+      consider(xf.eqiUnsafe(d));
+      if( d < xf.max )
+        consider(xf.leqiUnsafe(d));
+    }
+  }
+  if( best == var_Undef )
+    return Lit( x.leqi(*this, xf.min + (xf.max - xf.min)/2) );
+  return Lit(best, branchSign(best, polarity_mode));
+}
+
 Lit Solver::pickBranchLit(int polarity_mode, double random_var_freq)
 {
   switch(varbranch) {
   case VAR_VSIDS: return pickBranchLitVSIDS(polarity_mode, random_var_freq);
   case VAR_LEX:   return pickBranchLitLex();
   case VAR_DOM:   return pickBranchLitDom();
-  case VAR_DOMWDEG:
-    assert(0);
+  case VAR_DOMWDEG: return pickBranchLitDomWdeg();
   case VAR_USER: {
       assert(user_brancher);
       user_candidates.clear();
@@ -747,8 +1354,11 @@ void Solver::analyze(Clause* inconfl, vec<Lit>& out_learnt, int& out_btlevel)
         if (confl.has<Clause>()) {
           auto &c = *confl.get<Clause>();
 
-          if (c.learnt())
+          if (c.learnt()) {
             claBumpActivity(c);
+            if (learnt_policy == LEARNTS_LBD)
+              updateLBD(c);
+          }
 
           resolve_with(c);
         } else {
@@ -838,11 +1448,7 @@ bool Solver::litRedundant(Lit p, uint32_t abstract_levels)
 {
     analyze_stack.clear(); analyze_stack.push(p);
     int top = analyze_toclear.size();
-    while (analyze_stack.size() > 0){
-        assert(reason[var(analyze_stack.last())]);
-        Clause& c = *explicit_reason(~analyze_stack.last());
-        analyze_stack.pop();
-
+    auto redundant_with = [&](auto &c) {
         for (int i = 0; i < c.size(); i++){
             if( c[i] == p ) continue;
             Lit p  = c[i];
@@ -859,6 +1465,25 @@ bool Solver::litRedundant(Lit p, uint32_t abstract_levels)
                 }
             }
         }
+        return true;
+    };
+    while (analyze_stack.size() > 0){
+        Lit q = ~analyze_stack.last();
+        assert(reason[var(q)]);
+        analyze_stack.pop();
+
+        // the encoding clauses are cheap to rebuild, so do not make
+        // them explicit
+        if (encoding_reason(var(q))) {
+            auto &c = redundant_explbuffer;
+            c.clear();
+            explain_encoding(
+                static_cast<encoding_explainer *>(
+                    reason[var(q)].get<explainer>())->kind, q, c);
+            if (!redundant_with(c))
+                return false;
+        } else if (!redundant_with(*explicit_reason(q)))
+            return false;
     }
 
     return true;
@@ -873,6 +1498,9 @@ Clause *Solver::explicit_reason(Lit p) {
   if (r.has<Clause>())
     return r.get<Clause>();
 
+  // explain the literal that is true, whichever sign p has
+  if (value(p) == l_False)
+    p = ~p;
   auto *e = r.get<explainer>();
   auto &explbuffer = analyze_explbuffer;
   explbuffer.clear();
@@ -888,7 +1516,7 @@ Clause *Solver::explicit_reason(Lit p) {
           assert(q == p
               || (value(q) == l_False && level[var(q)] <= level[var(p)]));
 
-  auto *cl = Clause_new(explbuffer);
+  auto *cl = allocClause(explbuffer);
   r.set(cl);
   addInactiveClause(cl);
   return cl;
@@ -1034,11 +1662,14 @@ void Solver::debugclause(Clause *from, cons *c)
   // add all variables
   int nv = nVars();
   s1.watches.growTo(2*nv);
+  s1.binwatches.growTo(2*nv);
+  s1.dirty.growTo(2*nv, 0);
   s1.wakes_on_lit.growTo(nv);
   s1.sched_on_lit.growTo(nv);
   s1.reason.growTo(nv);
   s1.assigns.growTo(nv, toInt(l_Undef));
   s1.level.growTo(nv, -1);
+  s1.trailpos.growTo(nv, -1);
   s1.activity.growTo(nv, 0);
   s1.seen.growTo(nv, 0);
 
@@ -1060,11 +1691,22 @@ void Solver::debugclause(Clause *from, cons *c)
     xf.min = xf.omin;
     xf.max = xf.omax;
     xf.dsize = xf.max - xf.min + 1;
-    if( xf.min == xf.max ) {
+    if( xf.lazy ) {
+      vec<Clause*> const& lc = cspvars[i].lazy->clauses;
+      for(int j = 0; j != lc.size(); ++j) {
+        Clause *c = s1.ca.lea(s1.ca.allocCopy(*lc[j]));
+        xf.lazy->clauses.push(c);
+        s1.attachClause(*c);
+      }
+      Lit omaxlit = Lit(xf.lazy->findleq(xf.omax));
+      xf.lazy->minlit = lit_Undef;
+      xf.lazy->maxlit = omaxlit;
+      s1.uncheckedEnqueue_np(omaxlit, NO_REASON);
+    } else if( xf.min == xf.max ) {
       s1.uncheckedEnqueue_np(Lit(cspvars[i].firstbool+1), NO_REASON);
       s1.uncheckedEnqueue_np(Lit(cspvars[i].firstbool), NO_REASON);
     } else
-      x.setmax(s1, xf.max, (Clause*)0L);
+      s1.uncheckedEnqueue(Lit(xf.leqi(xf.omax)), (Clause*)0L);
   }
 
   setvars.copyTo(s1.setvars);
@@ -1168,6 +1810,7 @@ void Solver::uncheckedEnqueue_np(Lit p, explanation_ptr from)
     assert(value(p) == l_Undef);
     assigns [var(p)] = toInt(lbool(!sign(p)));  // <<== abstract but not uttermost effecient
     level   [var(p)] = decisionLevel();
+    trailpos[var(p)] = trail.size();
     if (reason[var(p)] && reason[var(p)].has<explainer>())
         reason[var(p)].get<explainer>()->release();
     reason  [var(p)] = from;
@@ -1186,6 +1829,13 @@ void Solver::uncheckedEnqueue_np(Lit p, explanation_ptr from)
       }
       assert(foundp);
     }
+    if (encoding_reason(var(p))) {
+      vec<Lit> c;
+      explain_encoding(static_cast<encoding_explainer *>(
+                           from.get<explainer>())->kind, p, c);
+      for(int i = 1; i != c.size(); ++i)
+        assert( value(c[i]) == l_False );
+    }
 #endif
 }
 
@@ -1197,8 +1847,9 @@ void Solver::uncheckedEnqueue_np(Lit p, explanation_ptr from)
    correct reasons.
 
    A minor advantage of this is that it's probably faster than doing
-   unit propagation and does not bring the clauses ps1...ps4 into the
-   cache.
+   unit propagation. The clauses of the encoding are never stored:
+   the reasons are the explainers in encoding_expl, which rebuild the
+   clause only when conflict analysis needs it.
  */
 void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
 {
@@ -1234,21 +1885,26 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
     domevent const &pevent = events[toInt(p)];
     if( noevent(pevent) ) return;
     cspvar_fixed& xf = cspvars[pevent.x._id];
+    if( xf.lazy ) {
+      lazy_update(xf, p, pevent);
+      branchUpdate(pevent.x._id);
+      return;
+    }
     if( pevent.type == domevent::EQ ) {
       xf.dsize = 1;
       xf.min = xf.max = pevent.d;
       // propagate towards max
       if( value(xf.leqiUnsafe(pevent.d)) != l_True ) {
         uncheckedEnqueue_np( Lit(xf.leqiUnsafe(pevent.d)),
-                             xf.ps2[pevent.d-xf.omin] );
+                             enc_expl(ENC_EQ_LEQ) );
         if( value(xf.eqiUnsafe(pevent.d+1)) != l_False)
           uncheckedEnqueue_np( ~Lit(xf.eqiUnsafe(pevent.d+1)),
-                               xf.ps3[pevent.d+1-xf.omin] );
+                               enc_expl(ENC_EQ_GEQ) );
         int leq = pevent.d+1;
         while( leq < xf.omax && value(xf.leqiUnsafe(leq)) != l_True ) {
-          uncheckedEnqueue_np( Lit(xf.leqiUnsafe(leq)), xf.ps1[leq-1-xf.omin] );
+          uncheckedEnqueue_np( Lit(xf.leqiUnsafe(leq)), enc_expl(ENC_LEQ_CHAIN) );
           if( value(xf.eqiUnsafe(leq+1)) != l_False)
-            uncheckedEnqueue_np( ~Lit(xf.eqiUnsafe(leq+1)), xf.ps3[leq+1-xf.omin] );
+            uncheckedEnqueue_np( ~Lit(xf.eqiUnsafe(leq+1)), enc_expl(ENC_EQ_GEQ) );
           ++leq;
         }
       }
@@ -1256,15 +1912,15 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
       if( pevent.d > xf.omin &&
           value(xf.leqiUnsafe(pevent.d-1)) != l_False ) {
         uncheckedEnqueue_np( ~Lit(xf.leqiUnsafe(pevent.d-1)),
-                             xf.ps3[pevent.d-xf.omin] );
+                             enc_expl(ENC_EQ_GEQ) );
         if( value(xf.eqiUnsafe(pevent.d-1)) != l_False)
           uncheckedEnqueue_np( ~Lit(xf.eqiUnsafe(pevent.d-1)),
-                               xf.ps2[pevent.d-1-xf.omin] );
+                               enc_expl(ENC_EQ_LEQ) );
         int geq = pevent.d-2;
         while( geq >= xf.omin && value(xf.leqiUnsafe(geq)) != l_False ) {
-          uncheckedEnqueue_np( ~Lit(xf.leqiUnsafe(geq)), xf.ps1[geq-xf.omin] );
+          uncheckedEnqueue_np( ~Lit(xf.leqiUnsafe(geq)), enc_expl(ENC_LEQ_CHAIN) );
           if( value(xf.eqiUnsafe(geq)) != l_False )
-            uncheckedEnqueue_np( ~Lit(xf.eqiUnsafe(geq)), xf.ps2[geq-xf.omin] );
+            uncheckedEnqueue_np( ~Lit(xf.eqiUnsafe(geq)), enc_expl(ENC_EQ_LEQ) );
           --geq;
         }
       }
@@ -1278,7 +1934,7 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
                   (xf.min == xf.omin ||
                    value(xf.leqiUnsafe(xf.min-1)) == l_False ));
           uncheckedEnqueue_np( ~Lit( xf.leqiUnsafe(xf.min) ),
-                               xf.ps4[xf.min-xf.omin] );
+                               enc_expl(ENC_LEQ_EQ) );
           ++xf.min;
         }
       }
@@ -1288,7 +1944,7 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
                    value(xf.leqiUnsafe(xf.max)) == l_True) &&
                   value(xf.leqiUnsafe(xf.max-1)) != l_False );
           uncheckedEnqueue_np( Lit( xf.leqiUnsafe(xf.max-1) ),
-                               xf.ps4[xf.max-xf.omin] );
+                               enc_expl(ENC_LEQ_EQ) );
           --xf.max;
         }
       }
@@ -1297,15 +1953,15 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
     if( pevent.type == domevent::GEQ ) {
       int geq = pevent.d-1;
       if( value(xf.eqiUnsafe(geq)) != l_False ) {
-        uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(geq)), xf.ps2[geq-xf.omin] );
+        uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(geq)), enc_expl(ENC_EQ_LEQ) );
         --xf.dsize;
       }
       while(geq > xf.omin &&
             value( xf.leqiUnsafe(geq-1) ) != l_False ) {
         uncheckedEnqueue_np( ~Lit(xf.leqiUnsafe(geq-1)),
-                             xf.ps1[geq-1-xf.omin] );
+                             enc_expl(ENC_LEQ_CHAIN) );
         if( value(xf.eqiUnsafe(geq-1)) != l_False ) {
-          uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(geq-1)), xf.ps2[geq-1-xf.omin] );
+          uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(geq-1)), enc_expl(ENC_EQ_LEQ) );
           --xf.dsize;
         }
         --geq;
@@ -1315,21 +1971,21 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
         assert( value(xf.leqiUnsafe(xf.min)) != l_False &&
                 value(xf.leqiUnsafe(xf.min-1)) == l_False );
         uncheckedEnqueue_np( ~Lit( xf.leqiUnsafe(xf.min) ),
-                             xf.ps4[xf.min-xf.omin] );
+                             enc_expl(ENC_LEQ_EQ) );
         ++xf.min;
       }
     }
     if( pevent.type == domevent::LEQ ) {
       int leq = pevent.d+1;
       if( leq <= xf.omax && value(xf.eqiUnsafe(leq)) != l_False ) {
-        uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(leq)), xf.ps3[leq-xf.omin] );
+        uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(leq)), enc_expl(ENC_EQ_GEQ) );
         --xf.dsize;
       }
       while( leq < xf.omax &&
              value( xf.leqiUnsafe(leq) ) != l_True ) {
-        uncheckedEnqueue_np( Lit( xf.leqiUnsafe(leq) ), xf.ps1[leq-1-xf.omin] );
+        uncheckedEnqueue_np( Lit( xf.leqiUnsafe(leq) ), enc_expl(ENC_LEQ_CHAIN) );
         if( value(xf.eqiUnsafe(leq+1)) != l_False ) {
-          uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(leq+1)), xf.ps3[leq+1-xf.omin] );
+          uncheckedEnqueue_np( ~Lit( xf.eqiUnsafe(leq+1)), enc_expl(ENC_EQ_GEQ) );
           --xf.dsize;
         }
         ++leq;
@@ -1339,7 +1995,7 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
         assert( value(xf.leqiUnsafe(xf.max)) == l_True &&
                 value(xf.leqiUnsafe(xf.max-1)) != l_False );
         uncheckedEnqueue_np( Lit( xf.leqiUnsafe(xf.max-1) ),
-                             xf.ps4[xf.max-xf.omin] );
+                             enc_expl(ENC_LEQ_EQ) );
         --xf.max;
       }
     }
@@ -1347,7 +2003,8 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
     if( xf.max == xf.min &&
         value( xf.eqiUnsafe(xf.max) ) != l_True )
       uncheckedEnqueue_np( Lit(xf.eqiUnsafe(xf.max)),
-                           xf.ps4[xf.max-xf.omin] );
+                           enc_expl(ENC_LEQ_EQ) );
+    branchUpdate(pevent.x._id);
 
 #ifdef INVARIANTS
     for(int i = xf.omin; i != xf.omax; ++i ) {
@@ -1361,6 +2018,66 @@ void Solver::uncheckedEnqueue_common(Lit p, explanation_ptr from)
 #endif
 }
 
+/* Rebuild the clause of the encoding that forced p, given which
+   family it belongs to. The event of p tells us which of the
+   literals of the clause p is.
+ */
+void Solver::explain_encoding(encoding_clause k, Lit p, vec<Lit>& c)
+{
+  domevent const& pe = events[toInt(p)];
+  cspvar_fixed& xf = cspvars[pe.x._id];
+  int d = pe.d;
+  c.push(p);
+  switch(k) {
+  case ENC_LEQ_CHAIN:
+    if( pe.type == domevent::LEQ )
+      c.push( ~Lit(xf.leqiUnsafe(d-1)) );
+    else {
+      assert(pe.type == domevent::GEQ);
+      c.push( Lit(xf.leqiUnsafe(d)) );
+    }
+    break;
+  case ENC_EQ_LEQ:
+    if( pe.type == domevent::LEQ )
+      c.push( ~Lit(xf.eqiUnsafe(d)) );
+    else {
+      assert(pe.type == domevent::NEQ);
+      c.push( Lit(xf.leqiUnsafe(d)) );
+    }
+    break;
+  case ENC_EQ_GEQ:
+    if( pe.type == domevent::GEQ )
+      c.push( ~Lit(xf.eqiUnsafe(d)) );
+    else {
+      assert(pe.type == domevent::NEQ);
+      c.push( ~Lit(xf.leqiUnsafe(d-1)) );
+    }
+    break;
+  case ENC_LEQ_EQ:
+    switch(pe.type) {
+    case domevent::GEQ: // -(x <= d-1)
+      if( d-1 > xf.omin )
+        c.push( Lit(xf.leqiUnsafe(d-2)) );
+      c.push( Lit(xf.eqiUnsafe(d-1)) );
+      break;
+    case domevent::LEQ: // (x <= d), the value d+1 was removed
+      c.push( ~Lit(xf.leqiUnsafe(d+1)) );
+      c.push( Lit(xf.eqiUnsafe(d+1)) );
+      break;
+    case domevent::EQ:
+      c.push( ~Lit(xf.leqiUnsafe(d)) );
+      if( d > xf.omin )
+        c.push( Lit(xf.leqiUnsafe(d-1)) );
+      break;
+    default:
+      assert(0);
+    }
+    break;
+  case ENC_NUM:
+    assert(0);
+  }
+}
+
 void Solver::uncheckedEnqueue(Lit p, Clause* from)
 {
     uncheckedEnqueue_common(p, explanation_ptr(from));
@@ -1384,7 +2101,7 @@ Clause *Solver::enqueueFill(Lit p, vec<Lit>& ps)
       }
     }
   ps.push(p);
-  Clause *r = Clause_new(ps, false, p);
+  Clause *r = allocClause(ps, false, p);
   ps.pop();
   addInactiveClause(r);
   if( value(p) == l_False ) return r;
@@ -1489,6 +2206,7 @@ Clause *Solver::propagate_wakes(Lit p, const vec<wake_stub>& wakes)
       }
       if (debugclauses)
         debugclause(confl, con);
+      wdegBump(con);
       qhead = trail.size();
       break;
     }
@@ -1521,15 +2239,20 @@ Clause* Solver::propagate_inner()
     while (qhead < trail.size()){
         Lit p   = trail[qhead++];     // 'p' is enqueued fact to propagate.
 
+        // deleted clauses are purged in the same sweep that deletes them
+        assert(!dirty[toInt(p)]);
+
         // binary clauses first
         vec<watch>& bws = binwatches[toInt(p)];
         for(watch w : bws) {
             Lit other = w.block;
             assert(other != lit_Undef);
-            if (value(other) == l_False)
-                return w.c;
+            if (value(other) == l_False) {
+                wdegBump(ca[w.cr]);
+                return ca.lea(w.cr);
+            }
             else if (value(other) != l_True)
-                uncheckedEnqueue(other, w.c);
+                uncheckedEnqueue(other, ca.lea(w.cr));
         }
 
 
@@ -1547,7 +2270,7 @@ Clause* Solver::propagate_inner()
           }
 
           ++i;
-          Clause &c = *w.c;
+          Clause &c = ca[w.cr];
 
           // Make sure the false literal is data[1]:
           Lit false_lit = ~p;
@@ -1589,7 +2312,8 @@ Clause* Solver::propagate_inner()
           if (value(first) == l_False) {
             if (trace)
               cout << "Clause " << print(*this, &c) << " failed\n";
-            confl = w.c;
+            confl = &c;
+            wdegBump(c);
             qhead = trail.size();
             // Copy the remaining watches:
             while (i < end)
@@ -1603,6 +2327,18 @@ Clause* Solver::propagate_inner()
         if(confl)
           break;
 
+        /* Lazy cspvars fixed by the above get their x = d literal
+           here, because we hold no references into the watch lists
+           now. Its event wakes the wake_on_fix constraints, as with
+           eager vars.
+         */
+        while( lazy_fixed.size() > 0 ) {
+          cspvar x(lazy_fixed.last());
+          lazy_fixed.pop();
+          if( x.min(*this) == x.max(*this) )
+            lazy_eqi(x, x.min(*this));
+        }
+
         confl = propagate_wakes(p, wakes_on_lit[var(p)]);
         if(confl)
           break;
@@ -1698,6 +2434,7 @@ Clause *Solver::propagate()
         }
         if( debugclauses )
           debugclause(confl, consqs[next].c);
+        wdegBump(consqs[next].c);
         qhead = trail.size();
         reset_queue();
         return confl;
@@ -1722,14 +2459,28 @@ Clause *Solver::propagate()
 |  Description:
 |    Remove half of the learnt clauses, minus the clauses locked by the current assignment. Locked
 |    clauses are clauses that are reason to some assignment. Binary clauses are never removed.
+|    With LEARNTS_LBD, only the local tier is halved. Tier-2 clauses that were not used in
+|    conflict analysis since the previous reduction are moved to the local tier, and core clauses
+|    are never removed.
 |________________________________________________________________________________________________@*/
 struct reduceDB_lt { bool operator () (Clause* x, Clause* y) { return x->size() > 2 && (y->size() == 2 || x->activity() < y->activity()); } };
 void Solver::reduceDB()
+{
+    if (learnt_policy == LEARNTS_LBD)
+        reduceDBTiered();
+    else
+        reduceDBActivity();
+    cleanAllWatches();
+}
+
+void Solver::reduceDBActivity()
 {
     int     i, j;
     double  extra_lim = cla_inc / learnts.size();    // Remove any clause below this activity
 
-    sort(learnts, reduceDB_lt());
+    // only the halves matter, not the order within them
+    std::nth_element(learnts.begin(), learnts.begin() + learnts.size() / 2,
+                     learnts.end(), reduceDB_lt());
     for (i = j = 0; i < learnts.size() / 2; i++){
         if (learnts[i]->size() > 2 && !locked(*learnts[i]))
             removeClause(*learnts[i]);
@@ -1745,12 +2496,53 @@ void Solver::reduceDB()
     learnts.shrink(i - j);
 }
 
+void Solver::reduceDBTiered()
+{
+    int i, j, nlocal = 0;
+
+    // move the local tier to the front
+    for (i = 0; i < learnts.size(); i++) {
+        Clause& c = *learnts[i];
+        if (c.tier() == Clause::TIER2 && !c.used())
+            c.tier(Clause::LOCAL);
+        if (c.tier() == Clause::LOCAL)
+            std::swap(learnts[nlocal++], learnts[i]);
+    }
+
+    std::nth_element(learnts.begin(), learnts.begin() + nlocal / 2,
+                     learnts.begin() + nlocal, reduceDB_lt());
+    for (i = j = 0; i < learnts.size(); i++) {
+        Clause& c = *learnts[i];
+        // local clauses used since the last reduction get another round
+        if (i < nlocal / 2 && c.size() > 2 && !c.used() && !locked(c))
+            removeClause(c);
+        else {
+            c.used(false);
+            learnts[j++] = learnts[i];
+        }
+    }
+    learnts.shrink(i - j);
+}
+
+void Solver::updateLBD(Clause& c)
+{
+    c.used(true);
+    if (c.tier() == Clause::CORE)
+        return;
+    int lbd = computeLBD(c);
+    if (lbd < (int)c.lbd()) {
+        c.lbd(lbd);
+        if (lbdTier(lbd) < c.tier())
+            c.tier(lbdTier(lbd));
+    }
+}
+
 void Solver::gcInactive()
 {
   int i,j;
   for(i = j = 0; i < inactive.size(); ++i) {
     if( !locked(*inactive[i]) )
-      free(inactive[i]);
+      freeClause(*inactive[i]);
     else
       inactive[j++] = inactive[i];
   }
@@ -1767,6 +2559,79 @@ void Solver::removeSatisfied(vec<Clause*>& cs)
             cs[j++] = cs[i];
     }
     cs.shrink(i - j);
+    cleanAllWatches();
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  garbageCollect : [void]  ->  [void]
+|
+|  Description:
+|    Copy the live clauses to a fresh region, in the order of the watch lists so that the clauses
+|    propagate() visits together end up close together, and release the old region. A clause is
+|    live if it is watched, is the reason of an assigned literal or is in one of the clause lists.
+|    Clauses from Clause_new() are not in the region and stay where they are. Must only be called
+|    between propagations, since it invalidates every Clause* held by a constraint.
+|________________________________________________________________________________________________@*/
+void Solver::checkGarbage()
+{
+    if (ca.wasted() > ca.size() * garbage_frac)
+        garbageCollect();
+}
+
+void Solver::garbageCollect()
+{
+    ClauseAllocator to;
+    relocAll(to);
+    if (verbosity >= 2)
+        reportf("|  Garbage collection:   %12llu bytes => %12llu bytes             |\n",
+                (unsigned long long)(ca.size()*sizeof(uint32_t)),
+                (unsigned long long)((ca.size() - ca.wasted())*sizeof(uint32_t)));
+    to.moveTo(ca);
+}
+
+void Solver::reloc(Clause*& c, ClauseAllocator& to)
+{
+    if (c && c != INVALID_CLAUSE && c->arena())
+        c = to.lea(ca.reloc(*c, to));
+}
+
+void Solver::relocAll(ClauseAllocator& to)
+{
+    cleanAllWatches();
+    for (int i = 0; i < watches.size(); i++) {
+        vec<watch>& ws = watches[i];
+        for (int j = 0; j < ws.size(); j++)
+            ws[j].cr = ca.reloc(ca[ws[j].cr], to);
+    }
+    for (int i = 0; i < binwatches.size(); i++) {
+        vec<watch>& ws = binwatches[i];
+        for (int j = 0; j < ws.size(); j++)
+            ws[j].cr = ca.reloc(ca[ws[j].cr], to);
+    }
+
+    for (int i = 0; i < trail.size(); i++) {
+        Var v = var(trail[i]);
+        auto r = reason[v];
+        if (!r.has<Clause>()) continue;
+        Clause *c = r.get<Clause>();
+        reloc(c, to);
+        reason[v] = explanation_ptr(c);
+    }
+
+    for (int i = 0; i < learnts.size(); i++)
+        reloc(learnts[i], to);
+    for (int i = 0; i < clauses.size(); i++)
+        reloc(clauses[i], to);
+    for (int i = 0; i < inactive.size(); i++)
+        reloc(inactive[i], to);
+    for (int i = 0; i != cspvars.size(); ++i) {
+        lazy_domain *ld = cspvars[i].lazy;
+        if (!ld) continue;
+        for (int j = 0; j != ld->clauses.size(); ++j)
+            reloc(ld->clauses[j], to);
+    }
 }
 
 
@@ -1792,6 +2657,7 @@ bool Solver::simplify()
     removeSatisfied(learnts);
     if (remove_satisfied)        // Can be turned off.
         removeSatisfied(clauses);
+    checkGarbage();
 
     // Remove fixed variables from the variable heap:
     order_heap.filter(VarFilter(*this));
@@ -1803,6 +2669,20 @@ bool Solver::simplify()
 }
 
 
+bool Solver::glucoseRestarts() const
+{
+    // without learning there are no LBDs to average
+    return restart_policy == RESTART_GLUCOSE && learning;
+}
+
+bool Solver::restartNow(int conflictC, int nof_conflicts) const
+{
+    if (glucoseRestarts())
+        return lbd_queue.isvalid()
+            && lbd_queue.getavg() * restart_K > (double)sum_lbd / conflicts;
+    return nof_conflicts >= 0 && conflictC >= nof_conflicts;
+}
+
 /*_________________________________________________________________________________________________
 |
 |  search : (nof_conflicts : int) (nof_learnts : int) (params : const SearchParams&)  ->  [lbool]
@@ -1847,6 +2727,15 @@ lbool Solver::search(int nof_conflicts, double* nof_learnts)
                 return l_False;
             }
 
+            if (glucoseRestarts()) {
+                // a much longer trail than usual may mean we are
+                // close to a solution, so do not restart yet
+                if (conflicts > (uint64_t)blocking_first && lbd_queue.isvalid()
+                    && trail.size() > restart_R * trail_queue.getavg())
+                    lbd_queue.fastclear();
+                trail_queue.push(trail.size());
+            }
+
             if (!learning) {
               if (!clause_callbacks.empty()) {
                   // we learn no clause, only implicitly the set of
@@ -1940,10 +2829,16 @@ lbool Solver::search(int nof_conflicts, double* nof_learnts)
             }
             assert(value(learnt_clause[0]) == l_Undef);
 
+            int lbd = computeLBD(learnt_clause);
+            lbd_queue.push(lbd);
+            sum_lbd += lbd;
+
             if (learnt_clause.size() == 1){
                 uncheckedEnqueue(learnt_clause[0]);
             }else{
-                Clause* c = Clause_new(learnt_clause, true);
+                Clause* c = allocClause(learnt_clause, true);
+                c->lbd(lbd);
+                c->tier(lbdTier(lbd));
                 learnts.push(c);
                 attachClause(*c);
                 claBumpActivity(*c);
@@ -1999,11 +2894,10 @@ lbool Solver::search(int nof_conflicts, double* nof_learnts)
             newDecisionLevel();
 
 
-            if (restarting &&
-                nof_conflicts >= 0 && conflictC >= nof_conflicts){
-                // Reached bound on number of conflicts:
+            if (restarting && restartNow(conflictC, nof_conflicts)){
                 if (trace)
                     cout << "Restarting\n";
+                lbd_queue.fastclear();
                 progress_estimate = progressEstimate();
                 cancelUntil(0);
                 return l_Undef; }
@@ -2015,6 +2909,8 @@ lbool Solver::search(int nof_conflicts, double* nof_learnts)
                 *nof_learnts   *= learntsize_inc;
             }
 
+            checkGarbage();
+
             Lit next = lit_Undef;
             while (decisionLevel() < assumptions.size()){
                 // Perform user provided assumption:
@@ -2117,21 +3013,36 @@ lbool Solver::solveBudget(const vec<Lit>& assumps)
     int lubybits = 0;
     int lubymult = 1;
 
+    lbd_queue.initSize(lbd_queue_size);
+    trail_queue.initSize(trail_queue_size);
+
+    branchInit();
+
     // Search:
     while (status == l_Undef && !interrupt_requested && withinBudget()) {
         if (verbosity >= 1)
             reportf("| %9d | %7d %8d %8d | %8d %8d %6.0f | %6.3f %% |\n", (int)conflicts, order_heap.size(), nClauses(), (int)clauses_literals, (int)nof_learnts, nLearnts(), (double)learnts_literals/nLearnts(), progress_estimate*100), fflush(stdout);
-        if( !lubybits ) {
-          ++lubycounter;
-          lubybits = lubycounter ^ (lubycounter-1);
-          lubymult = 1;
+        switch (glucoseRestarts() || restart_policy == RESTART_GEOMETRIC
+                ? restart_policy : RESTART_LUBY) {
+        case RESTART_LUBY:
+          if( !lubybits ) {
+            ++lubycounter;
+            lubybits = lubycounter ^ (lubycounter-1);
+            lubymult = 1;
+          }
+          nof_conflicts = lubymult * restart_first;
+          lubybits >>= 1;
+          lubymult <<= 1;
+          break;
+        case RESTART_GEOMETRIC:
+          break;
+        case RESTART_GLUCOSE:
+          nof_conflicts = -1; // search() decides by itself
+          break;
         }
-        //printf("lubymult %d, nof_learnts %f\n", lubymult, nof_learnts);
-        nof_conflicts = lubymult * restart_first;
-        //nof_conflicts *= restart_inc;
-        lubybits >>= 1;
-        lubymult <<= 1;
         status = search((int)nof_conflicts, &nof_learnts);
+        if (restart_policy == RESTART_GEOMETRIC)
+          nof_conflicts *= restart_inc;
     }
 
     if (verbosity >= 1)
@@ -2189,10 +3100,9 @@ void Solver::excludeLast()
 {
   vec<Lit> exclude;
   for(int i = 0; i != cspvars.size(); ++i) {
-    cspvar_fixed & xf = cspvars[i];
     pair<int, int> pi = cspmodel[i];
     assert( pi.first == pi.second );
-    exclude.push( ~Lit(xf.eqi( pi.first )) );
+    exclude.push( ~Lit(cspvar(i).eqi(*this, pi.first)) );
   }
   for(int i = 0; i != setvars.size(); ++i) {
     setvar_data & xd = setvars[i];
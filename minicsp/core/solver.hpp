@@ -51,6 +51,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "minicsp/mtl/Vec.h"
 #include "minicsp/mtl/Heap.h"
 #include "minicsp/mtl/Alg.h"
+#include "minicsp/mtl/BoundedQueue.h"
 
 #include "solvertypes.hpp"
 
@@ -78,8 +79,36 @@ enum BranchHeuristic {
     VAR_VSIDS, VAR_LEX, VAR_DOM, VAR_DOMWDEG, VAR_USER
 };
 
+/* Value branching heuristics: VAL_LEX tries x = min, VAL_MAX x = max
+ * and VAL_MEDIAN x = the median value of the domain. VAL_BISECT tries
+ * x <= mid, the lower half of the domain, and VAL_REVERSE_BISECT x >
+ * mid. VAL_VSIDS picks the most active unassigned x = d or x <= d
+ * literal of the var, with the polarity of VSIDS.
+ */
 enum ValBranchHeuristic {
-    VAL_VSIDS, VAL_LEX, VAL_BISECT
+    VAL_VSIDS, VAL_LEX, VAL_BISECT, VAL_MAX, VAL_MEDIAN, VAL_REVERSE_BISECT
+};
+
+/* Learnt clause database policies: LEARNTS_ACTIVITY removes the less
+ * active half of the learnt clauses at every reduction. LEARNTS_LBD
+ * keeps clauses by their literal block distance in three tiers: core
+ * clauses forever, tier-2 clauses while they are used, and local
+ * clauses by activity as above.
+ */
+enum LearntPolicy {
+    LEARNTS_ACTIVITY, LEARNTS_LBD
+};
+
+/* Restart policies: RESTART_LUBY restarts after restart_first times
+ * the next term of the Luby sequence conflicts, RESTART_GEOMETRIC
+ * after restart_first, then restart_first*restart_inc, ...
+ * conflicts. RESTART_GLUCOSE restarts when the LBD of the recent
+ * learnt clauses is high compared to the average, unless the trail
+ * is much longer than usual. It needs learning: without it,
+ * RESTART_GLUCOSE falls back to RESTART_LUBY.
+ */
+enum RestartPolicy {
+    RESTART_LUBY, RESTART_GEOMETRIC, RESTART_GLUCOSE
 };
 
 class Solver {
@@ -90,6 +119,19 @@ public:
         VarOrderLt(const vec<double>&  act) : activity(act) { }
     };
 
+    struct DomLt {
+        const vec<cspvar_fixed>& xs;
+        bool operator () (int x, int y) const { return xs[x].dsize < xs[y].dsize || (xs[x].dsize == xs[y].dsize && x < y); }
+        DomLt(const vec<cspvar_fixed>& pxs) : xs(pxs) { }
+    };
+
+    struct DomWdegLt {
+        const vec<cspvar_fixed>& xs;
+        // dom/wdeg of x < dom/wdeg of y, in 64 bits as wdeg only grows
+        bool operator () (int x, int y) const { return (int64_t)xs[x].dsize * xs[y].wdeg < (int64_t)xs[y].dsize * xs[x].wdeg; }
+        DomWdegLt(const vec<cspvar_fixed>& pxs) : xs(pxs) { }
+    };
+
 public:
 
     // Constructor/Destructor:
@@ -101,6 +143,7 @@ public:
     //
     Var     newVar    (bool polarity = true, bool dvar = true); // Add a new variable with parameters specifying variable mode.
     cspvar  newCSPVar (int min, int max);                       // Add a CSP (multi-valued) var with the given lower and upper bounds
+    cspvar  newLazyCSPVar(int min, int max);                    // As above, but the propositional encoding of the domain is created on demand
     std::vector<cspvar> newCSPVarArray(int n, int min, int max);// Add a number of identical CSP vars
     setvar  newSetVar (int min, int max);                       // Add a CSP (multi-valued) var with the given lower and upper bounds
     std::vector<setvar> newSetVarArray(int n, int min, int max);// Add a number of identical CSP vars
@@ -121,7 +164,8 @@ public:
        called, other wake_advised()
     */
     void    wake_on_lit(Var, cons *c, void *advice = 0L);       // Wake this constraint when the Boolear Var is fixed
-    void    wake_on_dom(cspvar, cons*c, void *advice = 0L);     // Wake this constraint when a value of cspvar is pruned
+    void    wake_on_dom(cspvar, cons*c, void *advice = 0L);     // Wake this constraint when a value of cspvar is pruned. For a lazy cspvar also when its lb, ub
+                                                                // change or it is assigned, which may prune values without an x != d event
     void    wake_on_lb(cspvar, cons*c, void *advice = 0L);      // Wake this constraint when the lb of cspvar is changed
     void    wake_on_ub(cspvar, cons*c, void *advice = 0L);      // Wake this constraint when the ub of cspvar is changed
     void    wake_on_fix(cspvar, cons*c, void *advice = 0L);     // Wake this constraint when the cspvar is assigned
@@ -135,9 +179,17 @@ public:
     btptr   alloc_backtrackable(unsigned size);                 // allocate memory to be automatically restored to its previous contents on backtracking
     void*   get(btptr p);                                       // get direct pointer to  backtrackable mem. for temporary use only
     template<typename T>
-    T&      deref(btptr p);                                     // dereference backtrackable mem. for temporary use only
+    T&      deref(btptr p);                                     // dereference backtrackable mem. for temporary use only. Read-only if trail_backtrackable
+    template<typename T>
+    T*      deref_array(btptr p);                               // dereference an array in backtrackable mem. for temporary use only. Read-only if trail_backtrackable
+    template<typename T>
+    T&      deref_mut(btptr p);                                 // dereference backtrackable mem. for writing. Saves the old contents first
+    template<typename T>
+    T&      deref_array_mut(btptr p, size_t idx);               // dereference element idx of an array in backtrackable mem. for writing
+    template<typename T>
+    void    bt_write(btptr p, T const& v);                      // write v to backtrackable mem.
     template<typename T>
-    T*      deref_array(btptr p);                               // dereference an array in backtrackable mem. for temporary use only
+    void    bt_write_array(btptr p, size_t idx, T const& v);    // write v to element idx of an array in backtrackable mem.
 
     // event information
     domevent event(Lit p) const;                                // get the event associated with a literal, if any
@@ -217,6 +269,8 @@ public:
 
     int      varLevel  (Var x) const; // the level where x was assigned. Assumes (but does not assert) value(x) != l_Undef
     int      varLevel  (Lit l) const; // shortcut for varLevel(var(l))
+    int      varTrailPos(Var x) const; // the position of x in the trail. Assumes (but does not assert) value(x) != l_Undef
+    int      varTrailPos(Lit l) const; // shortcut for varTrailPos(var(l))
 
     // the clause that forced x. This is not const because it may
     // require asking an explainer to generate an explicit clause
@@ -304,12 +358,26 @@ public:
     bool      phase_saving;          // standard phase saving: remember last seen polarity in the trail and use it for decisions
     bool      solution_phase_saving; // solution phase saving (for opt problems): remember polarity in last solution and use that
     bool      allow_clause_dbg;   // set to 0 when the solver is cloned to avoid infinite recursion
+    bool      trail_backtrackable; // if true, backtrackable mem. is restored from a trail of the words written through
+                                   // deref_mut/bt_write, otherwise it is snapshot at every decision level. Change at level 0 only.
+                                   // Writes through deref/deref_array are then lost on backtracking, which INVARIANTS asserts against
+    int       lazy_threshold;     // newCSPVar() encodes domains with more values than this lazily. -1 to never do so        (default -1)
+    double    garbage_frac;       // The fraction of wasted memory allowed before the clause region is compacted.             (default 0.20)
 
     bool      interrupt_requested{false}; // true if a callback asked us to stop
     int64_t   conflict_lim{-1};           // stop after this many conflicts
 
     BranchHeuristic varbranch;
     ValBranchHeuristic valbranch;
+    LearntPolicy learnt_policy;
+    RestartPolicy restart_policy;
+    int       lbd_queue_size;     // With RESTART_GLUCOSE, the number of recent LBDs that are averaged                         (default 50)
+    double    restart_K;          // With RESTART_GLUCOSE, restart if K * recent average LBD > global average LBD             (default 0.8)
+    int       trail_queue_size;   // With RESTART_GLUCOSE, the number of recent trail sizes that are averaged                  (default 5000)
+    double    restart_R;          // With RESTART_GLUCOSE, block restarts if the trail is longer than R * recent average       (default 1.4)
+    int       blocking_first;     // With RESTART_GLUCOSE, the number of conflicts before restarts can be blocked              (default 10000)
+    int       core_lbd;           // With LEARNTS_LBD, learnt clauses with an LBD up to this are kept forever                 (default 2)
+    int       tier2_lbd;          // With LEARNTS_LBD, learnt clauses with an LBD up to this are kept while they are used     (default 6)
 
     enum { polarity_true = 0, polarity_false = 1, polarity_user = 2, polarity_rnd = 3 };
 
@@ -330,6 +398,8 @@ public:
     bool     enqueue          (Lit p, Clause* from = nullptr);                         // Test if fact 'p' contradicts current state, enqueue otherwise.
     bool     enqueueDeferred  (Lit p, explainer* from = nullptr);                      // As above, but with a deferred explanation
     Clause*  enqueueFill      (Lit p, vec<Lit>& ps);                                   // Create an inactive clause that includes p and ps and force p
+    template<class V>
+    Clause*  allocClause      (V&& ps, bool learnt = false, Lit effect = lit_Undef);   // A clause in the region of this solver, to be given to addInactiveClause()
 
     // A somewhat brittle interface: a non-monotone propagator can
     // discover during pruning that it can in fact backprune a literal
@@ -364,6 +434,9 @@ public:
     Var cspvareqiunsafe(cspvar x, int d); // get the propositional var representing x = d, for the brave
     Var cspvarleqi(cspvar x, int d);      // get the propositional var representing x <= d
     Var cspvarleqiunsafe(cspvar x, int d);// get the propositional var representing x <= d, for the brave
+    bool cspvarlazy(cspvar x);            // true if the encoding of x is created on demand
+    bool cspvarlazyindomain(cspvar x, int d); // indomain() for a lazy x, without creating literals
+    Lit cspvarlazyreason(cspvar x, domevent::event_type t, int d); // a false literal that implies the event (x t d), for a lazy x
     int setvarumin(setvar x) const;       // get the smallest element in the universe of x
     int setvarumax(setvar x) const;       // get the smallest element in the universe of x
     Var setvarini(setvar x, int d);       // get the propositional var representing d in x
@@ -396,16 +469,25 @@ protected:
     vec<double>         activity;         // A heuristic measurement of the activity of a variable.
     double              var_inc;          // Amount to bump next variable with.
 
+    ClauseAllocator     ca;               // The region all clauses of the solver (except those created by Clause_new()) live in.
+
     struct watch {
-      Clause *c{nullptr};
+      CRef cr{CRef_Undef};
       Lit block{lit_Undef};
 
-      bool operator==(const watch &w) const { return c == w.c; }
-      bool operator!=(const watch &w) const { return c != w.c; }
+      bool operator==(const watch &w) const { return cr == w.cr; }
+      bool operator!=(const watch &w) const { return cr != w.cr; }
     };
 
     vec<vec<watch>>     watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
     vec<vec<watch>>     binwatches;       // same, for binary clauses
+    vec<char>           dirty;            // 'dirty[lit]' is set if 'watches[lit]' or 'binwatches[lit]' may contain deleted clauses.
+    vec<Lit>            dirties;          // The literals whose 'dirty' flag is set.
+    vec<uint64_t>       lbd_stamp;        // 'lbd_stamp[level]' is lbd_counter if computeLBD() has seen the level.
+    uint64_t            lbd_counter{0};
+    bqueue<unsigned>    lbd_queue;        // The LBDs of the most recent learnt clauses, for RESTART_GLUCOSE.
+    bqueue<unsigned>    trail_queue;      // The trail sizes at the most recent conflicts, for RESTART_GLUCOSE.
+    uint64_t            sum_lbd{0};       // The sum of the LBDs of all learnt clauses.
     vec<vec<wake_stub>> wakes_on_lit;     // 'wakes_on_lit[var(lit)]' is a list of csp constraints that wake when var is set
     vec<vec<int>>       sched_on_lit;     // 'wakes_on_lit[var(lit)]' is a list of csp constraints that wake when var is set
 
@@ -416,12 +498,17 @@ protected:
     vec<int>            trail_lim;        // Separator indices for different decision levels in 'trail'.
     vec<explanation_ptr> reason;          // 'reason[var]' is the clause that implied the variables current value, or 'NULL' if none.
     vec<int>            level;            // 'level[var]' contains the level at which the assignment was made.
+    vec<int>            trailpos;         // 'trailpos[var]' is the position of the assignment in the trail, so deferred explanations can tell what was true before a literal.
     vec<lbool>          phase;            // backjumped over as this polarity
     int                 qhead;            // Head of queue (as index into the trail -- no more explicit propagation queue in MiniSat).
     int                 simpDB_assigns;   // Number of top-level assignments since last execution of 'simplify()'.
     int64_t             simpDB_props;     // Remaining number of propagations that must be made before next execution of 'simplify()'.
     vec<Lit>            assumptions;      // Current set of assumptions provided to solve by the user.
     Heap<VarOrderLt>    order_heap;       // A priority queue of variables ordered with respect to the variable activity.
+    Heap<DomLt>         dom_heap;         // The cspvars ordered by domain size, for VAR_DOM. Fixed cspvars are removed lazily.
+    int                 lex_next{0};      // For VAR_LEX: every cspvar before this one is fixed.
+    Heap<DomWdegLt>     domwdeg_heap;     // The cspvars ordered by dom/wdeg, for VAR_DOMWDEG. Fixed cspvars are removed lazily.
+    uint64_t            wdeg_counter{0};  // Stamps the clause conflicts counted in cspvar_fixed::wdeg.
     double              random_seed;      // Used by the random variable selection.
     double              progress_estimate;// Set by 'search()'.
     bool                remove_satisfied; // Indicates whether possibly inefficient linear scan for satisfied clauses should be performed in 'simplify'.
@@ -435,6 +522,48 @@ protected:
     size_t              backtrackable_cap;   // How much backtrackable memory is allocated
     vec<void*>          backtrackable_space; // per-level copies of backtrackable data
     void*               current_space;       // All backtrackable data are pointers into this
+    struct bt_undo {
+      unsigned offset;                       // word offset into current_space
+      unsigned old;                          // contents of that word before the write
+    };
+    vec<bt_undo>        bt_trail;            // old contents of backtrackable words written, in trail mode
+    vec<int>            bt_trail_lim;        // Separator indices for different decision levels in 'bt_trail'
+    vec<unsigned>       bt_stamp;            // per word of backtrackable mem., the epoch in which it was last saved
+    unsigned            bt_epoch;            // incremented whenever we enter a new level
+    struct lazy_undo {
+      int trailpos;                          // trail size when the bounds were changed
+      int x;                                 // the cspvar
+      int min, max;                          // the bounds before the change
+      Lit minlit, maxlit;
+    };
+    vec<lazy_undo>      lazy_undos;          // old bounds of lazy cspvars, restored on backtracking
+    struct lazy_recent {
+      Var v;                                 // a literal of a lazy cspvar
+      int level;                             // the lowest level since which its clauses may not have propagated
+    };
+    vec<lazy_recent>    lazy_recents;        // literals created above level 0, rechecked on backtracking
+    vec<int>            lazy_fixed;          // lazy cspvars that became fixed without an x = d literal. propagate() creates it
+
+    /* The reasons for the literals that uncheckedEnqueue_common() sets
+       to keep the encoding of an eager cspvar consistent. Each stands
+       for one family of the clauses of the encoding (see newCSPVar())
+       and rebuilds the clause from the event of the literal.
+    */
+    enum encoding_clause {
+      ENC_LEQ_CHAIN, // (x <= d-1) => (x <= d)
+      ENC_EQ_LEQ,    // (x = d) => (x <= d)
+      ENC_EQ_GEQ,    // (x = d) => -(x <= d-1)
+      ENC_LEQ_EQ,    // (x <= d) /\ -(x <= d-1) => (x = d)
+      ENC_NUM
+    };
+    struct encoding_explainer : public explainer {
+      encoding_clause kind;
+      void explain(Solver& s, Lit p, vec<Lit>& c) { s.explain_encoding(kind, p, c); }
+      void use() {}
+      void release() {}
+      std::ostream& print(std::ostream& os) { return os << "domain encoding"; }
+    };
+    encoding_explainer  encoding_expl[ENC_NUM];
 
     cons*               active_constraint;   // the constraint currently propagating.
 
@@ -454,6 +583,7 @@ protected:
     vec<Lit>            analyze_stack;
     vec<Lit>            analyze_toclear;
     vec<Lit>            analyze_explbuffer;
+    vec<Lit>            redundant_explbuffer;
     vec<Lit>            add_tmp;
 
     std::vector<char> reduce_var_seen;
@@ -471,14 +601,49 @@ protected:
     Lit      pickBranchLitVSIDS(int polarity_mode, double random_var_freq);            // ...using VSIDS
     Lit      pickBranchLitLex  ();                                                     // ...Lex order of the CSP vars
     Lit      pickBranchLitDom  ();                                                     // ...mindom among csp vars
+    Lit      pickBranchLitDomWdeg();                                                   // ...min dom/wdeg among csp vars
+    Lit      pickBranchLitMedian(cspvar x);                                            // x = the median of its domain
+    Lit      pickBranchLitActive(cspvar x);                                            // the most active literal of the encoding of x
+    bool     branchSign       (Var next, int polarity_mode);                           // The polarity of a decision on next
+    void     branchInit       ();                                                      // Set up the structures of the var heuristic before search
+    void     branchUpdate     (int x);                                                 // The domain or weighted degree of cspvar x changed
+    void     wdegRegister     (cspvar x, cons *c);                                     // Count c in the weighted degree of x
+    void     wdegBump         (cons *c);                                               // c failed: bump its weight
+    void     wdegBump         (Clause& c);                                             // c failed: bump the weighted degree of its cspvars
     Lit      pickBranchLitFrom (cspvar x);                                             // Branch within a chosen variable
     void     analyze          (Clause* confl, vec<Lit>& out_learnt, int& out_btlevel); // (bt = backtrack)
     void     analyzeFinal     (Lit p, vec<Lit>& out_conflict);                         // COULD THIS BE IMPLEMENTED BY THE ORDINARIY "analyze" BY SOME REASONABLE GENERALIZATION?
+    Var      lazy_leqi        (cspvar x, int d);                                       // Get or create the literal x <= d of a lazy cspvar
+    Var      lazy_eqi         (cspvar x, int d);                                       // Get or create the literal x = d of a lazy cspvar
+    void     lazy_attach      (lazy_domain& ld, vec<Lit>& ps);                         // Add a clause to the encoding of a lazy cspvar
+    void     lazy_materialized(Var v);                                                 // Enqueue a new literal if it is entailed by the current bounds
+    Lit      lazy_entailed    (Var v, vec<Lit>& ps);                                   // The literal of v implied by the current bounds (lit_Undef if none), with its reason
+    void     lazy_enqueue     (Lit p, vec<Lit>& ps);                                   // Enqueue p, with reason ps unless at level 0
+    void     lazy_update      (cspvar_fixed& xf, Lit p, domevent const& pevent);       // Update the bounds of a lazy cspvar after p is enqueued
+    void     lazy_recheck     (int level);                                             // Restore literals that are entailed after backtracking to level
+    Lit      pickBranchLitLazy();                                                      // A decision on a lazy cspvar that is not fixed yet
+    void     bt_save          (size_t offset, size_t size);                            // Save the words covering [offset, offset+size) to bt_trail, if needed
+    void     bt_new_epoch     ();                                                      // Invalidate all bt_stamp entries
     bool     litRedundant     (Lit p, uint32_t abstract_levels);                       // (helper method for 'analyze()')
+    void     explain_encoding (encoding_clause k, Lit p, vec<Lit>& c);                 // The clause of family k that forces p, p first
+    bool     encoding_reason  (Var x) const;                                           // true if the reason of x is one of encoding_expl
+    explainer* enc_expl       (encoding_clause k);                                     // encoding_expl[k], as the reason of a literal
     lbool    search           (int nof_conflicts, double * nof_learnts);               // Search for a given number of conflicts.
+    bool     glucoseRestarts  () const;                                                // true if restart_policy is RESTART_GLUCOSE and it can be followed
+    bool     restartNow       (int conflictC, int nof_conflicts) const;                // true if search() should restart according to restart_policy
     void     reduceDB         ();                                                      // Reduce the set of learnt clauses.
+    void     reduceDBActivity ();                                                      // reduceDB() with LEARNTS_ACTIVITY
+    void     reduceDBTiered   ();                                                      // reduceDB() with LEARNTS_LBD
+    template<class C>
+    int      computeLBD       (const C& c);                                            // The number of distinct decision levels in c
+    void     updateLBD        (Clause& c);                                             // Mark a learnt clause used and promote it if its LBD dropped
+    int      lbdTier          (int lbd) const;                                         // The tier of a learnt clause with this LBD
     void     gcInactive       ();                                                      // Collect inactive and unlocked clauses
     void     removeSatisfied  (vec<Clause*>& cs);                                      // Shrink 'cs' to contain only non-satisfied clauses.
+    void     checkGarbage     ();                                                      // Compact the clause region if enough of it is wasted. At level 0 or between propagations only
+    void     garbageCollect   ();                                                      // Move all live clauses to a fresh region
+    void     relocAll         (ClauseAllocator& to);                                   // Copy all live clauses to 'to', updating the references to them
+    void     reloc            (Clause*& c, ClauseAllocator& to);                       // Update c, if it is in the region, to its copy in 'to'
     void     uncheckedEnqueue_common(Lit p, explanation_ptr from);                     // common stuff done by both uE(Lit, Clause*) and uE(Lit, explainer*)
     void     uncheckedEnqueue_np(Lit p, explanation_ptr from);                         // uncheckedEnqueue with no CSP propagation
     Clause*  propagate_inner  ();                                                      // Perform unit propagation, wake propagators,
@@ -506,8 +671,12 @@ protected:
     // Operations on clauses:
     //
     void     attachClause     (Clause& c);             // Attach a clause to watcher lists.
-    void     detachClause     (Clause& c);             // Detach a clause to watcher lists.
+    void     detachClause     (Clause& c, bool strict = false); // Detach a clause from watcher lists. Unless strict, only mark the lists dirty (the clause must then be marked deleted).
     void     removeClause     (Clause& c);             // Detach and free a clause.
+    void     smudgeWatches    (Lit p);                 // Note that watches[p] and binwatches[p] may hold deleted clauses.
+    void     cleanWatches     (Lit p);                 // Purge deleted clauses from watches[p] and binwatches[p].
+    void     cleanAllWatches  ();                      // Purge all dirty watch lists.
+    void     freeClause       (Clause& c);             // Free a clause that is not attached.
     bool     locked           (const Clause& c) const; // Returns TRUE if a clause is a reason for some implication in the current state.
     bool     satisfied        (const Clause& c) const; // Returns TRUE if a clause is satisfied in the current state.
 
@@ -570,6 +739,62 @@ T* Solver::deref_array(btptr p)
   return (T*)get(p);
 }
 
+inline
+void Solver::bt_new_epoch()
+{
+  if( ++bt_epoch == 0 ) {
+    for(int i = 0; i != bt_stamp.size(); ++i)
+      bt_stamp[i] = 0;
+    bt_epoch = 1;
+  }
+}
+
+inline
+void Solver::bt_save(size_t offset, size_t size)
+{
+  if( !trail_backtrackable || !decisionLevel() ) return;
+  size_t w = offset/sizeof(unsigned), wend = (offset+size-1)/sizeof(unsigned);
+  for(; w <= wend; ++w) {
+    if( bt_stamp[w] == bt_epoch ) continue;
+    bt_stamp[w] = bt_epoch;
+    bt_undo u;
+    u.offset = w;
+    std::memcpy(&u.old, ((char*)current_space)+w*sizeof(unsigned),
+                sizeof(unsigned));
+    bt_trail.push(u);
+  }
+}
+
+template <typename T>
+inline
+T& Solver::deref_mut(btptr p)
+{
+  bt_save(p.offset, sizeof(T));
+  return *(T*)get(p);
+}
+
+template <typename T>
+inline
+T& Solver::deref_array_mut(btptr p, size_t idx)
+{
+  bt_save(p.offset+idx*sizeof(T), sizeof(T));
+  return ((T*)get(p))[idx];
+}
+
+template <typename T>
+inline
+void Solver::bt_write(btptr p, T const& v)
+{
+  deref_mut<T>(p) = v;
+}
+
+template <typename T>
+inline
+void Solver::bt_write_array(btptr p, size_t idx, T const& v)
+{
+  deref_array_mut<T>(p, idx) = v;
+}
+
 inline
 domevent Solver::event(Lit p) const
 {
@@ -607,6 +832,28 @@ inline void Solver::claBumpActivity (Clause& c) {
                 learnts[i]->activity() *= 1e-20;
             cla_inc *= 1e-20; } }
 
+template<class C>
+inline int Solver::computeLBD(const C& c) {
+    ++lbd_counter;
+    int lbd = 0;
+    for (Lit q : c) {
+        // the asserting literal of a new learnt clause is unassigned,
+        // but still has its level from the conflict
+        int l = level[var(q)];
+        if (l < 0) continue;
+        if (l >= lbd_stamp.size()) lbd_stamp.growTo(l+1, 0);
+        if (lbd_stamp[l] != lbd_counter) {
+            lbd_stamp[l] = lbd_counter;
+            ++lbd;
+        }
+    }
+    return lbd; }
+
+inline int Solver::lbdTier(int lbd) const {
+    if (lbd <= core_lbd) return Clause::CORE;
+    if (lbd <= tier2_lbd) return Clause::TIER2;
+    return Clause::LOCAL; }
+
 inline Heap<Solver::VarOrderLt>& Solver::vsids_heap() { return order_heap; }
 
 inline double Solver::var_activity(Var x) { return activity[x]; }
@@ -625,6 +872,21 @@ inline bool Solver::enqueueDeferred(Lit p, explainer* from)
     return true;
 }
 
+inline bool Solver::encoding_reason(Var x) const {
+    auto r = reason[x];
+    if (!r.has<explainer>())
+        return false;
+    explainer *e = r.get<explainer>();
+    for (int k = 0; k != ENC_NUM; ++k)
+        if (e == &encoding_expl[k])
+            return true;
+    return false;
+}
+
+inline explainer *Solver::enc_expl(encoding_clause k) {
+    return &encoding_expl[k];
+}
+
 inline bool Solver::locked(const Clause &c) const {
     auto c0r = reason[var(c[0])];
     if (!c0r.has<Clause>())
@@ -635,6 +897,14 @@ inline bool Solver::locked(const Clause &c) const {
 
 inline void     Solver::newDecisionLevel()  {
   trail_lim.push(trail.size());
+  if( trail_backtrackable ) {
+    bt_trail_lim.push(bt_trail.size());
+    bt_new_epoch();
+#ifndef INVARIANTS
+    return;
+#endif
+    // also snapshot, so that cancelUntil() can check the trail
+  }
   int dlvl = decisionLevel();
   while( backtrackable_space.size() < decisionLevel() )
     backtrackable_space.push(0L);
@@ -662,6 +932,8 @@ inline Lit      Solver::decisionAtLevel(int lvl) const
 
 inline int Solver::varLevel(Var x) const { return level[x]; }
 inline int Solver::varLevel(Lit l) const { return level[var(l)]; }
+inline int Solver::varTrailPos(Var x) const { return trailpos[x]; }
+inline int Solver::varTrailPos(Lit l) const { return trailpos[var(l)]; }
 
 inline Clause *Solver::varReason(Var x) { return explicit_reason(Lit(x)); }
 inline Clause *Solver::varReason(Lit l) { return explicit_reason(l); }
@@ -695,11 +967,16 @@ template <typename veclit>
 inline Clause *Solver::addInactiveClause(veclit &&ps) {
   for (Lit l : ps)
     assert(var(l) != var_Undef);
-  Clause *r = Clause_new(ps);
+  Clause *r = allocClause(ps);
   addInactiveClause(r);
   return r;
 }
 
+template<class V>
+inline Clause *Solver::allocClause(V&& ps, bool learnt, Lit effect) {
+  return ca.lea(ca.alloc(ps, learnt, effect));
+}
+
 template <typename veclit> void Solver::addClause(veclit &&v)
 {
     add_tmp.clear();
@@ -900,22 +1177,43 @@ inline int Solver::cspvaromax(cspvar x)
 
 inline Var Solver::cspvareqi(cspvar x, int d)
 {
-  return cspvars[x._id].eqi(d);
+  cspvar_fixed& xf = cspvars[x._id];
+  if( xf.lazy ) return lazy_eqi(x, d);
+  return xf.eqi(d);
 }
 
 inline Var Solver::cspvareqiunsafe(cspvar x, int d)
 {
-  return cspvars[x._id].eqiUnsafe(d);
+  cspvar_fixed& xf = cspvars[x._id];
+  if( xf.lazy ) return lazy_eqi(x, d);
+  return xf.eqiUnsafe(d);
 }
 
 inline Var Solver::cspvarleqi(cspvar x, int d)
 {
-  return cspvars[x._id].leqi(d);
+  cspvar_fixed& xf = cspvars[x._id];
+  if( xf.lazy ) return lazy_leqi(x, d);
+  return xf.leqi(d);
 }
 
 inline Var Solver::cspvarleqiunsafe(cspvar x, int d)
 {
-  return cspvars[x._id].leqiUnsafe(d);
+  cspvar_fixed& xf = cspvars[x._id];
+  if( xf.lazy ) return lazy_leqi(x, d);
+  return xf.leqiUnsafe(d);
+}
+
+inline bool Solver::cspvarlazy(cspvar x)
+{
+  return cspvars[x._id].lazy;
+}
+
+inline bool Solver::cspvarlazyindomain(cspvar x, int d)
+{
+  cspvar_fixed& xf = cspvars[x._id];
+  if( d < xf.min || d > xf.max ) return false;
+  Var xd = xf.lazy->findeq(d);
+  return xd == var_Undef || value(xd) != l_False;
 }
 
 inline Var Solver::setvarumin(setvar x) const
@@ -940,12 +1238,14 @@ inline cspvar Solver::setvarcard(setvar x)
 
 inline bool cspvar::indomain(Solver &s, int d) const
 {
+  if( s.cspvarlazy(*this) ) return s.cspvarlazyindomain(*this, d);
   Var xd = eqi(s, d);
   return xd != var_Undef && s.value( xd ) != l_False;
 }
 
 inline bool cspvar::indomainUnsafe(Solver &s, int d) const
 {
+  if( s.cspvarlazy(*this) ) return s.cspvarlazyindomain(*this, d);
   Var xd = eqiUnsafe(s, d);
   return s.value( xd ) != l_False;
 }
@@ -997,21 +1297,29 @@ inline Var cspvar::leqiUnsafe(Solver &s, int d) const
 
 inline Lit cspvar::r_geq(Solver &s, int d) const
 {
+  if( s.cspvarlazy(*this) )
+    return s.cspvarlazyreason(*this, domevent::GEQ, d);
   return Lit( leqi(s, d-1) );
 }
 
 inline Lit cspvar::r_leq(Solver &s, int d) const
 {
+  if( s.cspvarlazy(*this) )
+    return s.cspvarlazyreason(*this, domevent::LEQ, d);
   return ~Lit( leqi(s, d) );
 }
 
 inline Lit cspvar::r_eq(Solver &s, int d) const
 {
+  if( s.cspvarlazy(*this) )
+    return s.cspvarlazyreason(*this, domevent::EQ, d);
   return ~Lit( eqi(s, d) );
 }
 
 inline Lit cspvar::r_eq(Solver &s) const
 {
+  if( s.cspvarlazy(*this) )
+    return s.cspvarlazyreason(*this, domevent::EQ, min(s));
   Lit l = ~Lit( eqi(s, min(s)));
   assert( s.value(l) == l_False );
   return l;
@@ -1019,6 +1327,8 @@ inline Lit cspvar::r_eq(Solver &s) const
 
 inline Lit cspvar::r_neq(Solver &s, int d) const
 {
+  if( s.cspvarlazy(*this) )
+    return s.cspvarlazyreason(*this, domevent::NEQ, d);
   return Lit( eqi(s, d) );
 }
 
@@ -1054,6 +1364,7 @@ inline Lit cspvar::e_neq(Solver &s, int d) const
 
 inline Clause *cspvar::remove(Solver &s, int d, Clause *c)
 {
+  if( d < min(s) || d > max(s) ) return 0L;
   Var xd = eqi(s, d);
   if( xd == var_Undef ) return 0L;
   if( s.value(xd) == l_False ) return 0L;
@@ -1065,10 +1376,11 @@ inline Clause *cspvar::remove(Solver &s, int d, Clause *c)
 template<typename V>
 inline Clause *cspvar::remove(Solver &s, int d, V& ps)
 {
+  if( d < min(s) || d > max(s) ) return 0L;
   Var xd = eqi(s, d);
   if( xd == var_Undef ) return 0L;
   if( s.value(xd) == l_False ) return 0L;
-  Clause *r = Clause_new(ps, false, ~Lit(xd));
+  Clause *r = s.allocClause(ps, false, ~Lit(xd));
   s.addInactiveClause(r);
   if( s.value(xd) == l_True ) return r;
   s.uncheckedEnqueue( ~Lit(xd), r);
@@ -1078,11 +1390,12 @@ inline Clause *cspvar::remove(Solver &s, int d, V& ps)
 template<typename V>
 inline Clause *cspvar::removef(Solver &s, int d, V& ps)
 {
+  if( d < min(s) || d > max(s) ) return 0L;
   Var xd = eqi(s, d);
   if( xd == var_Undef ) return 0L;
   if( s.value(xd) == l_False ) return 0L;
   ps.push( ~Lit(xd) );
-  Clause *r = Clause_new(ps, false, ~Lit(xd));
+  Clause *r = s.allocClause(ps, false, ~Lit(xd));
   ps.pop();
   s.addInactiveClause(r);
   if( s.value(xd) == l_True ) return r;
@@ -1092,6 +1405,7 @@ inline Clause *cspvar::removef(Solver &s, int d, V& ps)
 
 inline Clause *cspvar::setmin(Solver &s, int d, Clause *c)
 {
+  if( d <= min(s) ) return 0L;
   Var xd = leqi(s, d-1);
   if( xd == var_Undef ) {
     if( d <= max(s) ) return 0L;
@@ -1106,15 +1420,16 @@ inline Clause *cspvar::setmin(Solver &s, int d, Clause *c)
 template<typename V>
 inline Clause *cspvar::setmin(Solver &s, int d, V& ps)
 {
+  if( d <= min(s) ) return 0L;
   Var xd = leqi(s, d-1);
   if( xd == var_Undef ) {
     if( d <= max(s) ) return 0L;
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_False ) return 0L;
-  Clause *r = Clause_new(ps, false, ~Lit(xd) );
+  Clause *r = s.allocClause(ps, false, ~Lit(xd) );
   s.addInactiveClause(r);
   if( s.value(xd) == l_True ) return r;
   s.uncheckedEnqueue( ~Lit(xd), r);
@@ -1124,16 +1439,17 @@ inline Clause *cspvar::setmin(Solver &s, int d, V& ps)
 template<typename V>
 inline Clause *cspvar::setminf(Solver &s, int d, V& ps)
 {
+  if( d <= min(s) ) return 0L;
   Var xd = leqi(s, d-1);
   if( xd == var_Undef ) {
     if( d <= max(s) ) return 0L;
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_False ) return 0L;
   ps.push( ~Lit(xd) );
-  Clause *r = Clause_new(ps, false, ~Lit(xd) );
+  Clause *r = s.allocClause(ps, false, ~Lit(xd) );
   ps.pop();
   s.addInactiveClause(r);
   if( s.value(xd) == l_True ) return r;
@@ -1143,6 +1459,7 @@ inline Clause *cspvar::setminf(Solver &s, int d, V& ps)
 
 inline Clause *cspvar::setmax(Solver &s, int d, Clause *c)
 {
+  if( d >= max(s) ) return 0L;
   Var xd = leqi(s, d);
   if( xd == var_Undef ) {
     if( d >= min(s) ) return 0L;
@@ -1157,15 +1474,16 @@ inline Clause *cspvar::setmax(Solver &s, int d, Clause *c)
 template<typename V>
 inline Clause *cspvar::setmax(Solver &s, int d, V& ps)
 {
+  if( d >= max(s) ) return 0L;
   Var xd = leqi(s, d);
   if( xd == var_Undef ) {
     if( d >= min(s) ) return 0L;
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_True ) return 0L;
-  Clause *r = Clause_new(ps, false, Lit(xd) );
+  Clause *r = s.allocClause(ps, false, Lit(xd) );
   s.addInactiveClause(r);
   if( s.value(xd) == l_False ) return r;
   s.uncheckedEnqueue( Lit(xd), r);
@@ -1175,16 +1493,17 @@ inline Clause *cspvar::setmax(Solver &s, int d, V& ps)
 template<typename V>
 inline Clause *cspvar::setmaxf(Solver &s, int d, V& ps)
 {
+  if( d >= max(s) ) return 0L;
   Var xd = leqi(s, d);
   if( xd == var_Undef ) {
     if( d >= min(s) ) return 0L;
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_True ) return 0L;
   ps.push( Lit(xd) );
-  Clause *r = Clause_new(ps, false, Lit(xd) );
+  Clause *r = s.allocClause(ps, false, Lit(xd) );
   ps.pop();
   s.addInactiveClause(r);
   if( s.value(xd) == l_False ) return r;
@@ -1208,12 +1527,12 @@ inline Clause *cspvar::assign(Solver &s, int d, V& ps)
 {
   Var xd = eqi(s, d);
   if( xd == var_Undef ) {
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_True ) return 0L;
-  Clause *r = Clause_new(ps, false, Lit(xd) );
+  Clause *r = s.allocClause(ps, false, Lit(xd) );
   s.addInactiveClause(r);
   if( s.value(xd) == l_False ) return r;
   s.uncheckedEnqueue( Lit(xd), r );
@@ -1225,13 +1544,13 @@ inline Clause *cspvar::assignf(Solver &s, int d, V& ps)
 {
   Var xd = eqi(s, d);
   if( xd == var_Undef ) {
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_True ) return 0L;
   ps.push( Lit(xd) );
-  Clause *r = Clause_new(ps, false, Lit(xd) );
+  Clause *r = s.allocClause(ps, false, Lit(xd) );
   ps.pop();
   s.addInactiveClause(r);
   if( s.value(xd) == l_False ) return r;
@@ -1298,7 +1617,7 @@ inline Clause *setvar::exclude(Solver &s, int d, vec<Lit>& ps)
   Var xd = ini(s, d);
   if( xd == var_Undef ) return 0L;
   if( s.value(xd) == l_False ) return 0L;
-  Clause *r = Clause_new(ps, false, ~Lit(xd) );
+  Clause *r = s.allocClause(ps, false, ~Lit(xd) );
   s.addInactiveClause(r);
   if( s.value(xd) == l_True ) return r;
   s.uncheckedEnqueue( ~Lit(xd), r );
@@ -1311,7 +1630,7 @@ inline Clause *setvar::excludef(Solver &s, int d, vec<Lit>& ps)
   if( xd == var_Undef ) return 0L;
   if( s.value(xd) == l_False ) return 0L;
   ps.push( ~Lit(xd) );
-  Clause *r = Clause_new(ps, false, ~Lit(xd) );
+  Clause *r = s.allocClause(ps, false, ~Lit(xd) );
   ps.pop();
   s.addInactiveClause(r);
   if( s.value(xd) == l_True ) return r;
@@ -1334,12 +1653,12 @@ inline Clause *setvar::include(Solver &s, int d, vec<Lit>& ps)
 {
   Var xd = ini(s, d);
   if( xd == var_Undef ) {
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_True ) return 0L;
-  Clause *r = Clause_new(ps, false, Lit(xd) );
+  Clause *r = s.allocClause(ps, false, Lit(xd) );
   s.addInactiveClause(r);
   if( s.value(xd) == l_False ) return r;
   s.uncheckedEnqueue( Lit(xd), r );
@@ -1350,13 +1669,13 @@ inline Clause *setvar::includef(Solver &s, int d, vec<Lit>& ps)
 {
   Var xd = ini(s, d);
   if( xd == var_Undef ) {
-    Clause *r = Clause_new(ps);
+    Clause *r = s.allocClause(ps);
     s.addInactiveClause(r);
     return r;
   }
   if( s.value(xd) == l_True ) return 0L;
   ps.push( Lit(xd) );
-  Clause *r = Clause_new(ps, false, Lit(xd) );
+  Clause *r = s.allocClause(ps, false, Lit(xd) );
   ps.pop();
   s.addInactiveClause(r);
   if( s.value(xd) == l_False ) return r;
@@ -1413,9 +1732,9 @@ template <typename T> struct backtrackable {
     new (&st) T(t);
   }
 
-  T &operator*() { return s.deref<T>(p); }
+  T &operator*() { return s.deref_mut<T>(p); }
   const T &operator*() const { return s.deref<T>(p); }
-  T *operator->() { return &s.deref<T>(p); }
+  T *operator->() { return &s.deref_mut<T>(p); }
   const T *operator->() const { return &s.deref<T>(p); }
 };
 
@@ -46,6 +46,9 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include <iostream>
 #include <algorithm>
 #include <memory>
+#include <map>
+#include <new>
+#include <cstring>
 
 #include "minicsp/mtl/Alg.h"
 #include "minicsp/mtl/Vec.h"
@@ -278,11 +281,19 @@ Clause* Clause_new(V&& ps, bool learnt = false,
                    Lit effect = lit_Undef);
 
 class Clause {
-    uint32_t size_etc;
+    friend class ClauseAllocator;
+
+    uint32_t size_etc;  // size << 5 | reloced << 4 | arena << 3 | mark << 1 | learnt
     union { float act; uint32_t abst; } extra;
-    Lit     data[0];
+    Lit     data[0];    // for learnt clauses, followed by one more word: lbd << 3 | tier << 1 | used
+
+    uint32_t&    lbd_etc     ()              { assert(learnt()); return reinterpret_cast<uint32_t&>(data[size()]); }
+    uint32_t     lbd_etc     ()      const   { assert(learnt()); return reinterpret_cast<const uint32_t&>(data[size()]); }
 
 public:
+    // the tiers of the learnt clause database, see Solver::reduceDB()
+    enum { CORE = 0, TIER2 = 1, LOCAL = 2 };
+
     void calcAbstraction() {
         uint32_t abstraction = 0;
         for (int i = 0; i < size(); i++)
@@ -292,29 +303,33 @@ public:
     // NOTE: This constructor cannot be used directly (doesn't allocate enough memory).
     template<class V>
     Clause(V&& ps, bool learnt, Lit effect) {
-        size_etc = (ps.size() << 3) | (uint32_t)learnt;
+        size_etc = (ps.size() << 5) | (uint32_t)learnt;
         for (int i = 0; i < ps.size(); i++) {
           assert(var(ps[i]) != var_Undef);
           data[i] = ps[i];
           if( data[i] == effect ) std::swap(data[0], data[i]);
         }
-        if (learnt) extra.act = 0; else calcAbstraction(); }
+        if (learnt) { extra.act = 0; lbd_etc() = LOCAL << 1; } else calcAbstraction(); }
 
     // -- use this function instead:
     template<class V>
     friend Clause* Clause_new(V&& ps, bool learnt, Lit effect) {
         assert(sizeof(Lit)      == sizeof(uint32_t));
         assert(sizeof(float)    == sizeof(uint32_t));
-        void* mem = malloc(sizeof(Clause) + sizeof(uint32_t)*(ps.size()));
+        void* mem = malloc(sizeof(Clause) + sizeof(uint32_t)*(ps.size() + learnt));
         return new (mem) Clause(ps, learnt, effect); }
 
-    int          size        ()      const   { return size_etc >> 3; }
-    void         shrink      (int i)         { assert(i <= size()); size_etc = (((size_etc >> 3) - i) << 3) | (size_etc & 7); }
+    int          size        ()      const   { return size_etc >> 5; }
+    void         shrink      (int i)         { assert(i <= size());
+                                               if (learnt()) data[size()-i] = data[size()]; // move the lbd word
+                                               size_etc = (((size_etc >> 5) - i) << 5) | (size_etc & 31); }
     void         pop         ()              { shrink(1); }
     bool         learnt      ()      const   { return size_etc & 1; }
     uint32_t     mark        ()      const   { return (size_etc >> 1) & 3; }
     void         mark        (uint32_t m)    { size_etc = (size_etc & ~6) | ((m & 3) << 1); }
     const Lit&   last        ()      const   { return data[size()-1]; }
+    bool         arena       ()      const   { return size_etc & 8; }
+    bool         reloced     ()      const   { return size_etc & 16; }
 
     // NOTE: somewhat unsafe to change the clause in-place! Must manually call 'calcAbstraction' afterwards for
     //       subsumption operations to behave correctly.
@@ -323,6 +338,12 @@ public:
     operator const Lit* (void) const         { return data; }
 
     float&       activity    ()              { return extra.act; }
+    uint32_t     lbd         ()      const   { return lbd_etc() >> 3; }
+    void         lbd         (uint32_t l)    { lbd_etc() = (l << 3) | (lbd_etc() & 7); }
+    int          tier        ()      const   { return (lbd_etc() >> 1) & 3; }
+    void         tier        (int t)         { lbd_etc() = (lbd_etc() & ~6u) | ((t & 3) << 1); }
+    bool         used        ()      const   { return lbd_etc() & 1; }
+    void         used        (bool u)        { lbd_etc() = (lbd_etc() & ~1u) | (uint32_t)u; }
     uint32_t     abstraction () const { return extra.abst; }
 
     Lit          subsumes    (const Clause& other) const;
@@ -379,6 +400,127 @@ inline void Clause::strengthen(Lit p)
     calcAbstraction();
 }
 
+/*_________________________________________________________________________________________________
+|
+|  ClauseAllocator : the region the clauses of a Solver live in
+|
+|  Description:
+|       Clauses are carved out of chunks of 32-bit words. Chunks never move, so a Clause* stays
+|       valid until the region is compacted by Solver::garbageCollect(). A CRef is the 32-bit
+|       offset of a clause in the region (chunk number in the high bits), which is what the
+|       watch lists store. free() only counts the words as wasted: compaction copies the live
+|       clauses to a fresh allocator with reloc(), leaving a forwarding reference in the old
+|       copy, and then moveTo() replaces the old region.
+|________________________________________________________________________________________________@*/
+typedef uint32_t CRef;
+const CRef CRef_Undef = UINT32_MAX;
+
+class ClauseAllocator {
+    enum { chunk_bits = 20, chunk_words = 1 << chunk_bits, max_chunks = 1 << (32 - chunk_bits) };
+
+    vec<uint32_t*> chunks;  // a null entry is covered by the oversized chunk before it
+    uint32_t       top;     // first free word of the last chunk
+    uint64_t       used;    // words handed out
+    uint64_t       waste;   // words of freed clauses
+
+    // rounded up to 8 bytes, since explanation_ptr stores its tag in
+    // the low bits of the Clause*
+    static uint32_t clauseWords(int size, bool learnt) {
+        return ((sizeof(Clause) + sizeof(Lit)*(size + learnt)) / sizeof(uint32_t) + 1) & ~1u; }
+
+    CRef reserve(uint32_t words) {
+        used += words;
+        if (chunks.size() > 0 && top + words <= chunk_words) {
+            CRef r = ((chunks.size() - 1) << chunk_bits) | top;
+            top += words;
+            return r;
+        }
+        // clauses longer than a chunk get a run of chunk numbers to
+        // themselves and nothing is allocated after them
+        int n = (words + chunk_words - 1) >> chunk_bits;
+        if (chunks.size() + n > max_chunks)
+            throw std::bad_alloc();
+        uint32_t* mem = (uint32_t*)malloc(sizeof(uint32_t) * ((size_t)n << chunk_bits));
+        if (!mem)
+            throw std::bad_alloc();
+        CRef r = chunks.size() << chunk_bits;
+        chunks.push(mem);
+        for (int i = 1; i < n; i++)
+            chunks.push(0L);
+        top = n == 1 ? words : chunk_words;
+        return r;
+    }
+
+public:
+    ClauseAllocator() : top(0), used(0), waste(0) {}
+    ~ClauseAllocator() { clear(); }
+
+    template<class V>
+    CRef alloc(V&& ps, bool learnt = false, Lit effect = lit_Undef) {
+        CRef r = reserve(clauseWords(ps.size(), learnt));
+        Clause* c = new (lea(r)) Clause(ps, learnt, effect);
+        c->size_etc |= 8;
+        return r; }
+
+    // a bitwise copy, so that marks, activity and abstraction survive
+    CRef allocCopy(const Clause& from) {
+        uint32_t words = clauseWords(from.size(), from.learnt());
+        CRef r = reserve(words);
+        memcpy(lea(r), &from, sizeof(uint32_t)*words);
+        lea(r)->size_etc |= 8;
+        return r; }
+
+    Clause*       lea       (CRef r)       { return (Clause*)(chunks[r >> chunk_bits] + (r & (chunk_words-1))); }
+    const Clause* lea       (CRef r) const { return (const Clause*)(chunks[r >> chunk_bits] + (r & (chunk_words-1))); }
+    Clause&       operator[](CRef r)       { return *lea(r); }
+    const Clause& operator[](CRef r) const { return *lea(r); }
+
+    // the reference of a clause of this region. The search starts
+    // from the most recent chunks, where most of the clauses are
+    CRef ael(const Clause* c) const {
+        assert(c->arena());
+        uintptr_t p = (uintptr_t)c;
+        for (int i = chunks.size()-1; i >= 0; --i) {
+            uintptr_t b = (uintptr_t)chunks[i];
+            if (b && p >= b && p < b + sizeof(uint32_t)*chunk_words)
+                return (i << chunk_bits) | (CRef)((p - b) / sizeof(uint32_t));
+        }
+        assert(0);
+        return CRef_Undef; }
+
+    void free(Clause& c) {
+        assert(c.arena());
+        waste += clauseWords(c.size(), c.learnt()); }
+
+    uint64_t size  () const { return used; }
+    uint64_t wasted() const { return waste; }
+
+    // copy c to 'to' unless that has already happened, and return
+    // the reference of the copy
+    CRef reloc(Clause& c, ClauseAllocator& to) {
+        if (c.reloced()) return c.extra.abst;
+        CRef r = to.allocCopy(c);
+        c.size_etc |= 16;
+        c.extra.abst = r;
+        return r; }
+
+    void moveTo(ClauseAllocator& to) {
+        to.clear();
+        chunks.moveTo(to.chunks);
+        to.top = top;
+        to.used = used;
+        to.waste = waste;
+        top = 0;
+        used = waste = 0; }
+
+    void clear() {
+        for (int i = 0; i != chunks.size(); ++i)
+            ::free(chunks[i]);
+        chunks.clear(true);
+        top = 0;
+        used = waste = 0; }
+};
+
 /**********************
  *
  * CSP stuff
@@ -565,8 +707,10 @@ class cons
   friend class Solver;
   int cqidx;
   int priority;
+  unsigned weight;  // for dom/wdeg: 1 + the number of times it failed
+  vec<int> scope;   // the cspvars it wakes or is scheduled on
  public:
-  cons() : cqidx(-1), priority(0) {}
+  cons() : cqidx(-1), priority(0), weight(1) {}
   virtual ~cons() {}
 
   /* propagate, setting a clause or an explainer as reason for each
@@ -607,6 +751,33 @@ class cons
 
 typedef std::pair<cons*, void*> wake_stub;
 
+/* The sparse propositional encoding of a lazily encoded csp
+   variable. Only the literals that someone asked for exist. The x <=
+   d literals are linked in a chain by binary clauses between
+   neighbours, each x = d literal by the usual 3 clauses to x <= d and
+   x <= d-1. Propagation among them is then done by unit propagation,
+   except that the bounds (and holes at the bounds) are updated
+   eagerly when the literals are enqueued.
+*/
+struct lazy_domain
+{
+  std::map<int, Var> leq; // the materialized x <= d literals
+  std::map<int, Var> eq;  // the materialized x = d literals
+  vec<Clause*> clauses;   // the clauses linking them, in the solver's region
+
+  Lit minlit;             // a true literal which implies x >= min
+  Lit maxlit;             // a true literal which implies x <= max
+
+  Var findleq(int d) const {
+    std::map<int, Var>::const_iterator i = leq.find(d);
+    return i == leq.end() ? var_Undef : i->second;
+  }
+  Var findeq(int d) const {
+    std::map<int, Var>::const_iterator i = eq.find(d);
+    return i == eq.end() ? var_Undef : i->second;
+  }
+};
+
 // all the fixed or non-backtracked data of a csp variable
 class cspvar_fixed
 {
@@ -621,7 +792,12 @@ class cspvar_fixed
   int omin; // min and max in the *original* domain
   int omax;
   Var firstbool;
+  lazy_domain *lazy;  // non-null if the encoding is created on demand
 
+  // dom/wdeg branching
+  int64_t wdeg;         // sum of the weights of the constraints on this var
+  cons *wdeg_last;      // the last constraint counted in wdeg
+  uint64_t wdeg_stamp;  // the last clause conflict counted in wdeg
 
   /* a cons may either wake immediately (like an ilog demon or a
      gecode advisor) when we process a literal, or it may be scheduled
@@ -641,8 +817,6 @@ class cspvar_fixed
     schedule_on_ub,
     schedule_on_fix;
 
-  vec<Clause*> ps1, ps2, ps3, ps4;
-
   // accessing the propositional encoding
   bool ind(int i) const { return i >= omin && i <= omax; }
   Var eqi(int i) const { return ind(i)
@@ -655,23 +829,21 @@ class cspvar_fixed
   Var eqiUnsafe(int i) const { return firstbool + 2*(i-omin); }
   Var leqiUnsafe(int i) const { return firstbool + 2*(i-omin)+1; }
 
-  void copyclauses(vec<Clause*>& target, vec<Clause*> const& source)
-  {
-    target.growTo(source.size(), 0L);
-    for(int i = 0; i != source.size(); ++i) {
-      if( source[i] && source[i] != INVALID_CLAUSE )
-        target[i] = Clause_new(*source[i]);
-    }
-  }
 public:
-  cspvar_fixed() {}
+  cspvar_fixed() : lazy(0L), wdeg(0), wdeg_last(0L), wdeg_stamp(0) {}
   cspvar_fixed(cspvar_fixed& f) :
-    omin(f.omin), omax(f.omax), firstbool(f.firstbool)
+    omin(f.omin), omax(f.omax), firstbool(f.firstbool), lazy(0L),
+    wdeg(0), wdeg_last(0L), wdeg_stamp(0)
   {
-    copyclauses(ps1, f.ps1);
-    copyclauses(ps2, f.ps2);
-    copyclauses(ps3, f.ps3);
-    copyclauses(ps4, f.ps4);
+    if( f.lazy ) {
+      lazy = new lazy_domain;
+      lazy->leq = f.lazy->leq;
+      lazy->eq = f.lazy->eq;
+      // the clauses belong to the region of the other solver, so
+      // whoever copies a variable has to copy them too
+      lazy->minlit = f.lazy->minlit;
+      lazy->maxlit = f.lazy->maxlit;
+    }
   }
 };
 
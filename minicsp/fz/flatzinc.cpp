@@ -158,7 +158,7 @@ namespace FlatZinc {
     : solver(s),
       intVarCount(-1), boolVarCount(-1), setVarCount(-1), _optVar(-1),
       _solveAnnotations(NULL),
-      findall(false)
+      findall(false), native_cumulative(false)
   {}
 
   void
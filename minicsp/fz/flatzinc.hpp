@@ -233,6 +233,7 @@ namespace FlatZinc {
 
     /// options
     bool findall; // find all solutions
+    bool native_cumulative; // post cumulative natively, not decomposed
   };
 
   /// %Exception class for %FlatZinc errors
@@ -46,21 +46,33 @@ int main(int argc, char *argv[])
   cmdline::parse_solver_options(s, args);
   bool stat = cmdline::has_option(args, "--stat");
   bool maint = cmdline::has_option(args, "--maint");
+  pair<bool, string> cumulative =
+    cmdline::has_argoption<string>(args, "--cumulative");
+  if( cumulative.first && cumulative.second != "decomp" &&
+      cumulative.second != "native" ) {
+    cerr << "--cumulative must be one of decomp, native\n";
+    return 1;
+  }
   setup_signal_handlers(&s);
 
   double cpu_time = cpuTime();
 
   FlatZinc::Printer p;
+  FlatZinc::FlatZincModel *model = new FlatZinc::FlatZincModel(s);
+  model->native_cumulative = cumulative.second == "native";
   FlatZinc::FlatZincModel *fm = 0L;
   if( maint ) // do not catch exceptions
-    fm = parse(args.back(), s, p);
+    fm = parse(args.back(), s, p, cerr, model);
   else try {
-      fm = parse(args.back(), s, p);
+      fm = parse(args.back(), s, p, cerr, model);
     } catch (unsat& e) {
       cout << setw(5) << setfill('=') << '='
            << "UNSATISFIABLE" << setw(5) << '=' << "\n";
     }
-  if( !fm ) return 0;
+  if( !fm ) {
+    delete model;
+    return 0;
+  }
 
   double parse_time = cpuTime() - cpu_time;
 
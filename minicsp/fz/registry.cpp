@@ -310,7 +310,7 @@ namespace FlatZinc {
     void p_alldifferent(Solver& s, FlatZincModel &m,
                         const ConExpr& ce, AST::Node* ann) {
       vector<cspvar> va = arg2intvarargs(s, m, ce[0]);
-      post_alldiff(s, va);
+      post_alldiff(s, va, CONSISTENCY_AUTO);
     }
 
     void p_int_eq(Solver& s, FlatZincModel &m,
@@ -650,26 +650,71 @@ namespace FlatZinc {
     }
 
     /* element constraints */
+    void p_array_var_int_element(Solver& s, FlatZincModel& m,
+                                 const ConExpr& ce, AST::Node* ann) {
+      cspvar selector = getIntVar(s, m, ce[0]);
+      cspvar result = getIntVar(s, m, ce[2]);
+      vector<cspvar> iv = arg2intvarargs(s, m, ce[1]);
+      post_element(s, result, selector, iv, 1);
+    }
     void p_array_int_element(Solver& s, FlatZincModel& m,
                              const ConExpr& ce, AST::Node* ann) {
       cspvar selector = getIntVar(s, m, ce[0]);
       cspvar result = getIntVar(s, m, ce[2]);
-      vector<cspvar> iv = arg2intvarargs(s, m, ce[1]);
+      vector<int> ia = arg2intargs(ce[1]);
+      post_element(s, result, selector, ia, 1);
+    }
+    void p_array_var_bool_element(Solver& s, FlatZincModel& m,
+                                  const ConExpr& ce, AST::Node* ann) {
+      cspvar selector = getIntVar(s, m, ce[0]);
+      cspvar result = getBoolVar(s, m, ce[2]);
+      vector<cspvar> iv = arg2boolvarargs(s, m, ce[1]);
       post_element(s, result, selector, iv, 1);
     }
     void p_array_bool_element(Solver& s, FlatZincModel& m,
                               const ConExpr& ce, AST::Node* ann) {
       cspvar selector = getIntVar(s, m, ce[0]);
       cspvar result = getBoolVar(s, m, ce[2]);
-      vector<cspvar> iv = arg2boolvarargs(s, m, ce[1]);
-      post_element(s, result, selector, iv, 1);
+      vector<int> ia = arg2boolargs(ce[1]);
+      post_element(s, result, selector, ia, 1);
     }
 
     /* alldiff */
     void p_all_different(Solver& s, FlatZincModel& m,
                          const ConExpr& ce, AST::Node* ann) {
       vector<cspvar> iv = arg2intvarargs(s, m, ce[0]);
-      post_alldiff(s, iv);
+      post_alldiff(s, iv, CONSISTENCY_AUTO);
+    }
+
+    /* global cardinality */
+    void p_global_cardinality(Solver& s, FlatZincModel& m,
+                              const ConExpr& ce, AST::Node* ann) {
+      vector<cspvar> iv = arg2intvarargs(s, m, ce[0]);
+      vector<int> cover = arg2intargs(ce[1]);
+      vector<cspvar> counts = arg2intvarargs(s, m, ce[2]);
+      post_gcc(s, iv, cover, counts);
+    }
+
+    void p_global_cardinality_low_up(Solver& s, FlatZincModel& m,
+                                     const ConExpr& ce, AST::Node* ann) {
+      vector<cspvar> iv = arg2intvarargs(s, m, ce[0]);
+      vector<int> cover = arg2intargs(ce[1]);
+      vector<int> lbound = arg2intargs(ce[2]);
+      vector<int> ubound = arg2intargs(ce[3]);
+      post_gcc(s, iv, cover, lbound, ubound);
+    }
+
+    /* circuit */
+    void p_circuit(Solver& s, FlatZincModel& m,
+                   const ConExpr& ce, AST::Node* ann) {
+      vector<cspvar> iv = arg2intvarargs(s, m, ce[0]);
+      post_circuit(s, iv, ce[1]->getInt());
+    }
+
+    void p_subcircuit(Solver& s, FlatZincModel& m,
+                      const ConExpr& ce, AST::Node* ann) {
+      vector<cspvar> iv = arg2intvarargs(s, m, ce[0]);
+      post_subcircuit(s, iv, ce[1]->getInt());
     }
 
     /* cumulative */
@@ -679,7 +724,7 @@ namespace FlatZinc {
       vector<cspvar> dur = arg2intvarargs(s, m, ce[1]);
       vector<cspvar> req = arg2intvarargs(s, m, ce[2]);
       cspvar cap = getIntVar(s, m, ce[3]);
-      post_cumulative(s, start, dur, req, cap);
+      post_cumulative(s, start, dur, req, cap, m.native_cumulative);
     }
 
     /* coercion constraints */
@@ -1233,12 +1278,17 @@ namespace FlatZinc {
 
         registry().add("int_in", &p_int_in);
 
-        registry().add("array_var_int_element", &p_array_int_element);
+        registry().add("array_var_int_element", &p_array_var_int_element);
         registry().add("array_int_element", &p_array_int_element);
-        registry().add("array_var_bool_element", &p_array_bool_element);
+        registry().add("array_var_bool_element", &p_array_var_bool_element);
         registry().add("array_bool_element", &p_array_bool_element);
 
         registry().add("all_different_int", &p_all_different);
+        registry().add("global_cardinality", &p_global_cardinality);
+        registry().add("global_cardinality_low_up",
+                       &p_global_cardinality_low_up);
+        registry().add("minicsp_circuit", &p_circuit);
+        registry().add("minicsp_subcircuit", &p_subcircuit);
         registry().add("cumulative", &p_cumulative);
 
         registry().add("bool2int", &p_bool2int);
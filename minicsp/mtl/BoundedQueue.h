@@ -0,0 +1,89 @@
+/***********************************************************************************[BoundedQueue.h]
+Glucose -- Copyright (c) 2009, Gilles Audemard, Laurent Simon
+                CRIL - Univ. Artois, France
+                LRI  - Univ. Paris Sud, France
+
+Glucose sources are based on MiniSat (see below MiniSat copyrights). Permissions and copyrights of
+Glucose are exactly the same as Minisat on which it is based on. (see below).
+
+---------------
+
+Copyright (c) 2003-2006, Niklas Een, Niklas Sorensson
+Copyright (c) 2007-2010, Niklas Sorensson
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**************************************************************************************************/
+
+#ifndef BoundedQueue_h
+#define BoundedQueue_h
+
+#include <cassert>
+#include <stdint.h>
+#include "Vec.h"
+
+//=================================================================================================
+// Glucose's bqueue: a queue of the last 'max' values pushed, with their running sum. When full,
+// pushing a value drops the oldest one.
+
+template <class T>
+class bqueue {
+    vec<T>   elems;
+    int      first;
+    int      last;
+    uint64_t sumofqueue;
+    int      maxsize;
+    int      queuesize; // Number of current elements, at most maxsize
+
+public:
+    bqueue(void) : first(0), last(0), sumofqueue(0), maxsize(0), queuesize(0) { }
+
+    void initSize(int size) { growTo(size); }
+
+    void push(T x) {
+        if (queuesize == maxsize) {
+            assert(last == first); // full: the new value replaces the oldest one
+            sumofqueue -= elems[last];
+            if ((++last) == maxsize) last = 0;
+        } else
+            queuesize++;
+        sumofqueue += x;
+        elems[first] = x;
+        if ((++first) == maxsize) first = 0;
+    }
+
+    T        peek      () const { assert(queuesize > 0); return elems[last]; }
+    void     pop       ()       { sumofqueue -= elems[last]; queuesize--; if ((++last) == maxsize) last = 0; }
+
+    uint64_t getsum    () const { return sumofqueue; }
+    double   getavg    () const { return queuesize ? sumofqueue / (double)queuesize : 0; }
+    int      maxSize   () const { return maxsize; }
+    bool     isvalid   () const { return queuesize == maxsize; }
+
+    void growTo(int size) {
+        elems.growTo(size);
+        first = 0; maxsize = size; queuesize = 0; last = 0; sumofqueue = 0;
+        for (int i = 0; i < size; i++) elems[i] = 0;
+    }
+
+    void fastclear() { first = 0; last = 0; queuesize = 0; sumofqueue = 0; } // Empty the queue, keeping its capacity
+
+    int  size(void)  { return queuesize; }
+
+    void clear(bool dealloc = false) { elems.clear(dealloc); first = 0; maxsize = 0; queuesize = 0; sumofqueue = 0; }
+};
+
+//=================================================================================================
+#endif
@@ -19,6 +19,7 @@ along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
 *************************************************************************/
 
 #include <vector>
+#include <cstdlib>
 #include <iostream>
 
 #include "minicsp/core/solver.hpp"
@@ -269,6 +270,204 @@ namespace {
     s.cancelUntil(0);
   }
   REGISTER_TEST(alldiff11);
+
+  // the vars that are fixed when it is posted are removed from the
+  // others
+  void alldiff12()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 0, 9);
+    x[0].assign(s, 5, NO_REASON);
+    post_alldiff(s, x);
+    assert(!x[1].indomain(s, 5));
+    assert(x[1].indomain(s, 0));
+  }
+  REGISTER_TEST(alldiff12);
+
+  // random domains with holes. Counting the solutions fails the
+  // repair of the matching many times, after which it must be
+  // restored
+  void alldiff13()
+  {
+    srand(73);
+    for(int iter = 0; iter != 100; ++iter) {
+      int n = 2 + iter % 5, d = n + 1;
+      Solver s;
+      vector<cspvar> x = s.newCSPVarArray(n, 0, d-1);
+      vector< vector<bool> > dom(n, vector<bool>(d, true));
+      for(int i = 0; i != n; ++i)
+        for(int v = 0; v != d; ++v)
+          if( v != i && rand() % 3 == 0 ) {
+            dom[i][v] = false;
+            x[i].remove(s, v, NO_REASON);
+          }
+      int ns = 0;
+      vector<int> a(n, 0);
+      for(;;) {
+        bool ok = true;
+        for(int i = 0; i != n && ok; ++i) {
+          ok = dom[i][a[i]];
+          for(int j = 0; j != i && ok; ++j)
+            ok = a[i] != a[j];
+        }
+        ns += ok;
+        int i = 0;
+        while( i != n && a[i] == d-1 ) { a[i] = 0; ++i; }
+        if( i == n ) break;
+        ++a[i];
+      }
+      post_alldiff(s, x);
+      assert_num_solutions(s, ns);
+    }
+  }
+  REGISTER_TEST(alldiff13);
+
+  // as alldiff13, on permutations of lazy and eager vars. Lazy vars
+  // lose values at their bounds without x != d events
+  void alldiff14()
+  {
+    srand(79);
+    for(int iter = 0; iter != 120; ++iter) {
+      int n = 2 + iter % 6, d = n;
+      vector< vector<bool> > dom(n, vector<bool>(d, true));
+      for(int i = 0; i != n; ++i)
+        for(int v = 0; v != d; ++v)
+          if( v != i && rand() % 3 == 0 )
+            dom[i][v] = false;
+      int ns = 0;
+      vector<int> a(n, 0);
+      for(;;) {
+        bool ok = true;
+        for(int i = 0; i != n && ok; ++i) {
+          ok = dom[i][a[i]];
+          for(int j = 0; j != i && ok; ++j)
+            ok = a[i] != a[j];
+        }
+        ns += ok;
+        int i = 0;
+        while( i != n && a[i] == d-1 ) { a[i] = 0; ++i; }
+        if( i == n ) break;
+        ++a[i];
+      }
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        vector<cspvar> x;
+        for(int i = 0; i != n; ++i) {
+          x.push_back(lazy ? s.newLazyCSPVar(0, d-1) : s.newCSPVar(0, d-1));
+          for(int v = 0; v != d; ++v)
+            if( !dom[i][v] )
+              x[i].remove(s, v, NO_REASON);
+        }
+        post_alldiff(s, x);
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(alldiff14);
+
+  // bounds consistency: the Hall interval [1,2] pushes up the lower
+  // bound of x[2], then [1,3] pushes down the upper bound of x[3]
+  void alldiff_bc01()
+  {
+    Solver s;
+    s.debugclauses = 1;
+    vector<cspvar> x = s.newCSPVarArray(4, 1, 100);
+    post_alldiff(s, x, CONSISTENCY_BOUNDS);
+
+    s.newDecisionLevel();
+    x[0].setmax(s, 2, NO_REASON);
+    x[1].setmax(s, 2, NO_REASON);
+    x[2].setmax(s, 3, NO_REASON);
+    x[3].setmax(s, 4, NO_REASON);
+    assert(!s.propagate());
+    assert(x[2].min(s) == 3);
+    assert(x[3].min(s) == 4);
+    s.cancelUntil(0);
+
+    s.newDecisionLevel();
+    x[0].setmin(s, 99, NO_REASON);
+    x[1].setmin(s, 99, NO_REASON);
+    x[2].setmin(s, 98, NO_REASON);
+    assert(!s.propagate());
+    assert(x[2].max(s) == 98);
+    assert(x[3].max(s) == 97);
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(alldiff_bc01);
+
+  void alldiff_bc02()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 1, 2);
+    MUST_BE_UNSAT(post_alldiff(s, x, CONSISTENCY_BOUNDS));
+  }
+  REGISTER_TEST(alldiff_bc02);
+
+  // random intervals, eager and lazy, with learning
+  void alldiff_bc03()
+  {
+    srand(71);
+    for(int iter = 0; iter != 100; ++iter) {
+      int n = 2 + iter % 5, d = n + 2;
+      vector<int> lo(n), hi(n);
+      for(int i = 0; i != n; ++i) {
+        lo[i] = rand() % d;
+        hi[i] = lo[i] + rand() % (d - lo[i]);
+      }
+      int ns = 0;
+      vector<int> a(lo);
+      for(;;) {
+        bool distinct = true;
+        for(int i = 0; i != n && distinct; ++i)
+          for(int j = 0; j != i && distinct; ++j)
+            distinct = a[i] != a[j];
+        ns += distinct;
+        int i = 0;
+        while( i != n && a[i] == hi[i] ) { a[i] = lo[i]; ++i; }
+        if( i == n ) break;
+        ++a[i];
+      }
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = 1;
+        vector<cspvar> x;
+        for(int i = 0; i != n; ++i)
+          x.push_back(lazy ? s.newLazyCSPVar(lo[i], hi[i])
+                      : s.newCSPVar(lo[i], hi[i]));
+        try {
+          post_alldiff(s, x, CONSISTENCY_BOUNDS);
+        } catch( minicsp::unsat& ) {
+          assert( ns == 0 );
+          continue;
+        }
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(alldiff_bc03);
+
+  // automatic consistency: GAC would remove 2 and 3 from x[2], but
+  // the domains are intervals so it only enforces bounds
+  // consistency. Once there is a hole it enforces GAC
+  void alldiff_bc04()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(2, 2, 3);
+    x.push_back(s.newCSPVar(1, 4));
+    post_alldiff(s, x, CONSISTENCY_AUTO);
+    assert(!s.propagate());
+    assert(x[2].indomain(s, 2));
+
+    Solver s2;
+    vector<cspvar> y = s2.newCSPVarArray(2, 2, 3);
+    y.push_back(s2.newCSPVar(1, 5));
+    y[2].remove(s2, 4, NO_REASON);
+    post_alldiff(s2, y, CONSISTENCY_AUTO);
+    assert(!s2.propagate());
+    assert(!y[2].indomain(s2, 2));
+    assert(!y[2].indomain(s2, 3));
+  }
+  REGISTER_TEST(alldiff_bc04);
 }
 
 void alldiff_test()
@@ -494,6 +494,22 @@ namespace {
   }
   REGISTER_TEST(abs04);
 
+  // lazy vars change bounds without x != d events
+  void abs05()
+  {
+    for(int c = 0; c != 2; ++c) {
+      Solver s;
+      s.debugclauses = 1;
+      s.lazy_threshold = 0;
+      cspvar x = s.newCSPVar(-5, 5);
+      cspvar y = s.newCSPVar(0, 5);
+      post_abs(s, x, y, c);
+      // |x| = y + c
+      assert_num_solutions(s, c ? 10 : 11);
+    }
+  }
+  REGISTER_TEST(abs05);
+
   // mult, all positive
   void mult01()
   {
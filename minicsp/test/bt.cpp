@@ -22,14 +22,17 @@ along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "minicsp/core/solver.hpp"
 #include "minicsp/core/cons.hpp"
+#include "test.hpp"
 
 using namespace std;
 using namespace minicsp;
 
 namespace {
+  // snapshot mode: plain deref is enough
   void test01()
   {
     Solver s;
+    s.trail_backtrackable = false;
     btptr p = s.alloc_backtrackable(sizeof(int));
     btptr p1 = s.alloc_backtrackable(sizeof(char));
 
@@ -71,6 +74,167 @@ namespace {
     assert( i == 0 );
     assert( c == 1 );
   }
+
+  // trail mode: writes go through deref_mut/bt_write
+  void test02()
+  {
+    Solver s;
+    btptr p = s.alloc_backtrackable(sizeof(int));
+    btptr p1 = s.alloc_backtrackable(sizeof(char));
+    btptr pa = s.alloc_backtrackable(5*sizeof(bool));
+
+    s.bt_write<int>(p, 0);
+    s.bt_write<char>(p1, 1);
+    for(int j = 0; j != 5; ++j)
+      s.bt_write_array<bool>(pa, j, false);
+
+    s.newDecisionLevel();
+    s.bt_write<int>(p, 1);
+    s.deref_mut<char>(p1) = 2;
+    s.bt_write_array<bool>(pa, 1, true);
+
+    s.newDecisionLevel();
+    s.bt_write<int>(p, 2);
+    ++s.deref_mut<int>(p);
+    s.deref_mut<char>(p1) = 3;
+    s.deref_array_mut<bool>(pa, 3) = true;
+    assert( s.deref<int>(p) == 3 );
+
+    s.cancelUntil(1);
+    assert( s.deref<int>(p) == 1 );
+    assert( s.deref<char>(p1) == 2 );
+    assert( s.deref_array<bool>(pa)[1] );
+    assert( !s.deref_array<bool>(pa)[3] );
+
+    s.bt_write<int>(p, 4);
+    s.newDecisionLevel();
+    s.bt_write<int>(p, 5);
+    s.bt_write_array<bool>(pa, 4, true);
+
+    s.cancelUntil(1);
+    assert( s.deref<int>(p) == 4 );
+    assert( !s.deref_array<bool>(pa)[4] );
+
+    s.cancelUntil(0);
+    assert( s.deref<int>(p) == 0 );
+    assert( s.deref<char>(p1) == 1 );
+    for(int j = 0; j != 5; ++j)
+      assert( !s.deref_array<bool>(pa)[j] );
+  }
+
+  // the backtrackable<T> wrapper, in both modes
+  void test03(bool trail)
+  {
+    Solver s;
+    s.trail_backtrackable = trail;
+    backtrackable<int> i(s, 0);
+
+    s.newDecisionLevel();
+    *i = 1;
+    s.newDecisionLevel();
+    *i += 1;
+    assert( *i == 2 );
+    s.cancelUntil(1);
+    assert( *i == 1 );
+    s.cancelUntil(0);
+    assert( *i == 0 );
+  }
+
+  void queens(Solver& s, int n)
+  {
+    vector<cspvar> x = s.newCSPVarArray(n, 1, n);
+    for(int i = 0; i != n; ++i)
+      for(int j = i+1; j != n; ++j) {
+        post_neq(s, x[i], x[j], 0);
+        post_neq(s, x[i], x[j], j-i);
+        post_neq(s, x[i], x[j], i-j);
+      }
+  }
+
+  // compacting the clause region whenever anything is wasted must
+  // not change the search. Lazy variables have clauses of their own
+  void test04(int lazy_threshold)
+  {
+    Solver s;
+    s.garbage_frac = 0;
+    s.lazy_threshold = lazy_threshold;
+    queens(s, 8);
+    assert_num_solutions(s, 92);
+  }
+
+  // the tiered learnt clause database must not lose solutions, also
+  // when compaction moves the learnt clauses and their lbd word
+  void test05(int core_lbd, int tier2_lbd, double garbage_frac = 0.2)
+  {
+    Solver s;
+    s.garbage_frac = garbage_frac;
+    s.learnt_policy = LEARNTS_LBD;
+    s.core_lbd = core_lbd;
+    s.tier2_lbd = tier2_lbd;
+    queens(s, 8);
+    assert_num_solutions(s, 92);
+  }
+
+  // frequent restarts under each policy must not lose solutions
+  void test06(RestartPolicy policy)
+  {
+    Solver s;
+    s.restart_policy = policy;
+    s.restart_first = 2;
+    s.lbd_queue_size = 5;
+    s.trail_queue_size = 10;
+    s.blocking_first = 0;
+    queens(s, 8);
+    assert_num_solutions(s, 92);
+  }
+
+  // dom/wdeg must keep its heap consistent across backtracking, with
+  // and without learning, eager and lazy
+  void test07(bool learning, int lazy_threshold)
+  {
+    Solver s;
+    s.varbranch = VAR_DOMWDEG;
+    s.learning = learning;
+    s.lazy_threshold = lazy_threshold;
+    queens(s, 8);
+    assert_num_solutions(s, 92);
+  }
+
+  // the heap of VAR_DOM and the first unfixed var of VAR_LEX must be
+  // restored on backtracking
+  void test08(BranchHeuristic varbranch, int lazy_threshold)
+  {
+    Solver s;
+    s.varbranch = varbranch;
+    s.lazy_threshold = lazy_threshold;
+    queens(s, 8);
+    assert_num_solutions(s, 92);
+  }
+
+  // each value heuristic must still enumerate every solution
+  void test09(ValBranchHeuristic valbranch, int lazy_threshold)
+  {
+    Solver s;
+    s.varbranch = VAR_DOM;
+    s.valbranch = valbranch;
+    s.lazy_threshold = lazy_threshold;
+    queens(s, 8);
+    assert_num_solutions(s, 92);
+  }
+
+  // without learning there are no LBDs, so glucose restarts fall
+  // back to Luby instead of never restarting
+  void test10()
+  {
+    Solver s;
+    s.restart_policy = RESTART_GLUCOSE;
+    s.learning = false;
+    s.restart_first = 2;
+    queens(s, 8);
+    assert_num_solutions(s, 92);
+    // the 93 calls to solve() start once each
+    assert(s.starts > 93);
+  }
 }
 
 void bt_test()
@@ -80,4 +244,55 @@ void bt_test()
   cerr << "test 01 ... " << flush;
   test01();
   cerr << "OK" << endl;
+
+  cerr << "test 02 ... " << flush;
+  test02();
+  cerr << "OK" << endl;
+
+  cerr << "test 03 ... " << flush;
+  test03(false);
+  test03(true);
+  cerr << "OK" << endl;
+
+  cerr << "test 04 ... " << flush;
+  test04(-1);
+  test04(0);
+  cerr << "OK" << endl;
+
+  cerr << "test 05 ... " << flush;
+  test05(2, 6);
+  test05(0, 0);
+  test05(2, 6, 0);
+  cerr << "OK" << endl;
+
+  cerr << "test 06 ... " << flush;
+  test06(RESTART_LUBY);
+  test06(RESTART_GEOMETRIC);
+  test06(RESTART_GLUCOSE);
+  cerr << "OK" << endl;
+
+  cerr << "test 07 ... " << flush;
+  test07(true, -1);
+  test07(false, -1);
+  test07(true, 0);
+  cerr << "OK" << endl;
+
+  cerr << "test 08 ... " << flush;
+  test08(VAR_DOM, -1);
+  test08(VAR_DOM, 0);
+  test08(VAR_LEX, -1);
+  test08(VAR_LEX, 0);
+  cerr << "OK" << endl;
+
+  cerr << "test 09 ... " << flush;
+  for(ValBranchHeuristic h : {VAL_VSIDS, VAL_LEX, VAL_BISECT, VAL_MAX,
+        VAL_MEDIAN, VAL_REVERSE_BISECT}) {
+    test09(h, -1);
+    test09(h, 0);
+  }
+  cerr << "OK" << endl;
+
+  cerr << "test 10 ... " << flush;
+  test10();
+  cerr << "OK" << endl;
 }
@@ -0,0 +1,212 @@
+/*************************************************************************
+minicsp
+
+Copyright 2010--2011 George Katsirelos
+
+Minicsp is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Minicsp is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+#include "minicsp/core/solver.hpp"
+#include "minicsp/core/cons.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+namespace {
+  // does a, with a[i] the successor of i, form a (sub)circuit
+  bool is_circuit(vector<int> const& a, bool sub)
+  {
+    int n = a.size(), k = 0, first = -1;
+    for(int i = 0; i != n; ++i)
+      if( a[i] != i ) {
+        ++k;
+        if( first < 0 ) first = i;
+      }
+    if( !sub && k != n ) return n == 1;
+    if( k == 0 ) return true;
+    int u = first;
+    for(int steps = 0; steps != k; ++steps) {
+      u = a[u];
+      if( a[u] == u ) return false;
+      if( u == first ) return steps == k-1;
+    }
+    return false;
+  }
+
+  // the number of (sub)circuits over the domains
+  int count_circuits(vector< vector<bool> > const& dom, bool sub)
+  {
+    int n = dom.size(), ns = 0;
+    vector<int> a(n, 0);
+    for(;;) {
+      bool ok = true;
+      for(int i = 0; i != n && ok; ++i)
+        ok = dom[i][a[i]];
+      ns += ok && is_circuit(a, sub);
+      int i = 0;
+      while( i != n && a[i] == n-1 ) { a[i] = 0; ++i; }
+      if( i == n ) break;
+      ++a[i];
+    }
+    return ns;
+  }
+
+  // fixing x0 = 1 and x1 = 2 forbids x2 = 0, which would close a
+  // subtour
+  void circuit01()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(4, 1, 4);
+    post_circuit(s, x, 1);
+    assert(!x[0].indomain(s, 1));
+
+    s.newDecisionLevel();
+    x[0].assign(s, 2, NO_REASON);
+    x[1].assign(s, 3, NO_REASON);
+    assert(!s.propagate());
+    assert(!x[2].indomain(s, 1));
+    assert(x[2].indomain(s, 4));
+    s.cancelUntil(0);
+    assert(x[2].indomain(s, 1));
+  }
+  REGISTER_TEST(circuit01);
+
+  // {0,1} and {2,3} only point to each other
+  void circuit02()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(4, 0, 3);
+    post_circuit(s, x);
+
+    s.newDecisionLevel();
+    x[0].setmax(s, 1, NO_REASON);
+    x[1].setmax(s, 1, NO_REASON);
+    assert(s.propagate());
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(circuit02);
+
+  // the nodes that cannot reach a mandatory node are out of the
+  // subcircuit
+  void subcircuit01()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(5, 0, 4);
+    post_subcircuit(s, x);
+
+    s.newDecisionLevel();
+    x[0].remove(s, 0, NO_REASON);
+    x[3].setmin(s, 3, NO_REASON);
+    x[4].setmin(s, 3, NO_REASON);
+    assert(!s.propagate());
+    assert(x[3].min(s) == 3 && x[3].max(s) == 3);
+    assert(x[4].min(s) == 4 && x[4].max(s) == 4);
+    assert(x[0].max(s) <= 2);
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(subcircuit01);
+
+  // all (sub)circuits over full domains, eager and lazy, with
+  // learning
+  void circuit_count(bool sub)
+  {
+    for(int n = 1; n != 6; ++n) {
+      vector< vector<bool> > dom(n, vector<bool>(n, true));
+      int ns = count_circuits(dom, sub);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = 1;
+        vector<cspvar> x;
+        for(int i = 0; i != n; ++i)
+          x.push_back(lazy ? s.newLazyCSPVar(0, n-1) : s.newCSPVar(0, n-1));
+        if( sub )
+          post_subcircuit(s, x);
+        else
+          post_circuit(s, x);
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+
+  void circuit03()
+  {
+    circuit_count(false);
+  }
+  REGISTER_TEST(circuit03);
+
+  void subcircuit02()
+  {
+    circuit_count(true);
+  }
+  REGISTER_TEST(subcircuit02);
+
+  // random domains with holes
+  void circuit_random(bool sub)
+  {
+    srand(sub ? 83 : 79);
+    for(int iter = 0; iter != 100; ++iter) {
+      int n = 2 + iter % 5;
+      vector< vector<bool> > dom(n, vector<bool>(n, true));
+      for(int i = 0; i != n; ++i)
+        for(int v = 0; v != n; ++v)
+          if( rand() % 3 == 0 ) dom[i][v] = false;
+      for(int i = 0; i != n; ++i)
+        dom[i][rand() % n] = true;
+      int ns = count_circuits(dom, sub);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        vector<cspvar> x;
+        for(int i = 0; i != n; ++i) {
+          x.push_back(lazy ? s.newLazyCSPVar(0, n-1) : s.newCSPVar(0, n-1));
+          for(int v = 0; v != n; ++v)
+            if( !dom[i][v] )
+              x[i].remove(s, v, NO_REASON);
+        }
+        try {
+          if( sub )
+            post_subcircuit(s, x);
+          else
+            post_circuit(s, x);
+        } catch( minicsp::unsat& ) {
+          assert( ns == 0 );
+          continue;
+        }
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+
+  void circuit04()
+  {
+    circuit_random(false);
+  }
+  REGISTER_TEST(circuit04);
+
+  void subcircuit03()
+  {
+    circuit_random(true);
+  }
+  REGISTER_TEST(subcircuit03);
+}
+
+void circuit_test()
+{
+  cerr << "circuit tests\n";
+  the_test_container().run();
+}
@@ -0,0 +1,224 @@
+/*************************************************************************
+minicsp
+
+Copyright 2014 George Katsirelos
+
+Minicsp is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Minicsp is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include <iostream>
+
+#include "minicsp/core/solver.hpp"
+#include "minicsp/core/cons.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+namespace {
+  // the number of schedules of tasks with starts in [0, horizon],
+  // fixed durations and requirements, that do not exceed cap
+  int count_schedules(vector<int> const& dur, vector<int> const& req,
+                      int horizon, int cap)
+  {
+    size_t n = dur.size();
+    vector<int> start(n, 0);
+    int count = 0;
+    for(;;) {
+      bool ok = true;
+      for(int t = 0; ok && t <= 2*horizon; ++t) {
+        int h = 0;
+        for(size_t i = 0; i != n; ++i)
+          if( start[i] <= t && t < start[i] + dur[i] )
+            h += req[i];
+        ok = h <= cap;
+      }
+      if( ok ) ++count;
+      size_t i = 0;
+      while( i != n && start[i] == horizon ) start[i++] = 0;
+      if( i == n ) break;
+      ++start[i];
+    }
+    return count;
+  }
+
+  void cumulative_post(Solver& s, vector<cspvar>& start,
+                       vector<int> const& dur, vector<int> const& req,
+                       int horizon, int cap, bool native)
+  {
+    size_t n = dur.size();
+    start = s.newCSPVarArray(n, 0, horizon);
+    vector<cspvar> d, r;
+    for(size_t i = 0; i != n; ++i) {
+      d.push_back(s.newCSPVar(dur[i], dur[i]));
+      r.push_back(s.newCSPVar(req[i], req[i]));
+    }
+    post_cumulative(s, start, d, r, s.newCSPVar(cap, cap), native);
+  }
+
+  // the compulsory part of task 0 keeps task 1 out of [1, 3)
+  void cumulative01()
+  {
+    Solver s;
+    vector<cspvar> start;
+    vector<int> dur = {3, 2}, req = {2, 1};
+    cumulative_post(s, start, dur, req, 5, 2, true);
+    assert( !s.propagate() );
+    assert( start[1].min(s) == 0 );
+    s.newDecisionLevel();
+    start[0].setmax(s, 1, NO_REASON);
+    assert( !s.propagate() );
+    assert( start[1].min(s) == 3 );
+    assert( start[1].max(s) == 5 );
+    s.cancelUntil(0);
+    s.newDecisionLevel();
+    start[0].setmin(s, 3, NO_REASON);
+    start[0].setmax(s, 3, NO_REASON);
+    assert( !s.propagate() );
+    assert( start[1].min(s) == 0 );
+    assert( start[1].max(s) == 1 );
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(cumulative01);
+
+  // overlapping compulsory parts exceed the capacity
+  void cumulative02()
+  {
+    Solver s;
+    vector<cspvar> start = s.newCSPVarArray(2, 0, 1);
+    vector<cspvar> d = { s.newCSPVar(3, 3), s.newCSPVar(3, 3) };
+    vector<cspvar> r = { s.newCSPVar(1, 2), s.newCSPVar(1, 2) };
+    cspvar cap = s.newCSPVar(0, 3);
+    post_cumulative(s, start, d, r, cap, true);
+    assert( !s.propagate() );
+    assert( cap.min(s) == 2 );
+    s.newDecisionLevel();
+    r[0].setmin(s, 2, NO_REASON);
+    assert( !s.propagate() );
+    assert( cap.min(s) == 3 );
+    s.newDecisionLevel();
+    r[1].setmin(s, 2, NO_REASON);
+    assert( s.propagate() );
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(cumulative02);
+
+  // same number of solutions as the decomposition
+  void cumulative03()
+  {
+    vector<int> dur = {2, 1, 3, 2}, req = {1, 2, 1, 2};
+    const int horizon = 4, cap = 3;
+    int ns = count_schedules(dur, req, horizon, cap);
+    for(int native = 0; native != 2; ++native) {
+      Solver s;
+      vector<cspvar> start;
+      cumulative_post(s, start, dur, req, horizon, cap, native);
+      assert_num_solutions(s, ns);
+    }
+  }
+  REGISTER_TEST(cumulative03);
+
+  // the native propagator also accepts unfixed durations and
+  // requirements
+  void cumulative04()
+  {
+    Solver s;
+    vector<cspvar> start = s.newCSPVarArray(3, 0, 3);
+    vector<cspvar> d = s.newCSPVarArray(3, 1, 2);
+    vector<cspvar> r = s.newCSPVarArray(3, 1, 2);
+    post_cumulative(s, start, d, r, s.newCSPVar(2, 2), true);
+    int ns = 0;
+    for(int i = 0; i != 1<<12; ++i) {
+      vector<int> st(3), du(3), rq(3);
+      for(int j = 0; j != 3; ++j) {
+        st[j] = (i >> 4*j) & 3;
+        du[j] = 1 + ((i >> (4*j+2)) & 1);
+        rq[j] = 1 + ((i >> (4*j+3)) & 1);
+      }
+      bool ok = true;
+      for(int t = 0; ok && t != 5; ++t) {
+        int h = 0;
+        for(int j = 0; j != 3; ++j)
+          if( st[j] <= t && t < st[j] + du[j] )
+            h += rq[j];
+        ok = h <= 2;
+      }
+      if( ok ) ++ns;
+    }
+    assert_num_solutions(s, ns);
+  }
+  REGISTER_TEST(cumulative04);
+
+  // task 0 cannot end before both 1 and 2 (edge-finding), task 4
+  // must start after task 3 (detectable precedence) and task 5
+  // cannot start after task 6 (not-last)
+  void disjunctive01()
+  {
+    Solver s;
+    vector<cspvar> x = { s.newCSPVar(0, 10), s.newCSPVar(1, 3),
+                         s.newCSPVar(1, 3), s.newCSPVar(20, 21),
+                         s.newCSPVar(20, 26), s.newCSPVar(30, 33),
+                         s.newCSPVar(32, 33) };
+    vector<int> dur = {3, 2, 2, 3, 2, 2, 2};
+    post_disjunctive(s, x, dur);
+    assert( !s.propagate() );
+    assert( x[0].min(s) == 5 );
+    assert( x[4].min(s) == 23 );
+    assert( x[5].max(s) == 31 );
+    s.newDecisionLevel();
+    x[1].setmin(s, 2, NO_REASON);
+    x[2].setmin(s, 2, NO_REASON);
+    assert( s.propagate() );
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(disjunctive01);
+
+  void disjunctive02()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 0, 2);
+    vector<int> dur = {2, 2, 1};
+    MUST_BE_UNSAT(post_disjunctive(s, x, dur));
+  }
+  REGISTER_TEST(disjunctive02);
+
+  // counted by brute force, both directly and through a cumulative
+  // with capacity 1
+  void disjunctive03()
+  {
+    vector<int> dur = {2, 1, 3, 2, 1}, req = {1, 1, 1, 1, 1};
+    const int horizon = 6;
+    int ns = count_schedules(dur, req, horizon, 1);
+    for(int cumul = 0; cumul != 2; ++cumul) {
+      Solver s;
+      s.debugclauses = 1;
+      vector<cspvar> start;
+      if( cumul )
+        cumulative_post(s, start, dur, req, horizon, 1, false);
+      else {
+        start = s.newCSPVarArray(dur.size(), 0, horizon);
+        post_disjunctive(s, start, dur);
+      }
+      assert_num_solutions(s, ns);
+    }
+  }
+  REGISTER_TEST(disjunctive03);
+}
+
+void cumulative_test()
+{
+  cerr << "cumulative tests\n";
+
+  the_test_container().run();
+}
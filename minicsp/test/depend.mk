@@ -0,0 +1,340 @@
+alldiff.o: alldiff.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+arith.o: arith.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+bt.o: bt.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+circuit.o: circuit.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+cumulative.o: cumulative.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+dom.o: dom.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+element.o: element.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+gcc.o: gcc.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+inverse.o: inverse.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+lex.o: lex.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+lin.o: lin.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+main.o: main.cpp
+nvalue.o: nvalue.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+pb.o: pb.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+regular.o: regular.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+schedule.o: schedule.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+set.o: set.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp ../../minicsp/core/setcons.hpp
+table.o: table.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+test.o: test.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp
+alldiff.op: alldiff.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+arith.op: arith.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+bt.op: bt.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+circuit.op: circuit.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+cumulative.op: cumulative.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+dom.op: dom.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+element.op: element.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+gcc.op: gcc.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+inverse.op: inverse.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+lex.op: lex.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+lin.op: lin.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+main.op: main.cpp
+nvalue.op: nvalue.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+pb.op: pb.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+regular.op: regular.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+schedule.op: schedule.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+set.op: set.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp ../../minicsp/core/setcons.hpp
+table.op: table.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+test.op: test.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp
+alldiff.od: alldiff.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+arith.od: arith.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+bt.od: bt.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+circuit.od: circuit.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+cumulative.od: cumulative.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+dom.od: dom.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+element.od: element.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+gcc.od: gcc.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+inverse.od: inverse.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+lex.od: lex.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+lin.od: lin.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+main.od: main.cpp
+nvalue.od: nvalue.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+pb.od: pb.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+regular.od: regular.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+schedule.od: schedule.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+set.od: set.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp ../../minicsp/core/setcons.hpp
+table.od: table.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+test.od: test.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp
+alldiff.or: alldiff.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+arith.or: arith.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+bt.or: bt.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+circuit.or: circuit.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+cumulative.or: cumulative.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+dom.or: dom.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+element.or: element.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+gcc.or: gcc.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+inverse.or: inverse.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+lex.or: lex.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+lin.or: lin.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+main.or: main.cpp
+nvalue.or: nvalue.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+pb.or: pb.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+regular.or: regular.cpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp test.hpp
+schedule.or: schedule.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp
+set.or: set.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp ../../minicsp/core/cons.hpp \
+ ../../minicsp/core/solver.hpp ../../minicsp/core/setcons.hpp
+table.or: table.cpp ../../minicsp/core/solver.hpp ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Alg.h \
+ ../../minicsp/mtl/BoundedQueue.h ../../minicsp/core/solvertypes.hpp \
+ ../../minicsp/core/cons.hpp ../../minicsp/core/solver.hpp test.hpp
+test.or: test.cpp test.hpp ../../minicsp/core/solver.hpp \
+ ../../minicsp/mtl/Vec.h ../../minicsp/mtl/Heap.h ../../minicsp/mtl/Vec.h \
+ ../../minicsp/mtl/Alg.h ../../minicsp/mtl/BoundedQueue.h \
+ ../../minicsp/core/solvertypes.hpp
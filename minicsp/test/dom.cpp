@@ -21,6 +21,7 @@ along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
 #include <iostream>
 #include "test.hpp"
 #include "minicsp/core/solver.hpp"
+#include "minicsp/core/cons.hpp"
 
 using namespace std;
 
@@ -250,6 +251,160 @@ namespace {
   }
   REGISTER_TEST(test12);
 
+  // the reasons of the channeling literals are the clauses of the
+  // encoding
+  void test13()
+  {
+    Solver s;
+    cspvar x = s.newCSPVar(1, 10);
+
+    s.newDecisionLevel();
+    x.remove(s, 5, NO_REASON);
+    x.setmin(s, 5, NO_REASON);
+    assert( x.min(s) == 6 );
+
+    Clause *c = s.varReason(x.leqi(s, 3));
+    assert( c && c->size() == 2 );
+    assert( (*c)[0] == ~Lit(x.leqi(s, 3)) );
+    assert( (*c)[1] == Lit(x.leqi(s, 4)) );
+
+    c = s.varReason(x.eqi(s, 4));
+    assert( c && c->size() == 2 );
+    assert( (*c)[0] == ~Lit(x.eqi(s, 4)) );
+    assert( (*c)[1] == Lit(x.leqi(s, 4)) );
+
+    c = s.varReason(x.leqi(s, 5));
+    assert( c && c->size() == 3 );
+    assert( (*c)[0] == ~Lit(x.leqi(s, 5)) );
+    assert( (*c)[1] == Lit(x.leqi(s, 4)) );
+    assert( (*c)[2] == Lit(x.eqi(s, 5)) );
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(test13);
+
+  //--------------------------------------------------
+  // lazily encoded domains
+
+  // bounds and holes, restored on backtracking
+  void lazy01()
+  {
+    Solver s;
+    cspvar x = s.newLazyCSPVar(1, 100);
+    assert( s.cspvarlazy(x) );
+
+    s.newDecisionLevel();
+    x.setmin(s, 10, NO_REASON);
+    x.setmax(s, 20, NO_REASON);
+    assert( !s.propagate() );
+    assert( x.min(s) == 10 );
+    assert( x.max(s) == 20 );
+    assert( !x.indomain(s, 9) );
+    assert( !x.indomain(s, 21) );
+
+    s.newDecisionLevel();
+    x.remove(s, 10, NO_REASON);
+    x.remove(s, 11, NO_REASON);
+    x.remove(s, 20, NO_REASON);
+    assert( !s.propagate() );
+    assert( x.min(s) == 12 );
+    assert( x.max(s) == 19 );
+    assert( x.indomain(s, 15) );
+
+    s.newDecisionLevel();
+    x.assign(s, 15, NO_REASON);
+    assert( !s.propagate() );
+    assert( x.min(s) == 15 );
+    assert( x.max(s) == 15 );
+
+    s.cancelUntil(2);
+    assert( x.min(s) == 12 );
+    assert( x.max(s) == 19 );
+    s.cancelUntil(1);
+    assert( x.min(s) == 10 );
+    assert( x.max(s) == 20 );
+    assert( x.indomain(s, 11) );
+    s.cancelUntil(0);
+    assert( x.min(s) == 1 );
+    assert( x.max(s) == 100 );
+  }
+  REGISTER_TEST(lazy01);
+
+  // literals created during search take the value implied by the
+  // current bounds, and lose it again on backtracking
+  void lazy02()
+  {
+    Solver s;
+    cspvar x = s.newLazyCSPVar(1, 100);
+
+    s.newDecisionLevel();
+    x.setmin(s, 50, NO_REASON);
+    x.setmax(s, 60, NO_REASON);
+    assert( !s.propagate() );
+    Var l30 = x.leqi(s, 30);
+    Var l70 = x.leqi(s, 70);
+    Var e20 = x.eqi(s, 20);
+    Var l55 = x.leqi(s, 55);
+    assert( s.value(l30) == l_False );
+    assert( s.value(l70) == l_True );
+    assert( s.value(e20) == l_False );
+    assert( s.value(l55) == l_Undef );
+
+    s.cancelUntil(0);
+    assert( s.value(l30) == l_Undef );
+    assert( s.value(l70) == l_Undef );
+    assert( s.value(e20) == l_Undef );
+
+    s.newDecisionLevel();
+    s.uncheckedEnqueue( Lit(l30) );
+    assert( !s.propagate() );
+    assert( x.max(s) == 30 );
+    assert( s.value(l55) == l_True );
+    assert( s.value(e20) == l_Undef );
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(lazy02);
+
+  // failures on a lazy domain must be explained by its bounds
+  void lazy03()
+  {
+    Solver s;
+    cspvar x = s.newLazyCSPVar(1, 10);
+
+    s.newDecisionLevel();
+    x.setmax(s, 5, NO_REASON);
+    assert( !s.propagate() );
+    vec<Lit> ps;
+    Clause *c = x.setminf(s, 7, ps);
+    assert( c );
+    assert( c->size() == 1 );
+    assert( (*c)[0] == ~Lit(x.leqi(s, 6)) );
+    assert( s.value( (*c)[0] ) == l_False );
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(lazy03);
+
+  void lazy04()
+  {
+    Solver s;
+    s.lazy_threshold = 0;
+    cspvar x = s.newCSPVar(1, 5), y = s.newCSPVar(1, 5);
+    assert( s.cspvarlazy(x) );
+    post_less(s, x, y, 0);
+    post_neq(s, x, y, -1);
+    assert_num_solutions(s, 6);
+  }
+  REGISTER_TEST(lazy04);
+
+  // the cardinality of a set var is lazy here
+  void lazy05()
+  {
+    Solver s;
+    s.lazy_threshold = 0;
+    s.newSetVar(1, 3);
+    assert_num_solutions(s, 8);
+  }
+  REGISTER_TEST(lazy05);
+
   //--------------------------------------------------
   // clause reduction tests
   void reduce01()
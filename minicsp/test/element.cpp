@@ -197,6 +197,98 @@ namespace {
     assert( !s.propagate() );
   }
   REGISTER_TEST(element09);
+
+  // array of constants: prune values of R with no index left and
+  // indices whose value is not in R
+  void element10()
+  {
+    Solver s;
+    cspvar R = s.newCSPVar(0, 10);
+    cspvar I = s.newCSPVar(0, 5);
+    vector<int> c{3, 7, 3, 5, 9, 7};
+    post_element(s, R, I, c);
+    assert( !s.propagate() );
+    assert( R.min(s) == 3 && R.max(s) == 9 );
+    assert( !R.indomain(s, 4) && !R.indomain(s, 6) && !R.indomain(s, 8) );
+
+    s.newDecisionLevel();
+    I.remove(s, 0, NO_REASON);
+    assert( !s.propagate() );
+    assert( R.indomain(s, 3) );
+    I.remove(s, 2, NO_REASON);
+    assert( !s.propagate() );
+    assert( !R.indomain(s, 3) );
+    R.remove(s, 7, NO_REASON);
+    assert( !s.propagate() );
+    assert( I.min(s) == 3 && I.max(s) == 4 );
+    s.cancelUntil(0);
+  }
+  REGISTER_TEST(element10);
+
+  // search learns from the explanations, counted by brute force, for
+  // the global constraint and the decomposition
+  void element11()
+  {
+    int lo[] = {0, 1, 2, 0}, hi[] = {2, 3, 2, 1};
+    int ns = 0;
+    for(int x0 = lo[0]; x0 <= hi[0]; ++x0)
+      for(int x1 = lo[1]; x1 <= hi[1]; ++x1)
+        for(int x2 = lo[2]; x2 <= hi[2]; ++x2)
+          for(int x3 = lo[3]; x3 <= hi[3]; ++x3) {
+            int x[] = {x0, x1, x2, x3};
+            for(int i = 1; i <= 4; ++i)
+              if( x[i-1] >= 1 && x[i-1] <= 3 ) ++ns;
+          }
+    for(int decomp = 0; decomp != 2; ++decomp) {
+      Solver s;
+      s.debugclauses = 1;
+      cspvar R = s.newCSPVar(1, 3);
+      cspvar I = s.newCSPVar(0, 5);
+      vector<cspvar> X;
+      for(int i = 0; i != 4; ++i)
+        X.push_back(s.newCSPVar(lo[i], hi[i]));
+      post_element(s, R, I, X, 1, decomp);
+      assert_num_solutions(s, ns);
+    }
+  }
+  REGISTER_TEST(element11);
+
+  // lazy vars change bounds without x != d events
+  void element12()
+  {
+    int ns = 0;
+    for(int x0 = 0; x0 <= 3; ++x0)
+      for(int x1 = 0; x1 <= 3; ++x1)
+        for(int x2 = 0; x2 <= 3; ++x2) {
+          int x[] = {x0, x1, x2};
+          for(int i = 0; i != 3; ++i)
+            if( x[i] >= 1 && x[i] <= 2 ) ++ns;
+        }
+    Solver s;
+    s.debugclauses = 1;
+    cspvar R = s.newLazyCSPVar(1, 2);
+    cspvar I = s.newLazyCSPVar(0, 2);
+    vector<cspvar> X;
+    for(int i = 0; i != 3; ++i)
+      X.push_back(s.newLazyCSPVar(0, 3));
+    post_element(s, R, I, X);
+    assert_num_solutions(s, ns);
+  }
+  REGISTER_TEST(element12);
+
+  // the cost of posting must not depend on the gaps between the
+  // values of c: this used to remove 1.5e9 values from R
+  void element13()
+  {
+    Solver s;
+    cspvar R = s.newCSPVar(0, 10);
+    cspvar I = s.newCSPVar(0, 1);
+    vector<int> c{0, 1500000000};
+    post_element(s, R, I, c, 0);
+    assert(R.min(s) == 0 && R.max(s) == 0);
+    assert(I.min(s) == 0 && I.max(s) == 0);
+  }
+  REGISTER_TEST(element13);
 }
 
 void element_test()
@@ -0,0 +1,230 @@
+/*************************************************************************
+minicsp
+
+Copyright 2010--2011 George Katsirelos
+
+Minicsp is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Minicsp is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+#include "minicsp/core/solver.hpp"
+#include "minicsp/core/cons.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+namespace {
+  // a random instance: domains in [0, d), possibly with holes, and
+  // bounds for some of the values
+  struct instance {
+    int n, d;
+    bool holes;
+    vector< vector<bool> > dom;
+    vector<int> vals, lb, ub;
+
+    instance(int pn, int pd, bool pholes) :
+      n(pn), d(pd), holes(pholes), dom(n, vector<bool>(d, true))
+    {
+      for(int i = 0; holes && i != n; ++i)
+        for(int v = 0; v != d; ++v)
+          if( rand() % 5 == 0 ) dom[i][v] = false;
+      for(int i = 0; i != n; ++i)
+        dom[i][rand() % d] = true;
+      for(int v = 0; v != d; ++v) {
+        if( rand() % 4 == 0 ) continue;
+        vals.push_back(v);
+        lb.push_back(rand() % 2);
+        ub.push_back(lb.back() + rand() % 3);
+      }
+    }
+
+    // are the counts of a within the bounds
+    bool check(vector<int> const& a) const {
+      for(size_t j = 0; j != vals.size(); ++j) {
+        int c = 0;
+        for(int i = 0; i != n; ++i)
+          c += a[i] == vals[j];
+        if( c < lb[j] || c > ub[j] ) return false;
+      }
+      return true;
+    }
+
+    // the solutions, over the domains or over their bounds
+    vector< vector<int> > solutions(bool intervals) const {
+      vector<int> lo(n, d), hi(n, -1);
+      for(int i = 0; i != n; ++i)
+        for(int v = 0; v != d; ++v)
+          if( dom[i][v] ) {
+            lo[i] = std::min(lo[i], v);
+            hi[i] = std::max(hi[i], v);
+          }
+      vector< vector<int> > sols;
+      for(int i = 0; i != n; ++i)
+        if( lo[i] > hi[i] ) return sols;
+      vector<int> a(lo);
+      for(;;) {
+        bool ok = true;
+        for(int i = 0; i != n && ok; ++i)
+          ok = intervals || dom[i][a[i]];
+        if( ok && check(a) ) sols.push_back(a);
+        int i = 0;
+        while( i != n && a[i] == hi[i] ) { a[i] = lo[i]; ++i; }
+        if( i == n ) break;
+        ++a[i];
+        if( !intervals )
+          while( a[i] < hi[i] && !dom[i][a[i]] ) ++a[i];
+      }
+      return sols;
+    }
+
+    // the removals happen at the root, where the clause checker does
+    // not see them, so only check clauses over interval domains
+    vector<cspvar> post_vars(Solver &s, bool lazy) const {
+      s.debugclauses = !holes;
+      vector<cspvar> x;
+      for(int i = 0; i != n; ++i) {
+        x.push_back(lazy ? s.newLazyCSPVar(0, d-1) : s.newCSPVar(0, d-1));
+        for(int v = 0; v != d; ++v)
+          if( !dom[i][v] )
+            x[i].remove(s, v, NO_REASON);
+      }
+      return x;
+    }
+  };
+
+  void gcc01()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(4, 0, 2);
+    vector<int> vals = {0, 1}, lb = {2, 0}, ub = {2, 1};
+    post_gcc(s, x, vals, lb, ub, CONSISTENCY_DOMAIN);
+    assert( !s.propagate() );
+
+    s.newDecisionLevel();
+    x[0].remove(s, 0, NO_REASON);
+    x[1].remove(s, 0, NO_REASON);
+    assert( !s.propagate() );
+    for(int i = 2; i != 4; ++i)
+      assert( x[i].min(s) == 0 && x[i].max(s) == 0 );
+    s.cancelUntil(0);
+    assert( x[2].max(s) == 2 );
+  }
+  REGISTER_TEST(gcc01);
+
+  // bounds consistency prunes a large domain past a Hall interval
+  void gcc02()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 1, 3);
+    x.push_back(s.newCSPVar(1, 1000));
+    vector<int> vals = {1, 2, 3}, lb = {0, 0, 0}, ub = {1, 1, 1};
+    post_gcc(s, x, vals, lb, ub);
+    assert( !s.propagate() );
+    assert( x[3].min(s) == 4 );
+  }
+  REGISTER_TEST(gcc02);
+
+  // random instances, domain or bounds consistency, eager or lazy,
+  // with learning. Also checks the consistency at the root
+  void gcc_random(consistency c)
+  {
+    srand(c == CONSISTENCY_DOMAIN ? 59 : 61);
+    for(int iter = 0; iter != 80; ++iter) {
+      instance in(2 + iter % 4, 2 + iter % 3, iter / 12 % 2);
+      bool bounds = c == CONSISTENCY_BOUNDS;
+      int ns = in.solutions(false).size();
+      vector< vector<int> > support = in.solutions(bounds);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        vector<cspvar> x = in.post_vars(s, lazy);
+        bool unsat = false;
+        try {
+          post_gcc(s, x, in.vals, in.lb, in.ub, c);
+          unsat = s.propagate() != 0L;
+        } catch( minicsp::unsat& ) {
+          unsat = true;
+        }
+        if( unsat ) {
+          // bounds reasoning interleaved with the holes can fail
+          // even when the relaxation to intervals is satisfiable
+          assert( bounds || support.empty() );
+          assert( ns == 0 );
+          continue;
+        }
+        for(int i = 0; i != in.n; ++i)
+          for(int v = x[i].min(s); v <= x[i].max(s); ++v) {
+            if( bounds && v != x[i].min(s) && v != x[i].max(s) ) continue;
+            if( !x[i].indomain(s, v) ) continue;
+            bool supported = false;
+            for(size_t k = 0; k != support.size() && !supported; ++k)
+              supported = support[k][i] == v;
+            assert( supported );
+          }
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+
+  void gcc03()
+  {
+    gcc_random(CONSISTENCY_DOMAIN);
+  }
+  REGISTER_TEST(gcc03);
+
+  void gcc04()
+  {
+    gcc_random(CONSISTENCY_BOUNDS);
+  }
+  REGISTER_TEST(gcc04);
+
+  // cardinality vars, whose domains are the bounds. Each solution of
+  // x fixes them
+  void gcc05()
+  {
+    srand(67);
+    for(int iter = 0; iter != 80; ++iter) {
+      instance in(2 + iter % 4, 2 + iter % 3, iter / 12 % 2);
+      int ns = in.solutions(false).size();
+      for(int lazy = 0; lazy != 4; ++lazy) {
+        Solver s;
+        vector<cspvar> x = in.post_vars(s, lazy % 2);
+        vector<cspvar> card;
+        for(size_t j = 0; j != in.vals.size(); ++j)
+          card.push_back(s.newCSPVar(in.lb[j], in.ub[j]));
+        bool unsat = false;
+        try {
+          post_gcc(s, x, in.vals, card,
+                   lazy / 2 ? CONSISTENCY_BOUNDS : CONSISTENCY_DOMAIN);
+        } catch( minicsp::unsat& ) {
+          unsat = true;
+        }
+        if( unsat )
+          assert( ns == 0 );
+        else
+          assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(gcc05);
+}
+
+void gcc_test()
+{
+  cerr << "gcc tests\n";
+  the_test_container().run();
+}
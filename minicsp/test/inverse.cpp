@@ -0,0 +1,278 @@
+/*************************************************************************
+minicsp
+
+Copyright 2010--2011 George Katsirelos
+
+Minicsp is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Minicsp is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+#include "minicsp/core/solver.hpp"
+#include "minicsp/core/cons.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+namespace {
+  // advance a over the domains, false after the last one
+  bool next_tuple(vector<int>& a, vector< vector<bool> > const& dom)
+  {
+    for(size_t i = 0; i != a.size(); ++i) {
+      do ++a[i]; while( a[i] != (int)dom[i].size() && !dom[i][a[i]] );
+      if( a[i] != (int)dom[i].size() ) return true;
+      a[i] = 0;
+      while( !dom[i][a[i]] ) ++a[i];
+    }
+    return false;
+  }
+
+  bool first_tuple(vector<int>& a, vector< vector<bool> > const& dom)
+  {
+    a.assign(dom.size(), 0);
+    for(size_t i = 0; i != a.size(); ++i) {
+      while( a[i] != (int)dom[i].size() && !dom[i][a[i]] ) ++a[i];
+      if( a[i] == (int)dom[i].size() ) return false;
+    }
+    return true;
+  }
+
+  // the number of solutions of inverse over the domains, with n <= m
+  int count_inverse(vector< vector<bool> > const& xdom,
+                    vector< vector<bool> > const& ydom)
+  {
+    size_t n = xdom.size(), m = ydom.size();
+    vector<int> a, b;
+    if( !first_tuple(a, xdom) || !first_tuple(b, ydom) ) return 0;
+    int ns = 0;
+    do {
+      do {
+        bool ok = true;
+        for(size_t i = 0; i != n && ok; ++i)
+          ok = b[a[i]] == (int)i;
+        for(size_t j = 0; j != m && ok; ++j)
+          ok = n < m || a[b[j]] == (int)j;
+        ns += ok;
+      } while( next_tuple(b, ydom) );
+    } while( next_tuple(a, xdom) );
+    return ns;
+  }
+
+  vector< vector<bool> > random_domains(int n, int d, bool holes)
+  {
+    vector< vector<bool> > dom(n, vector<bool>(d, true));
+    for(int i = 0; holes && i != n; ++i)
+      for(int v = 0; v != d; ++v)
+        if( rand() % 3 == 0 ) dom[i][v] = false;
+    for(int i = 0; i != n; ++i)
+      dom[i][rand() % d] = true;
+    return dom;
+  }
+
+  // the domains are shifted by offset. The removals happen at the
+  // root, where the clause checker does not see them, so only check
+  // clauses over full domains
+  vector<cspvar> post_vars(Solver &s, vector< vector<bool> > const& dom,
+                           int offset, bool lazy)
+  {
+    vector<cspvar> x;
+    for(size_t i = 0; i != dom.size(); ++i) {
+      int d = dom[i].size();
+      x.push_back(lazy ? s.newLazyCSPVar(offset, offset+d-1)
+                  : s.newCSPVar(offset, offset+d-1));
+      for(int v = 0; v != d; ++v)
+        if( !dom[i][v] ) {
+          s.debugclauses = false;
+          x[i].remove(s, v+offset, NO_REASON);
+        }
+    }
+    return x;
+  }
+
+  void inverse01()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 1, 3);
+    vector<cspvar> y = s.newCSPVarArray(3, 0, 2);
+    post_inverse(s, x, y, 0, 1);
+    x[0].remove(s, 2, NO_REASON);
+    assert( !s.propagate() );
+    assert( !y[1].indomain(s, 0) );
+
+    s.newDecisionLevel();
+    y[2].assign(s, 1, NO_REASON);
+    assert( !s.propagate() );
+    assert( x[1].min(s) == 3 && x[1].max(s) == 3 );
+    assert( !x[0].indomain(s, 3) && !x[2].indomain(s, 3) );
+    assert( x[0].min(s) == 1 && x[0].max(s) == 1 );
+    assert( y[0].min(s) == 0 && y[0].max(s) == 0 );
+    s.cancelUntil(0);
+    assert( x[1].max(s) == 3 && x[1].min(s) == 1 );
+  }
+  REGISTER_TEST(inverse01);
+
+  // a lazy var loses the values below its lower bound without an
+  // event for each
+  void inverse02()
+  {
+    Solver s;
+    vector<cspvar> x, y;
+    for(int i = 0; i != 4; ++i) {
+      x.push_back(s.newLazyCSPVar(0, 3));
+      y.push_back(s.newLazyCSPVar(0, 3));
+    }
+    post_inverse(s, x, y);
+    s.newDecisionLevel();
+    x[1].setmin(s, 3, NO_REASON);
+    assert( !s.propagate() );
+    for(int j = 0; j != 3; ++j)
+      assert( !y[j].indomain(s, 1) );
+    assert( y[3].min(s) == 1 && y[3].max(s) == 1 );
+    s.cancelUntil(0);
+    assert( y[0].indomain(s, 1) );
+  }
+  REGISTER_TEST(inverse02);
+
+  // random domains, with offsets, x as long as y or shorter
+  void inverse_random(bool partial)
+  {
+    srand(partial ? 97 : 89);
+    for(int iter = 0; iter != 100; ++iter) {
+      int n = 1 + iter % 3 + !partial, m = n + partial;
+      bool holes = iter / 10 % 2;
+      // if partial, y may also take a value that is not an index of x
+      vector< vector<bool> > xdom = random_domains(n, m, holes),
+        ydom = random_domains(m, n + partial, holes);
+      int ns = count_inverse(xdom, ydom);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = true;
+        vector<cspvar> x = post_vars(s, xdom, 2, lazy),
+          y = post_vars(s, ydom, -1, lazy);
+        try {
+          post_inverse(s, x, y, -1, 2);
+        } catch( minicsp::unsat& ) {
+          assert( ns == 0 );
+          continue;
+        }
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+
+  void inverse03()
+  {
+    inverse_random(false);
+  }
+  REGISTER_TEST(inverse03);
+
+  void inverse04()
+  {
+    inverse_random(true);
+  }
+  REGISTER_TEST(inverse04);
+
+  // x shorter than y: y[j] is only constrained if some x[i] = j, and
+  // may take values that are not indices of x
+  void inverse06()
+  {
+    Solver s;
+    s.debugclauses = true;
+    vector<cspvar> x = s.newCSPVarArray(1, 0, 1);
+    vector<cspvar> y = s.newCSPVarArray(2, 0, 2);
+    post_inverse(s, x, y);
+    assert( y[0].max(s) == 2 && y[1].max(s) == 2 );
+    assert_num_solutions(s, 6);
+  }
+  REGISTER_TEST(inverse06);
+
+  // the same vars on both sides: an involution
+  void inverse05()
+  {
+    for(int n = 1; n != 6; ++n) {
+      Solver s;
+      s.debugclauses = true;
+      vector<cspvar> x = s.newCSPVarArray(n, 1, n);
+      post_inverse(s, x, x, 1, 1);
+      // the involutions of n elements
+      int ns[] = {0, 1, 2, 4, 10, 26};
+      assert_num_solutions(s, ns[n]);
+    }
+  }
+  REGISTER_TEST(inverse05);
+
+  void channel01()
+  {
+    Solver s;
+    vector<cspvar> b = s.newCSPVarArray(4, 0, 1);
+    cspvar x = s.newCSPVar(0, 10);
+    post_channel(s, b, x, 1);
+    assert( x.min(s) == 1 && x.max(s) == 4 );
+    b[0].setmax(s, 0, NO_REASON);
+    assert( !s.propagate() );
+    assert( x.min(s) == 2 );
+
+    s.newDecisionLevel();
+    x.remove(s, 3, NO_REASON);
+    assert( !s.propagate() );
+    assert( b[2].max(s) == 0 );
+    b[3].setmin(s, 1, NO_REASON);
+    assert( !s.propagate() );
+    assert( x.min(s) == 4 && b[1].max(s) == 0 );
+    s.cancelUntil(0);
+    assert( b[2].max(s) == 1 );
+  }
+  REGISTER_TEST(channel01);
+
+  // random domains, eager or lazy
+  void channel02()
+  {
+    srand(101);
+    for(int iter = 0; iter != 100; ++iter) {
+      int n = 1 + iter % 5;
+      bool holes = iter / 10 % 2;
+      vector< vector<bool> > bdom = random_domains(n, 2, holes),
+        xdom = random_domains(1, n, holes);
+      int ns = 0;
+      for(int v = 0; v != n; ++v) {
+        bool ok = xdom[0][v];
+        for(int i = 0; i != n && ok; ++i)
+          ok = bdom[i][i == v];
+        ns += ok;
+      }
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = true;
+        vector<cspvar> b = post_vars(s, bdom, 0, false),
+          x = post_vars(s, xdom, 3, lazy);
+        try {
+          post_channel(s, b, x[0], 3);
+        } catch( minicsp::unsat& ) {
+          assert( ns == 0 );
+          continue;
+        }
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(channel02);
+}
+
+void inverse_test()
+{
+  cerr << "inverse tests\n";
+  the_test_container().run();
+}
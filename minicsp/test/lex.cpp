@@ -19,6 +19,7 @@ along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
 *************************************************************************/
 
 #include <iostream>
+#include <cstdlib>
 
 #include "minicsp/core/solver.hpp"
 #include "minicsp/core/cons.hpp"
@@ -88,6 +89,111 @@ namespace {
         s.cancelUntil(0);
     }
     REGISTER_TEST(lex_less01);
+
+  // random lex constraints over a pool of vars, some of which appear
+  // more than once, with holes in the domains. The solutions are
+  // counted by enumerating the assignments of the pool
+  void lex_random(bool strict)
+  {
+    srand(strict ? 41 : 43);
+    for(int iter = 0; iter != 100; ++iter) {
+      int n = 1 + iter % 4, d = 3, npool = n + 1 + rand() % n;
+      vector<int> xi(n), yi(n);
+      for(int i = 0; i != n; ++i) {
+        xi[i] = rand() % npool;
+        yi[i] = rand() % npool;
+      }
+      vector<int> hole(npool);
+      for(int j = 0; j != npool; ++j)
+        hole[j] = rand() % 3 ? -1 : rand() % d;
+
+      int ns = 0;
+      vector<int> a(npool, 0);
+      for(;;) {
+        bool ok = true;
+        for(int j = 0; j != npool; ++j)
+          ok = ok && a[j] != hole[j];
+        if( ok ) {
+          int i = 0;
+          while( i != n && a[xi[i]] == a[yi[i]] ) ++i;
+          if( i == n ? !strict : a[xi[i]] < a[yi[i]] )
+            ++ns;
+        }
+        int j = 0;
+        while( j != npool && ++a[j] == d )
+          a[j++] = 0;
+        if( j == npool ) break;
+      }
+
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = 1;
+        vector<cspvar> pool, x, y;
+        for(int j = 0; j != npool; ++j) {
+          pool.push_back(lazy ? s.newLazyCSPVar(0, d-1)
+                         : s.newCSPVar(0, d-1));
+          if( hole[j] >= 0 )
+            pool[j].remove(s, hole[j], NO_REASON);
+        }
+        for(int i = 0; i != n; ++i) {
+          x.push_back(pool[xi[i]]);
+          y.push_back(pool[yi[i]]);
+        }
+        bool unsat = false;
+        try {
+          if( strict )
+            post_lex_less(s, x, y);
+          else
+            post_lex_leq(s, x, y);
+        } catch( minicsp::unsat& ) {
+          unsat = true;
+        }
+        if( unsat )
+          assert( ns == 0 );
+        else
+          assert_num_solutions(s, ns);
+      }
+    }
+  }
+
+  void lex_leq02()
+  {
+    lex_random(false);
+  }
+  REGISTER_TEST(lex_leq02);
+
+  void lex_less02()
+  {
+    lex_random(true);
+  }
+  REGISTER_TEST(lex_less02);
+
+  // GAC: only x[alpha] and y[alpha] are pruned, and strictly when
+  // the rest cannot be ordered
+  void lex_leq03()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(4, 0, 3);
+    vector<cspvar> y = s.newCSPVarArray(4, 0, 3);
+    post_lex_leq(s, x, y);
+    assert( !s.propagate() );
+
+    s.newDecisionLevel();
+    x[0].assign(s, 1, NO_REASON);
+    y[0].assign(s, 1, NO_REASON);
+    x[2].setmin(s, 3, NO_REASON);
+    y[2].setmax(s, 3, NO_REASON);
+    x[3].setmin(s, 2, NO_REASON);
+    y[3].setmax(s, 1, NO_REASON);
+    assert( !s.propagate() );
+    assert( x[1].max(s) == 2 );
+    assert( y[1].min(s) == 1 );
+    assert( x[2].min(s) == 3 && y[2].min(s) == 0 );
+    s.cancelUntil(0);
+    assert( x[1].max(s) == 3 );
+    assert( y[1].min(s) == 0 );
+  }
+  REGISTER_TEST(lex_leq03);
 }
 
 
@@ -338,6 +338,60 @@ namespace {
   }
   REGISTER_TEST(test13);
 
+  /* 10^9*(x1 + x2 + x3) - 2*10^9 <= 0 overflows an int accumulator
+     at the upper bounds of x[i]. Only x1 + x2 + x3 <= 2 is allowed
+   */
+  void test14()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 0, 3);
+    vector<int> w(3, 1000000000);
+    post_lin_leq(s, x, w, -2000000000);
+    assert_num_solutions(s, 10);
+  }
+  REGISTER_TEST(test14);
+
+  /* with x[i] >= 2 the minimum of the lhs is 4*10^9 > 0, but an int
+     accumulator wraps around and misses the failure
+   */
+  void test15()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 2, 3);
+    vector<int> w(3, 1000000000);
+    bool failed = false;
+    try {
+      post_lin_leq(s, x, w, -2000000000);
+    } catch( unsat& ) {
+      failed = true;
+    }
+    assert(failed);
+  }
+  REGISTER_TEST(test15);
+
+  /* -4 <= 3*x1 - 2*x2 + 5*x3 - 4*x4 <= 4, counted by brute force.
+     Search learns from the deferred explanations of the pruning
+   */
+  void test16()
+  {
+    Solver s;
+    s.debugclauses = 1;
+    vector<cspvar> x = s.newCSPVarArray(4, -3, 3);
+    vector<int> w{3, -2, 5, -4}, w1{-3, 2, -5, 4};
+    post_lin_leq(s, x, w, -4);
+    post_lin_leq(s, x, w1, -4);
+    int ns = 0;
+    for(int x1 = -3; x1 <= 3; ++x1)
+      for(int x2 = -3; x2 <= 3; ++x2)
+        for(int x3 = -3; x3 <= 3; ++x3)
+          for(int x4 = -3; x4 <= 3; ++x4) {
+            int l = 3*x1 - 2*x2 + 5*x3 - 4*x4;
+            if( l >= -4 && l <= 4 ) ++ns;
+          }
+    assert_num_solutions(s, ns);
+  }
+  REGISTER_TEST(test16);
+
   /* SEND+MORE=MONEY */
   void test_money()
   {
@@ -30,6 +30,11 @@ void alldiff_test();
 void nvalue_test();
 void set_test();
 void lex_test();
+void cumulative_test();
+void table_test();
+void gcc_test();
+void circuit_test();
+void inverse_test();
 
 int main()
 {
@@ -45,5 +50,10 @@ int main()
   nvalue_test();
   set_test();
   lex_test();
+  cumulative_test();
+  table_test();
+  gcc_test();
+  circuit_test();
+  inverse_test();
   return 0;
 }
@@ -266,9 +266,6 @@ namespace {
    */
   void test09()
   {
-    // test disabled for now because the pb constraint does not do
-    // propagation
-#if 0
     Solver s;
     vector<cspvar> x = s.newCSPVarArray(2, 0, 1);
     cspvar b = s.newCSPVar(0, 1);
@@ -276,10 +273,56 @@ namespace {
     w[0] = 5;
     w[1] = 5;
     post_pb_right_imp_re(s, x, w, 0, b);
-#endif
+    assert(!s.propagate());
+    assert(b.min(s) == 1);
   }
   REGISTER_TEST(test09);
 
+  /* +100*a - 75*b - 75*c >= 0
+     ast: b
+     exp: a, -c
+  */
+  void test10()
+  {
+    Solver s;
+    vector<Var> v(3);
+    for(int i = 0; i != 3; ++i)
+      v[i] = s.newVar();
+
+    int weights[]={ 100, -75, -75 };
+    vector<int> w(weights, weights+3);
+    post_pb(s, v, w, 0);
+
+    s.newDecisionLevel();
+    s.enqueue(Lit(v[1]), 0L);
+    assert(!s.propagate());
+    assert(s.value(v[0]) == l_True);
+    assert(s.value(v[2]) == l_False);
+    s.cancelUntil(0);
+    assert(s.value(v[0]) == l_Undef);
+  }
+  REGISTER_TEST(test10);
+
+  // search with deferred explanations, counted by brute force
+  void test11()
+  {
+    Solver s;
+    const int n = 8;
+    vector<cspvar> x = s.newCSPVarArray(n, 0, 1);
+    vector<int> w{5, -3, 4, -2, 3, 1, -5, 2}, w1{-1, 4, -4, 2, 5, -3, 1, 3};
+    post_pb(s, x, w, 3);
+    post_pb(s, x, w1, 2);
+    int ns = 0;
+    for(int m = 0; m != (1<<n); ++m) {
+      int a = 0, b = 0;
+      for(int i = 0; i != n; ++i)
+        if( (m>>i)&1 ) { a += w[i]; b += w1[i]; }
+      if( a >= 3 && b >= 2 ) ++ns;
+    }
+    assert_num_solutions(s, ns);
+  }
+  REGISTER_TEST(test11);
+
   /* pbvar, unit weights, c = 0 */
   void pbvar01()
   {
@@ -398,6 +441,31 @@ namespace {
     s.cancelUntil(0);
   }
   REGISTER_TEST(pbvar05);
+
+  // search with deferred explanations, counted by brute force. The
+  // sums can go below the original min of rhs, which must not put the
+  // min in the reason either
+  void pbvar06()
+  {
+    Solver s;
+    s.debugclauses = 1;
+    const int n = 8;
+    vector<cspvar> x = s.newCSPVarArray(n, 0, 1);
+    vector<int> w{5, -3, 4, -2, 3, 1, -5, 2}, w1{-1, 4, -4, 2, 5, -3, 1, 3};
+    cspvar r = s.newCSPVar(-6, 6), r1 = s.newCSPVar(-6, 6);
+    post_pb(s, x, w, 0, r);
+    post_pb(s, x, w1, 0, r1);
+    post_leq(s, r, r1, -1);
+    int ns = 0;
+    for(int m = 0; m != (1<<n); ++m) {
+      int a = 0, b = 0;
+      for(int i = 0; i != n; ++i)
+        if( (m>>i)&1 ) { a += w[i]; b += w1[i]; }
+      if( a >= -6 && a <= 6 && b >= -6 && b <= 6 && a < b ) ++ns;
+    }
+    assert_num_solutions(s, ns);
+  }
+  REGISTER_TEST(pbvar06);
 }
 
 void pb_test()
@@ -19,6 +19,8 @@ along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
 *************************************************************************/
 
 #include <vector>
+#include <set>
+#include <cstdlib>
 #include <iostream>
 
 #include "minicsp/core/solver.hpp"
@@ -243,6 +245,126 @@ namespace {
       assert(X[6].indomain(s, 2));
   }
   REGISTER_TEST(regular03);
+
+  // regular03 with the MDD propagator
+  void regular04()
+  {
+      Solver s;
+      int da[][3] = {
+          {1, 1, 2},
+          {1, 2, 5},
+          {1, 0, 1},
+          {2, 1, 2},
+          {2, 2, 3},
+          {2, 0, 2},
+          {3, 1, 4},
+          {3, 2, 3},
+          {3, 0, 3},
+          {4, 1, 4},
+          {4, 2, 0},
+          {4, 0, 4},
+          {5, 1, 6},
+          {5, 2, 5},
+          {5, 0, 5},
+          {6, 1, 6},
+          {6, 2, 7},
+          {6, 0, 6},
+          {7, 1, 0},
+          {7, 2, 7},
+          {7, 0, 7},
+          {-1, -1, -1}
+      };
+
+      vector<transition> d;
+      set<int> f;
+      buildd(da, d);
+      for(int i = 1; i <= 7; ++i)
+          f.insert(i);
+      automaton a(d, 1, f);
+
+      vector<cspvar> X = s.newCSPVarArray(8, 0, 2);
+      X[0].assign(s, 1, NO_REASON);
+      X[4].assign(s, 1, NO_REASON);
+      X[6].assign(s, 2, NO_REASON);
+      post_regular(s, X, a, true, true);
+      assert(!s.propagate());
+
+      for(int i = 1; i <= 3; ++i)
+          assert( !X[i].indomain(s, 2) );
+      assert(X[5].indomain(s, 2));
+      assert(X[6].indomain(s, 2));
+  }
+  REGISTER_TEST(regular04);
+
+  // number of words of length n over 0..d-1 accepted by a
+  // (possibly non-deterministic) automaton
+  int count_words(vector<transition> const& d, int q0, set<int> const& f,
+                  int n, int nd)
+  {
+    int ns = 0;
+    vector<int> w(n, 0);
+    for(;;) {
+      set<int> q;
+      q.insert(q0);
+      for(int i = 0; i != n; ++i) {
+        set<int> next;
+        for(size_t j = 0; j != d.size(); ++j)
+          if( q.count(d[j].q0) && d[j].s == w[i] )
+            next.insert(d[j].q1);
+        q.swap(next);
+      }
+      for(set<int>::const_iterator i = q.begin(); i != q.end(); ++i)
+        if( f.count(*i) ) {
+          ++ns;
+          break;
+        }
+      int i = 0;
+      while( i != n && ++w[i] == nd )
+        w[i++] = 0;
+      if( i == n )
+        return ns;
+    }
+  }
+
+  // random automata with the MDD propagator, eager and lazy, with
+  // learning
+  void regular05()
+  {
+    srand(29);
+    for(int iter = 0; iter != 60; ++iter) {
+      int n = 3 + iter % 3, nd = 3, nq = 2 + rand() % 4;
+      vector<transition> d;
+      for(int q = 1; q <= nq; ++q)
+        for(int v = 0; v != nd; ++v)
+          if( rand() % 4 )
+            d.push_back(transition(q, v, 1 + rand() % nq));
+      set<int> f;
+      f.insert(1 + rand() % nq);
+      if( rand() % 2 )
+        f.insert(1 + rand() % nq);
+      automaton a(d, 1, f);
+      int ns = count_words(d, 1, f, n, nd);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = 1;
+        vector<cspvar> x;
+        for(int j = 0; j != n; ++j)
+          x.push_back(lazy ? s.newLazyCSPVar(0, nd-1)
+                      : s.newCSPVar(0, nd-1));
+        bool unsat = false;
+        try {
+          post_regular(s, x, a, true, true);
+        } catch( minicsp::unsat& ) {
+          unsat = true;
+        }
+        if( unsat )
+          assert( ns == 0 );
+        else
+          assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(regular05);
 }
 
 void regular_test()
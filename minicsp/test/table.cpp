@@ -0,0 +1,236 @@
+/*************************************************************************
+minicsp
+
+Copyright 2010--2011 George Katsirelos
+
+Minicsp is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Minicsp is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with minicsp.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+#include "minicsp/core/solver.hpp"
+#include "minicsp/core/cons.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+namespace {
+  // the number of assignments of n vars in [0, d) that match some
+  // tuple
+  int count_matches(vector< vector<int> > const& tuples, int n, int d)
+  {
+    vector<int> a(n, 0);
+    int count = 0;
+    for(;;) {
+      for(size_t i = 0; i != tuples.size(); ++i) {
+        bool match = true;
+        for(int j = 0; j != n && match; ++j)
+          match = tuples[i][j] == STAR_CONSTANT || tuples[i][j] == a[j];
+        if( match ) { ++count; break; }
+      }
+      int j = 0;
+      while( j != n && a[j] == d-1 ) a[j++] = 0;
+      if( j == n ) break;
+      ++a[j];
+    }
+    return count;
+  }
+
+  vector< vector<int> > random_tuples(int ntuples, int n, int d, int star)
+  {
+    vector< vector<int> > tuples(ntuples, vector<int>(n));
+    for(int i = 0; i != ntuples; ++i)
+      for(int j = 0; j != n; ++j)
+        tuples[i][j] = rand() % 100 < star ? STAR_CONSTANT : rand() % d;
+    return tuples;
+  }
+
+  // x0 in {1,2}, x1 loses 0 and 3
+  void table01()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 0, 3);
+    vector< vector<int> > tuples = {{1, 1, 0}, {2, 2, 1}, {1, 2, 3}};
+    post_positive_table(s, x, tuples, TABLE_CT);
+    s.propagate();
+    assert( x[0].min(s) == 1 && x[0].max(s) == 2 );
+    assert( x[1].min(s) == 1 && x[1].max(s) == 2 );
+    assert( !x[2].indomain(s, 2) );
+
+    s.newDecisionLevel();
+    x[2].remove(s, 1, NO_REASON);
+    s.propagate();
+    assert( x[0].min(s) == 1 && x[0].max(s) == 1 );
+
+    s.newDecisionLevel();
+    x[1].remove(s, 2, NO_REASON);
+    s.propagate();
+    assert( x[2].min(s) == 0 && x[2].max(s) == 0 );
+    s.cancelUntil(1);
+    assert( x[1].indomain(s, 2) && x[2].indomain(s, 3) );
+    s.cancelUntil(0);
+    assert( x[0].max(s) == 2 );
+  }
+  REGISTER_TEST(table01);
+
+  // a star supports every value
+  void table02()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(2, 0, 3);
+    vector< vector<int> > tuples = {{0, STAR_CONSTANT}, {STAR_CONSTANT, 1}};
+    post_positive_table(s, x, tuples, TABLE_CT);
+    s.propagate();
+    assert( x[0].min(s) == 0 && x[0].max(s) == 3 );
+
+    s.newDecisionLevel();
+    x[0].remove(s, 0, NO_REASON);
+    s.propagate();
+    assert( x[1].min(s) == 1 && x[1].max(s) == 1 );
+    s.cancelUntil(0);
+    assert_num_solutions(s, 7);
+  }
+  REGISTER_TEST(table02);
+
+  // no tuple survives the domains
+  void table03()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(2, 0, 3);
+    vector< vector<int> > tuples = {{4, 0}, {1, 5}};
+    MUST_BE_UNSAT(post_positive_table(s, x, tuples, TABLE_CT));
+  }
+  REGISTER_TEST(table03);
+
+  // random tables, eager and lazy, with learning
+  void table04()
+  {
+    srand(17);
+    for(int iter = 0; iter != 60; ++iter) {
+      int n = 3 + iter % 2, d = 4, ntuples = 10 + rand() % 140;
+      vector< vector<int> > tuples = random_tuples(ntuples, n, d, 10);
+      int ns = count_matches(tuples, n, d);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = 1;
+        vector<cspvar> x;
+        for(int j = 0; j != n; ++j)
+          x.push_back(lazy ? s.newLazyCSPVar(0, d-1) : s.newCSPVar(0, d-1));
+        post_positive_table(s, x, tuples, TABLE_CT);
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(table04);
+
+  // the same with the tables compiled into MDDs
+  void table05()
+  {
+    srand(19);
+    for(int iter = 0; iter != 60; ++iter) {
+      int n = 3 + iter % 2, d = 4, ntuples = 1 + rand() % 100;
+      vector< vector<int> > tuples = random_tuples(ntuples, n, d, 10);
+      int ns = count_matches(tuples, n, d);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = 1;
+        vector<cspvar> x;
+        for(int j = 0; j != n; ++j)
+          x.push_back(lazy ? s.newLazyCSPVar(0, d-1) : s.newCSPVar(0, d-1));
+        post_positive_table(s, x, tuples, TABLE_MDD);
+        assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(table05);
+
+  // x0 = 0 is forbidden with both values of x1
+  void negtable01()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(3, 0, 2);
+    vector< vector<int> > tuples = {{0, 0, 1}, {0, 1, 1}, {2, 2, 2}};
+    post_negative_table(s, x, tuples, TABLE_CT);
+    s.propagate();
+    assert( x[0].indomain(s, 0) );
+
+    s.newDecisionLevel();
+    x[1].setmax(s, 1, NO_REASON);
+    x[2].assign(s, 1, NO_REASON);
+    s.propagate();
+    assert( x[0].min(s) == 1 );
+    s.cancelUntil(0);
+    assert( x[0].min(s) == 0 );
+  }
+  REGISTER_TEST(negtable01);
+
+  // with stars, a tuple only prunes when the others are fixed
+  void negtable02()
+  {
+    Solver s;
+    vector<cspvar> x = s.newCSPVarArray(2, 0, 2);
+    vector< vector<int> > tuples = {{0, STAR_CONSTANT}, {1, 1}};
+    post_negative_table(s, x, tuples, TABLE_CT);
+    s.propagate();
+    assert( x[0].indomain(s, 0) );
+
+    s.newDecisionLevel();
+    x[1].assign(s, 1, NO_REASON);
+    s.propagate();
+    assert( x[0].min(s) == 2 );
+    s.cancelUntil(0);
+    assert_num_solutions(s, 5);
+  }
+  REGISTER_TEST(negtable02);
+
+  // random negative tables, eager and lazy, with learning
+  void negtable03()
+  {
+    srand(23);
+    for(int iter = 0; iter != 60; ++iter) {
+      int n = 2 + iter % 3, d = 3, ntuples = 5 + rand() % 20;
+      vector< vector<int> > tuples =
+        random_tuples(ntuples, n, d, iter % 2 ? 10 : 0);
+      int ns = 1;
+      for(int j = 0; j != n; ++j) ns *= d;
+      ns -= count_matches(tuples, n, d);
+      for(int lazy = 0; lazy != 2; ++lazy) {
+        Solver s;
+        s.debugclauses = 1;
+        vector<cspvar> x;
+        for(int j = 0; j != n; ++j)
+          x.push_back(lazy ? s.newLazyCSPVar(0, d-1) : s.newCSPVar(0, d-1));
+        bool unsat = false;
+        try {
+          post_negative_table(s, x, tuples, TABLE_CT);
+        } catch( minicsp::unsat& ) {
+          unsat = true;
+        }
+        if( unsat )
+          assert( ns == 0 );
+        else
+          assert_num_solutions(s, ns);
+      }
+    }
+  }
+  REGISTER_TEST(negtable03);
+}
+
+void table_test()
+{
+  the_test_container().run();
+}
@@ -294,7 +294,7 @@ namespace XCSP3Core {
         // ---------------------------- ALLDIFF ALLEQUAL ------------------------------------------
 
         void buildConstraintAlldifferent(string id, vector<XVariable *> &list) override {
-            post_alldiff(solver, xvars2cspvars(list));
+            post_alldiff(solver, xvars2cspvars(list), CONSISTENCY_AUTO);
         }
 
 
@@ -355,6 +355,49 @@ namespace XCSP3Core {
           }
         }
 
+        // ---------------------------- CARDINALITY ------------------------------------------
+
+        // closed: the vars only take the listed values
+        void closeCardinality(vector<cspvar> const &vars, vector<int> const &values) {
+            set<int> vals(values.begin(), values.end());
+            for(cspvar x : vars)
+                for(int v = x.min(solver), e = x.max(solver); v <= e; ++v)
+                    if(vals.find(v) == vals.end() && x.indomain(solver, v))
+                        x.remove(solver, v, NO_REASON);
+        }
+
+
+        void buildConstraintCardinality(string id, vector<XVariable *> &list, vector<int> values,
+                                        vector<int> &occurs, bool closed) override {
+            vector<cspvar> vars = xvars2cspvars(list);
+            if(closed)
+                closeCardinality(vars, values);
+            post_gcc(solver, vars, values, occurs, occurs);
+        }
+
+
+        void buildConstraintCardinality(string id, vector<XVariable *> &list, vector<int> values,
+                                        vector<XVariable *> &occurs, bool closed) override {
+            vector<cspvar> vars = xvars2cspvars(list);
+            if(closed)
+                closeCardinality(vars, values);
+            post_gcc(solver, vars, values, xvars2cspvars(occurs));
+        }
+
+
+        void buildConstraintCardinality(string id, vector<XVariable *> &list, vector<int> values,
+                                        vector<XInterval> &occurs, bool closed) override {
+            vector<cspvar> vars = xvars2cspvars(list);
+            if(closed)
+                closeCardinality(vars, values);
+            vector<int> lb, ub;
+            for(XInterval const &i : occurs) {
+                lb.push_back(i.min);
+                ub.push_back(i.max);
+            }
+            post_gcc(solver, vars, values, lb, ub);
+        }
+
         // ---------------------------- ORDERED ------------------------------------------
 
         void buildConstraintOrdered(string id, vector<XVariable *> &list, OrderType order) override {
@@ -584,79 +627,52 @@ namespace XCSP3Core {
             post_element(solver, tocspvars[value->id], tocspvars[index->id], xvars2cspvars(list), startIndex);
         }
 
+        // ---------------------------- CIRCUIT -------------------------------
+        // loops are allowed, and remove the node from the circuit
+        void buildConstraintCircuit(string id, vector<XVariable *> &list,
+                                    int startIndex) override {
+          post_subcircuit(solver, xvars2cspvars(list), startIndex);
+        }
+
+        void buildConstraintCircuit(string id, vector<XVariable *> &list,
+                                    int startIndex, int size) override {
+          postCircuitSize(xvars2cspvars(list), startIndex, constant(size));
+        }
+
+        void buildConstraintCircuit(string id, vector<XVariable *> &list,
+                                    int startIndex, XVariable *size) override {
+          postCircuitSize(xvars2cspvars(list), startIndex, tocspvars[size->id]);
+        }
+
+        // size is the number of nodes without a loop
+        void postCircuitSize(vector<cspvar> const &xs, int startIndex, cspvar size) {
+          post_subcircuit(solver, xs, startIndex);
+          vector<Var> loops;
+          for (size_t i = 0; i != xs.size(); ++i)
+            if (xs[i].indomain(solver, i + startIndex))
+              loops.push_back(xs[i].eqi(solver, i + startIndex));
+          vector<int> negcoeff(loops.size(), -1);
+          post_pb(solver, loops, negcoeff, xs.size(), size);
+        }
+
         // ---------------------------- CHANNEL -------------------------------
         void buildConstraintChannel(string id, vector<XVariable *> &list,
                                     int startIndex) override {
           auto vs = xvars2cspvars(list);
-
-          for (size_t i = 0; i != vs.size(); ++i) {
-            vs[i].setmin(solver, startIndex, NO_REASON);
-            vs[i].setmax(solver, vs.size() + startIndex, NO_REASON);
-            for (size_t j = 0; j != vs.size(); ++j) {
-              if (!vs[i].indomain(solver, j + startIndex))
-                continue;
-              else if (!vs[j].indomain(solver, i + startIndex))
-                vs[i].remove(solver, j, NO_REASON);
-              else {
-                solver.addClause(
-                    std::vector<Lit>({vs[i].r_eq(solver, j + startIndex),
-                                      vs[j].e_eq(solver, i + startIndex)}));
-              }
-            }
-          }
+          post_inverse(solver, vs, vs, startIndex, startIndex);
         }
 
         void buildConstraintChannel(string id, vector<XVariable *> &list1,
                                     int startIndex1, vector<XVariable *> &list2,
                                     int startIndex2) override {
-          auto xs = xvars2cspvars(list1);
-          auto ys = xvars2cspvars(list2);
-
-          for (size_t i = 0; i != xs.size(); ++i) {
-            xs[i].setmin(solver, startIndex2, NO_REASON);
-            xs[i].setmax(solver, ys.size() + startIndex2, NO_REASON);
-          }
-          for (size_t i = 0; i != ys.size(); ++i) {
-            ys[i].setmin(solver, startIndex2, NO_REASON);
-            ys[i].setmax(solver, xs.size() + startIndex1, NO_REASON);
-          }
-
-          for (size_t i = 0; i != xs.size(); ++i) {
-            for (size_t j = 0; j != ys.size(); ++j) {
-              if (!xs[i].indomain(solver, j + startIndex2))
-                continue;
-              else if (!ys[j].indomain(solver, i + startIndex1))
-                xs[i].remove(solver, j, NO_REASON);
-              else {
-                solver.addClause(
-                    std::vector<Lit>({xs[i].r_eq(solver, j + startIndex2),
-                                      ys[j].e_eq(solver, i + startIndex1)}));
-              }
-            }
-          }
+          post_inverse(solver, xvars2cspvars(list1), xvars2cspvars(list2),
+                       startIndex1, startIndex2);
         }
 
         void buildConstraintChannel(string id, vector<XVariable *> &list,
                                     int startIndex, XVariable *value) override {
-          auto bs = xvars2cspvars(list);
-          auto x = tocspvars[value->id];
-
-          x.setmin(solver, startIndex, NO_REASON);
-          x.setmax(solver, startIndex + bs.size(), NO_REASON);
-          for (size_t i = 0; i != bs.size(); ++i) {
-            if (!x.indomain(solver, i + startIndex))
-              bs[i].setmax(solver, 0, NO_REASON);
-            else if (bs[i].max(solver) == 0)
-              x.remove(solver, i + startIndex, NO_REASON);
-            else if (bs[i].min(solver) == 1)
-              x.assign(solver, i + startIndex, NO_REASON);
-            else {
-              solver.addClause(std::vector<Lit>{x.r_eq(solver, i + startIndex),
-                                                bs[i].e_eq(solver, 1)});
-              solver.addClause(std::vector<Lit>{x.r_neq(solver, i + startIndex),
-                                                bs[i].e_eq(solver, 0)});
-            }
-          }
+          post_channel(solver, xvars2cspvars(list), tocspvars[value->id],
+                       startIndex);
         }
 
         // ---------------------------- Instantiation -----------------------